@@ -0,0 +1,242 @@
+#include <cmath>
+#include "approximateTransformation.h"
+#include "crsRegistry.h"
+
+using std::vector;
+
+const size_t ApproximateGrid::maxDepth;
+const size_t ApproximateGrid::testPointCount;
+
+namespace
+{
+
+    double interpolate (const double* values, double u, double v)
+    {
+        return (1.0 - v)*((1.0 - u)*values[0] + u*values[1])
+             +        v *((1.0 - u)*values[2] + u*values[3]);
+    }
+
+}
+
+ApproximateGrid::ApproximateGrid (OGRSpatialReference* source,
+        OGRSpatialReference* target, const OGREnvelope& area, double maxError)
+    : _maxError (maxError),
+      _leafCount (0),
+      _exactLeafCount (0)
+{
+    Node root;
+    root.minX = area.MinX;
+    root.minY = area.MinY;
+    root.maxX = area.MaxX;
+    root.maxY = area.MaxY;
+    _nodes.push_back (root);
+    fit (0, 0, source, target);
+}
+
+void ApproximateGrid::fit (size_t node, size_t depth, OGRSpatialReference* source,
+        OGRSpatialReference* target)
+{
+    // the test lattice is transformed exactly, its corners are the corners
+    // of the piece
+    // -------------------------------------------------------------------
+    const size_t n = testPointCount;
+    const double minX = _nodes[node].minX;
+    const double minY = _nodes[node].minY;
+    const double width = _nodes[node].maxX - minX;
+    const double height = _nodes[node].maxY - minY;
+
+    vector<double> x (n*n);
+    vector<double> y (n*n);
+    for (size_t b = 0; b < n; ++b)
+        for (size_t a = 0; a < n; ++a)
+        {
+            x[b*n + a] = minX + width*a/(n - 1);
+            y[b*n + a] = minY + height*b/(n - 1);
+        }
+
+    _nodes[node].children = 0;
+    _nodes[node].exact = true;
+    try
+    {
+        CrsRegistry::instance ().transform (source, target, n*n, &x[0], &y[0]);
+    }
+    catch (CrsTransformationException&)
+    {
+        // e.g. beyond the valid area of a projection //
+        //---------------------------------------------//
+        _leafCount++;
+        _exactLeafCount++;
+        return;
+    }
+
+    const size_t corners[4] = {0, n - 1, (n - 1)*n, n*n - 1};
+    for (size_t k = 0; k < 4; ++k)
+    {
+        _nodes[node].x[k] = x[corners[k]];
+        _nodes[node].y[k] = y[corners[k]];
+    }
+
+    double error = 0.0;
+    for (size_t b = 0; b < n; ++b)
+        for (size_t a = 0; a < n; ++a)
+        {
+            const double u = (double) a/(n - 1);
+            const double v = (double) b/(n - 1);
+            error = std::max (error, hypot (
+                        interpolate (_nodes[node].x, u, v) - x[b*n + a],
+                        interpolate (_nodes[node].y, u, v) - y[b*n + a]));
+        }
+
+    if (error <= _maxError)
+    {
+        _nodes[node].exact = false;
+        _leafCount++;
+        return;
+    }
+    if (depth >= maxDepth)
+    {
+        _leafCount++;
+        _exactLeafCount++;
+        return;
+    }
+
+    // the children are lower left, lower right, upper left and upper right //
+    //-----------------------------------------------------------------------//
+    const size_t children = _nodes.size ();
+    _nodes[node].children = children;
+    const double middleX = minX + 0.5*width;
+    const double middleY = minY + 0.5*height;
+    for (size_t k = 0; k < 4; ++k)
+    {
+        Node child;
+        child.minX = k%2 == 0 ? minX : middleX;
+        child.maxX = k%2 == 0 ? middleX : minX + width;
+        child.minY = k/2 == 0 ? minY : middleY;
+        child.maxY = k/2 == 0 ? middleY : minY + height;
+        _nodes.push_back (child);
+    }
+    for (size_t k = 0; k < 4; ++k)
+        fit (children + k, depth + 1, source, target);
+}
+
+bool ApproximateGrid::transform (double& x, double& y) const
+{
+    const Node* node = &_nodes[0];
+    if (x < node->minX or x > node->maxX or y < node->minY or y > node->maxY)
+        return false;
+
+    while (node->children != 0)
+    {
+        const double middleX = 0.5*(node->minX + node->maxX);
+        const double middleY = 0.5*(node->minY + node->maxY);
+        node = &_nodes[node->children + (x < middleX ? 0 : 1) + (y < middleY ? 0 : 2)];
+    }
+    if (node->exact)
+        return false;
+
+    const double u = (x - node->minX)/(node->maxX - node->minX);
+    const double v = (y - node->minY)/(node->maxY - node->minY);
+    x = interpolate (node->x, u, v);
+    y = interpolate (node->y, u, v);
+    return true;
+}
+
+double ApproximateGrid::getMaxError () const
+{
+    return _maxError;
+}
+
+size_t ApproximateGrid::getLeafCount () const
+{
+    return _leafCount;
+}
+
+size_t ApproximateGrid::getExactLeafCount () const
+{
+    return _exactLeafCount;
+}
+
+ApproximateTransformation::ApproximateTransformation (const ApproximateGrid* grid,
+        OGRCoordinateTransformation* exact)
+    : _grid (grid),
+      _exact (exact)
+{}
+
+OGRSpatialReference* ApproximateTransformation::GetSourceCS ()
+{
+    return _exact->GetSourceCS ();
+}
+
+OGRSpatialReference* ApproximateTransformation::GetTargetCS ()
+{
+    return _exact->GetTargetCS ();
+}
+
+size_t ApproximateTransformation::approximate (int count, double* x, double* y, double* z)
+{
+    // the points the grid cannot transform are collected for the exact
+    // transformation
+    // -----------------------------------------------------------------
+    _exactIndices.clear ();
+    _exactX.clear ();
+    _exactY.clear ();
+    _exactZ.clear ();
+    for (int n = 0; n < count; ++n)
+        if (!_grid->transform (x[n], y[n]))
+        {
+            _exactIndices.push_back (n);
+            _exactX.push_back (x[n]);
+            _exactY.push_back (y[n]);
+            if (z) _exactZ.push_back (z[n]);
+        }
+    return _exactIndices.size ();
+}
+
+void ApproximateTransformation::scatter (size_t exactCount, double* x, double* y,
+        double* z) const
+{
+    for (size_t n = 0; n < exactCount; ++n)
+    {
+        x[_exactIndices[n]] = _exactX[n];
+        y[_exactIndices[n]] = _exactY[n];
+        if (z) z[_exactIndices[n]] = _exactZ[n];
+    }
+}
+
+int ApproximateTransformation::Transform (int count, double* x, double* y, double* z)
+{
+    if (!_grid)
+        return _exact->Transform (count, x, y, z);
+
+    const size_t exactCount = approximate (count, x, y, z);
+    if (exactCount == 0)
+        return TRUE;
+
+    int result = _exact->Transform (exactCount, &_exactX[0], &_exactY[0],
+            z ? &_exactZ[0] : NULL);
+    scatter (exactCount, x, y, z);
+    return result;
+}
+
+int ApproximateTransformation::TransformEx (int count, double* x, double* y, double* z,
+        int* success)
+{
+    if (!_grid)
+        return _exact->TransformEx (count, x, y, z, success);
+
+    const size_t exactCount = approximate (count, x, y, z);
+    if (success)
+        for (int n = 0; n < count; ++n)
+            success[n] = TRUE;
+    if (exactCount == 0)
+        return TRUE;
+
+    _exactSuccess.resize (exactCount);
+    int result = _exact->TransformEx (exactCount, &_exactX[0], &_exactY[0],
+            z ? &_exactZ[0] : NULL, &_exactSuccess[0]);
+    scatter (exactCount, x, y, z);
+    if (success)
+        for (size_t n = 0; n < exactCount; ++n)
+            success[_exactIndices[n]] = _exactSuccess[n];
+    return result;
+}
@@ -0,0 +1,140 @@
+#ifndef APPROXIMATETRANSFORMATION_H
+#define APPROXIMATETRANSFORMATION_H
+
+#include <vector>
+#include <ogr_core.h>
+#include <ogr_spatialref.h>
+
+/**
+ * @brief A piecewise bilinear fit of a transformation between two
+ *        coordinate systems
+ *
+ * The area is split into quarters recursively until the bilinear
+ * interpolation between the exactly transformed corners of every piece is
+ * within the maximum error. The error is checked on a lattice of test
+ * points in each piece. Pieces that still fail at the maximum depth, or
+ * that cannot be transformed, are left to the exact transformation.
+ *
+ * The fit is continuous across an edge shared by two pieces of the same
+ * depth only. Where a larger piece meets smaller ones, the corners of the
+ * smaller pieces are exact but the larger piece interpolates there, and
+ * a piece left to the exact transformation does not match its fitted
+ * neighbours either. The fit may jump across such an edge by up to about
+ * twice the maximum error. Every point is still looked up in exactly one
+ * piece, so a vertex shared by two polygons maps to the same point for
+ * both, but a polygon edge crossing a piece edge is not bent along with
+ * the fit.
+ *
+ * The fit is not changed after the constructor, so it can be shared by all
+ * threads.
+ */
+class ApproximateGrid
+{
+  private:
+    struct Node
+    {
+        double minX;
+        double minY;
+        double maxX;
+        double maxY;
+
+        // index of the first of four children, 0 for a leaf
+        size_t children;
+
+        // the leaf is not fitted, its points are transformed exactly
+        bool exact;
+
+        // the transformed corners, lower left, lower right, upper left and
+        // upper right
+        double x[4];
+        double y[4];
+    };
+
+    std::vector<Node> _nodes;
+    double            _maxError;
+    size_t            _leafCount;
+    size_t            _exactLeafCount;
+
+    void fit (size_t node, size_t depth, OGRSpatialReference* source,
+            OGRSpatialReference* target);
+
+  public:
+
+    /**
+     * @brief Maximum depth of the recursive split
+     */
+    static const size_t maxDepth = 12;
+
+    /**
+     * @brief Number of test points along each side of a piece, including
+     *        the corners
+     */
+    static const size_t testPointCount = 5;
+
+    /**
+     * @brief Fit the transformation on an area
+     *
+     * @param source   Coordinate system of the input
+     * @param target   Coordinate system of the output
+     * @param area     The fitted area in source coordinates
+     * @param maxError The largest distance from the exact result, in units
+     *                 of the target, e.g. metres
+     */
+    ApproximateGrid (OGRSpatialReference* source, OGRSpatialReference* target,
+            const OGREnvelope& area, double maxError);
+
+    /**
+     * @brief Transform a point in place
+     *
+     * @return false if the point is outside the fitted area or in a piece
+     *         left to the exact transformation, the point is not changed
+     */
+    bool transform (double& x, double& y) const;
+
+    double getMaxError () const;
+    size_t getLeafCount () const;
+
+    /**
+     * @brief The number of pieces left to the exact transformation
+     */
+    size_t getExactLeafCount () const;
+};
+
+/**
+ * @brief A coordinate transformation using an ApproximateGrid, with the
+ *        exact transformation as a fallback
+ *
+ * Like other OGRCoordinateTransformation objects it must not be shared
+ * between threads, create one per thread on the shared grid.
+ */
+class ApproximateTransformation : public OGRCoordinateTransformation
+{
+  private:
+    const ApproximateGrid*       _grid;
+    OGRCoordinateTransformation* _exact;
+    std::vector<int>             _exactIndices;
+    std::vector<double>          _exactX;
+    std::vector<double>          _exactY;
+    std::vector<double>          _exactZ;
+    std::vector<int>             _exactSuccess;
+
+    size_t approximate (int count, double* x, double* y, double* z);
+    void scatter (size_t exactCount, double* x, double* y, double* z) const;
+
+  public:
+
+    /**
+     * @param grid  The fit, NULL to transform all points exactly
+     * @param exact The exact transformation, not owned
+     */
+    ApproximateTransformation (const ApproximateGrid* grid,
+            OGRCoordinateTransformation* exact);
+
+    OGRSpatialReference* GetSourceCS ();
+    OGRSpatialReference* GetTargetCS ();
+    int Transform (int count, double* x, double* y, double* z = NULL);
+    int TransformEx (int count, double* x, double* y, double* z = NULL,
+            int* success = NULL);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include <boost/scoped_ptr.hpp>
+#include "asyncWriter.h"
+#include "stats.h"
+
+using namespace wrf;
+
+AsyncWriter::AsyncWriter (BandWriter& file)
+    : _file (file), _queue (writeQueueCapacity)
+{}
+
+AsyncWriter::~AsyncWriter ()
+{
+    OutputBand* band;
+    while (_queue.tryPop (band))
+        delete band;
+}
+
+bool AsyncWriter::submit (OutputBand* band)
+{
+    if (_queue.tryPush (band))
+        return true;
+
+    stats::ScopedTimer timer (stats::writeQueueFullTime);
+    if (_queue.push (band))
+        return true;
+    delete band;
+    return false;
+}
+
+void AsyncWriter::write (OutputBand* band)
+{
+    boost::scoped_ptr<OutputBand> owned (band);
+    stats::ScopedTimer timer (stats::writeTime);
+    _file.writeBand (*band);
+}
+
+void AsyncWriter::close ()
+{
+    _queue.close ();
+}
+
+void AsyncWriter::run ()
+{
+    // nothing is submitted after closing, so the queue is empty for good //
+    //---------------------------------------------------------------------//
+    OutputBand* band;
+    while (_queue.pop (band))
+        write (band);
+}
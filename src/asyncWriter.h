@@ -0,0 +1,68 @@
+#ifndef ASYNCWRITER_H
+#define ASYNCWRITER_H
+
+#include <boost/multi_array.hpp>
+#include "wrf.h"
+#include "threads.h"
+
+namespace wrf
+{
+
+    /**
+     * @brief Maximum number of bands waiting to be written
+     */
+    const size_t writeQueueCapacity = 256;
+
+    /**
+     * @brief Writes output bands to a file from a single thread
+     *
+     * Compute threads submit finished bands and continue, one writer thread
+     * calls run and is the only one writing to the file. The file may be
+     * the WRF file or a partial output of a window. Both sides sleep while
+     * they have to wait, see BlockingQueue.
+     *
+     * If run throws, the writer thread must call close, so that no compute
+     * thread waits for it any more; the bands left in the queue are deleted
+     * with the writer.
+     */
+    class AsyncWriter
+    {
+        private:
+            BandWriter&                _file;
+            BlockingQueue<OutputBand*> _queue;
+
+            AsyncWriter (const AsyncWriter&);
+            AsyncWriter& operator= (const AsyncWriter&);
+
+        public:
+            AsyncWriter (BandWriter& file);
+            ~AsyncWriter ();
+
+            /**
+             * @brief Queue a band, waits only while the queue is full
+             *
+             * @param band Band allocated with new, the writer deletes it
+             *
+             * @return false if the writer is closed, the band is deleted
+             */
+            bool submit (OutputBand* band);
+
+            /**
+             * @brief Write a band immediately and delete it
+             */
+            void write (OutputBand* band);
+
+            /**
+             * @brief No more bands will be submitted
+             */
+            void close ();
+
+            /**
+             * @brief Write the submitted bands until closed and empty
+             */
+            void run ();
+    };
+
+}
+
+#endif
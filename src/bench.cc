@@ -0,0 +1,673 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <getopt.h>
+#include <sys/time.h>
+#include <boost/multi_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <ogr_spatialref.h>
+#include <ogrsf_frmts.h>
+#include <ogr_geometry.h>
+
+#include "corine.h"
+#include "wrf.h"
+#include "clm.h"
+#include "usgs.h"
+#include "mappingMatrix.h"
+#include "crsRegistry.h"
+#include "geoRaster.h"
+#include "overlay.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+using namespace std;
+
+class BenchmarkInputException {};
+class BenchmarkRunException {};
+
+namespace
+{
+
+    /**
+     * @brief Keeps the compiler from dropping the benchmarked code
+     */
+    volatile double sink = 0.0;
+
+    int verbosity = 0;
+
+    struct Result
+    {
+        string name;
+        size_t threads;
+        size_t iterations;
+        double seconds;
+    };
+
+    double now ()
+    {
+        timeval time;
+        gettimeofday (&time, NULL);
+        return time.tv_sec + 1.0e-6*time.tv_usec;
+    }
+
+    /**
+     * @brief Time a benchmark as the best of several repetitions
+     *
+     * @param name        Name of the benchmark in the results
+     * @param benchmark   Functor running the given number of iterations
+     * @param iterations  Iterations of one repetition
+     * @param repetitions Number of repetitions
+     *
+     * @return The seconds of one iteration
+     */
+    template<typename Benchmark>
+    Result measure (string name, Benchmark& benchmark, size_t iterations, size_t repetitions)
+    {
+        Result result = {name, 1, iterations, HUGE_VAL};
+        for (size_t r = 0; r < repetitions; ++r)
+        {
+            double start = now ();
+            benchmark (iterations);
+            result.seconds = min (result.seconds, (now () - start)/iterations);
+        }
+        if (verbosity > 0)
+            cerr << name << ": " << result.seconds << " s" << endl;
+        return result;
+    }
+
+    // the microbenchmarks //
+    //---------------------//
+
+    struct FractionsAdd
+    {
+        void operator() (size_t iterations)
+        {
+            for (size_t n = 0; n < iterations; ++n)
+            {
+                Fractions fractions (corine::typeCount);
+                for (size_t type = 0; type < corine::typeCount; ++type)
+                    fractions.add (type, 1.0/corine::typeCount);
+                sink = sink + fractions.missing ();
+            }
+        }
+    };
+
+    struct Map2Clm
+    {
+        corine::CorineFractions fractions;
+
+        Map2Clm ()
+        {
+            for (size_t type = 0; type < corine::typeCount; ++type)
+                fractions.set (type, 1.0/corine::typeCount);
+        }
+
+        void operator() (size_t iterations)
+        {
+            for (size_t n = 0; n < iterations; ++n)
+                sink = sink + fractions.map2Clm ()[0];
+        }
+    };
+
+    struct MappingPlanes
+    {
+        size_t                        planeSize;
+        boost::multi_array<double, 2> source;
+        boost::multi_array<double, 2> target;
+
+        MappingPlanes (size_t planeSize)
+            : planeSize (planeSize),
+              source (boost::extents[corine::typeCount][planeSize]),
+              target (boost::extents[clm::typeCount][planeSize])
+        {
+            for (size_t k = 0; k < planeSize; ++k)
+                source[k%corine::typeCount][k] = 1.0;
+        }
+
+        void operator() (size_t iterations)
+        {
+            for (size_t n = 0; n < iterations; ++n)
+            {
+                corine::clmMapping ().apply (source.data (), planeSize, target.data ());
+                sink = sink + target[0][0];
+            }
+        }
+    };
+
+    struct GetPolygon
+    {
+        const GeoRaster& raster;
+
+        GetPolygon (const GeoRaster& raster) : raster (raster) {}
+
+        void operator() (size_t iterations)
+        {
+            for (size_t n = 0; n < iterations; ++n)
+            {
+                OGRGeometry* polygon = raster.getPolygon (
+                        n%raster.iSize (), (n/raster.iSize ())%raster.jSize ());
+                delete polygon;
+            }
+        }
+    };
+
+    struct Clip
+    {
+        boost::scoped_ptr<OGRGeometry> cell;
+        OGRPolygon                     feature;
+
+        /**
+         * @brief A star shaped polygon overlapping the middle cell
+         */
+        Clip (const GeoRaster& raster, size_t vertexCount)
+            : cell (raster.getPolygon (raster.iSize ()/2, raster.jSize ()/2))
+        {
+            OGREnvelope envelope;
+            cell->getEnvelope (&envelope);
+            double x = (envelope.MinX + envelope.MaxX)/2.0;
+            double y = (envelope.MinY + envelope.MaxY)/2.0;
+            double radius = 0.8*(envelope.MaxX - envelope.MinX);
+
+            OGRLinearRing* ring = new OGRLinearRing;
+            for (size_t k = 0; k < vertexCount; ++k)
+            {
+                double angle = 2.0*M_PI*k/vertexCount;
+                double r = radius*(1.0 + 0.3*sin (7.0*angle));
+                ring->addPoint (x + r*cos (angle), y + r*sin (angle));
+            }
+            ring->closeRings ();
+            feature.addRingDirectly (ring);
+        }
+
+        void operator() (size_t iterations)
+        {
+            for (size_t n = 0; n < iterations; ++n)
+            {
+                OGRGeometry* intersection = cell->Intersection (&feature);
+                sink = sink + overlay::getArea (intersection);
+                delete intersection;
+            }
+        }
+    };
+
+    const size_t bandSize = 16;
+
+    struct WrfRead
+    {
+        wrf::File& file;
+
+        WrfRead (wrf::File& file) : file (file) {}
+
+        void operator() (size_t iterations)
+        {
+            size_t bandCount = file.jSize ()/bandSize;
+            for (size_t n = 0; n < iterations; ++n)
+                sink = sink + file.getLandUseFractions (
+                        (n%bandCount)*bandSize, bandSize)[0][0][0];
+        }
+    };
+
+    struct WrfWrite
+    {
+        wrf::File&                   file;
+        boost::multi_array<float, 3> planes;
+
+        WrfWrite (wrf::File& file)
+            : file (file),
+              planes (boost::extents[clm::typeCount][bandSize][file.iSize ()])
+        {
+            std::fill (planes.data (), planes.data () + planes.num_elements (),
+                    1.0f/clm::typeCount);
+        }
+
+        void operator() (size_t iterations)
+        {
+            size_t bandCount = file.jSize ()/bandSize;
+            for (size_t n = 0; n < iterations; ++n)
+                file.writeClmPftTypeFractions ((n%bandCount)*bandSize, planes);
+        }
+    };
+
+    struct Mosaic
+    {
+        const wrf::File&             file;
+        size_t                       factor;
+        boost::multi_array<float, 2> highResData;
+
+        Mosaic (const wrf::File& file, size_t factor)
+            : file (file), factor (factor),
+              highResData (boost::extents[file.jSize ()*factor][file.iSize ()*factor])
+        {
+            for (size_t k = 0; k < highResData.num_elements (); ++k)
+                highResData.data ()[k] = k%factor;
+        }
+
+        void operator() (size_t iterations)
+        {
+            for (size_t n = 0; n < iterations; ++n)
+                sink = sink + file.mosaicArray (
+                        highResData, factor*factor, factor, factor)[0][0][0];
+        }
+    };
+
+    // the synthetic input //
+    //---------------------//
+
+    /**
+     * @brief Create a WRF file in USGS land use with every cell of one category
+     */
+    void createWrfFile (string fileName, size_t size, double dx)
+    {
+        NcFile file (fileName.c_str (), NcFile::Replace);
+        if (!file.is_valid ())
+            throw BenchmarkInputException ();
+
+        NcDim* time = file.add_dim ("Time");
+        NcDim* landCat = file.add_dim ("land_cat_stag", usgs::typeCount);
+        NcDim* southNorth = file.add_dim ("south_north", size);
+        NcDim* westEast = file.add_dim ("west_east", size);
+
+        file.add_att ("TRUELAT1", 30.0f);
+        file.add_att ("TRUELAT2", 60.0f);
+        file.add_att ("CEN_LAT", 50.0f);
+        file.add_att ("CEN_LON", 10.0f);
+        file.add_att ("DX", (float) dx);
+        file.add_att ("DY", (float) dx);
+        file.add_att ("MMINLU", "USGS");
+        file.add_att ("NUM_LAND_CAT", (int) usgs::typeCount);
+
+        NcVar* landUse = file.add_var ("LANDUSEF", ncFloat, time, landCat, southNorth, westEast);
+        vector<float> data (usgs::typeCount*size*size, 0.0f);
+        for (size_t j = 0; j < size; ++j)
+            for (size_t i = 0; i < size; ++i)
+                data[(((i + j)%usgs::typeCount)*size + j)*size + i] = 1.0f;
+        landUse->put (&data[0], 1, usgs::typeCount, size, size);
+    }
+
+    unsigned long hash (long a, long b, long c)
+    {
+        unsigned long h = 2166136261ul;
+        h = (h ^ a)*16777619ul;
+        h = (h ^ b)*16777619ul;
+        h = (h ^ c)*16777619ul;
+        return h ^ (h >> 13);
+    }
+
+    /**
+     * @brief Add the points of one tile edge, without its end point
+     *
+     * The wiggle perpendicular to the edge only depends on the edge, so the
+     * two tiles sharing it get exactly the same points and the tiling has
+     * neither gaps nor overlaps.
+     */
+    void addEdge (OGRLinearRing& ring, double x0, double y0, double x1, double y1,
+            bool reverse, unsigned long key, size_t vertexCount, double amplitude)
+    {
+        double phase = key%1000;
+        double nx = y0 - y1;
+        double ny = x1 - x0;
+        double length = sqrt (nx*nx + ny*ny);
+        nx /= length;
+        ny /= length;
+
+        for (size_t k = 0; k < vertexCount; ++k)
+        {
+            size_t m = reverse ? vertexCount - k : k;
+            double t = (double) m/vertexCount;
+            double offset = amplitude*sin (M_PI*t)*sin (5.0*t + phase);
+            ring.addPoint (x0 + t*(x1 - x0) + offset*nx, y0 + t*(y1 - y0) + offset*ny);
+        }
+    }
+
+    /**
+     * @brief Create one shape file per CORINE class covering the WRF domain
+     *        with wiggled square tiles in the CORINE coordinate system
+     */
+    void createCorineFiles (string directory, const wrf::File& wrf, double tileSize,
+            size_t edgeVertexCount)
+    {
+        OGRSpatialReference* laea = new OGRSpatialReference;
+        laea->importFromEPSG (3035);
+        OGRSpatialReference* corineCoordSys = CrsRegistry::instance ().intern (laea);
+        laea->Release ();
+
+        CornerLattice corners = wrf.getCornerLattice (corineCoordSys);
+        OGREnvelope extent;
+        extent.MinX = extent.MaxX = corners.getX (0, 0);
+        extent.MinY = extent.MaxY = corners.getY (0, 0);
+        for (size_t cj = 0; cj <= corners.jSize (); ++cj)
+            for (size_t ci = 0; ci <= corners.iSize (); ++ci)
+            {
+                extent.MinX = min (extent.MinX, corners.getX (ci, cj));
+                extent.MaxX = max (extent.MaxX, corners.getX (ci, cj));
+                extent.MinY = min (extent.MinY, corners.getY (ci, cj));
+                extent.MaxY = max (extent.MaxY, corners.getY (ci, cj));
+            }
+        long txFirst = (long) floor (extent.MinX/tileSize) - 1;
+        long txLast  = (long) ceil  (extent.MaxX/tileSize) + 1;
+        long tyFirst = (long) floor (extent.MinY/tileSize) - 1;
+        long tyLast  = (long) ceil  (extent.MaxY/tileSize) + 1;
+
+        OGRSFDriver* driver =
+            OGRSFDriverRegistrar::GetRegistrar ()->GetDriverByName ("ESRI Shapefile");
+        if (!driver)
+            throw BenchmarkInputException ();
+
+        vector<OGRDataSource*> sources (corine::typeCount);
+        vector<OGRLayer*> layers (corine::typeCount);
+        for (size_t type = 0; type < corine::typeCount; ++type)
+        {
+            string fileName = corine::getFileName (directory, type);
+            driver->DeleteDataSource (fileName.c_str ());
+            sources[type] = driver->CreateDataSource (fileName.c_str ());
+            if (!sources[type])
+                throw BenchmarkInputException ();
+            layers[type] = sources[type]->CreateLayer ("corine", corineCoordSys, wkbPolygon);
+            if (!layers[type])
+                throw BenchmarkInputException ();
+        }
+
+        double amplitude = 0.2*tileSize;
+        for (long ty = tyFirst; ty < tyLast; ++ty)
+            for (long tx = txFirst; tx < txLast; ++tx)
+            {
+                double x0 = tx*tileSize;
+                double x1 = x0 + tileSize;
+                double y0 = ty*tileSize;
+                double y1 = y0 + tileSize;
+
+                OGRLinearRing* ring = new OGRLinearRing;
+                addEdge (*ring, x0, y0, x1, y0, false, hash (0, tx, ty), edgeVertexCount, amplitude);
+                addEdge (*ring, x1, y0, x1, y1, false, hash (1, tx + 1, ty), edgeVertexCount, amplitude);
+                addEdge (*ring, x0, y1, x1, y1, true, hash (0, tx, ty + 1), edgeVertexCount, amplitude);
+                addEdge (*ring, x0, y0, x0, y1, true, hash (1, tx, ty), edgeVertexCount, amplitude);
+                ring->closeRings ();
+
+                OGRPolygon* polygon = new OGRPolygon;
+                polygon->addRingDirectly (ring);
+
+                size_t type = hash (2, tx, ty)%corine::typeCount;
+                OGRFeature* feature = OGRFeature::CreateFeature (layers[type]->GetLayerDefn ());
+                feature->SetGeometryDirectly (polygon);
+                if (layers[type]->CreateFeature (feature) != OGRERR_NONE)
+                    throw BenchmarkInputException ();
+                OGRFeature::DestroyFeature (feature);
+            }
+
+        for (size_t type = 0; type < corine::typeCount; ++type)
+            OGRDataSource::DestroyDataSource (sources[type]);
+    }
+
+    void copyFile (string source, string target)
+    {
+        ifstream in (source.c_str (), ios::binary);
+        ofstream out (target.c_str (), ios::binary);
+        if (!in or !out)
+            throw BenchmarkInputException ();
+        out << in.rdbuf ();
+    }
+
+    /**
+     * @brief Time one run of the program on the synthetic input
+     */
+    double runEndToEnd (string executable, string directory, string wrfTemplate,
+            size_t threads, size_t readerCount)
+    {
+        string wrfFileName = directory + "/wrfinput_run.nc";
+        copyFile (wrfTemplate, wrfFileName);
+
+        stringstream command;
+        command << "OMP_NUM_THREADS=" << threads << " " << executable
+                << " -c " << directory << " -w " << wrfFileName
+                << " -r " << readerCount << " > /dev/null";
+
+        double start = now ();
+        if (system (command.str ().c_str ()) != 0)
+            throw BenchmarkRunException ();
+        return now () - start;
+    }
+
+    // the results //
+    //-------------//
+
+    void writeJson (ostream& out, const vector<Result>& results)
+    {
+        out << "{" << endl
+            << "  \"package\": \"" << PACKAGE_STRING << "\"," << endl
+            << "  \"benchmarks\": [" << endl;
+        out << setprecision (9);
+        for (size_t n = 0; n < results.size (); ++n)
+        {
+            out << "    {\"name\": \"" << results[n].name << "\""
+                << ", \"threads\": " << results[n].threads
+                << ", \"iterations\": " << results[n].iterations
+                << ", \"seconds\": " << results[n].seconds << "}";
+            if (n + 1 < results.size ()) out << ",";
+            out << endl;
+        }
+        out << "  ]" << endl << "}" << endl;
+    }
+
+    /**
+     * @brief Compare the results with a baseline written by an earlier run
+     *
+     * @param threshold Allowed relative slow down, e.g. 0.1 for 10 %
+     *
+     * @return The number of benchmarks slower than allowed
+     */
+    size_t compare (const vector<Result>& results, string baselineFileName, double threshold)
+    {
+        boost::property_tree::ptree baseline;
+        boost::property_tree::read_json (baselineFileName, baseline);
+
+        map<string, double> baselineSeconds;
+        const boost::property_tree::ptree& benchmarks = baseline.get_child ("benchmarks");
+        for (boost::property_tree::ptree::const_iterator it = benchmarks.begin ();
+                it != benchmarks.end (); ++it)
+            baselineSeconds[it->second.get<string> ("name")] =
+                it->second.get<double> ("seconds");
+
+        size_t regressions = 0;
+        cerr << left << setw (28) << "benchmark" << right
+             << setw (14) << "baseline" << setw (14) << "current" << setw (10) << "ratio" << endl;
+        for (size_t n = 0; n < results.size (); ++n)
+        {
+            map<string, double>::const_iterator base = baselineSeconds.find (results[n].name);
+            if (base == baselineSeconds.end ())
+                continue;
+
+            double ratio = results[n].seconds/base->second;
+            bool regression = ratio > 1.0 + threshold;
+            if (regression) ++regressions;
+
+            cerr << left << setw (28) << results[n].name << right
+                 << setw (14) << base->second << setw (14) << results[n].seconds
+                 << setw (10) << setprecision (3) << ratio << setprecision (6)
+                 << (regression ? "  REGRESSION" : "") << endl;
+        }
+        return regressions;
+    }
+
+}
+
+int main (int argc, char ** argv)
+{
+    string directory ("bench_data");
+    string executable ("");
+    string outputFileName ("-");
+    string baselineFileName ("");
+    double threshold = 0.1;
+    size_t gridSize = 64;
+    size_t repetitions = 3;
+    size_t readerCount = 1;
+    size_t maxThreads = 1;
+#ifdef _OPENMP
+    maxThreads = omp_get_max_threads ();
+#endif
+
+    while (true)
+    {
+        static struct option long_options[] =
+        {
+            {"help",          no_argument,       0, 'h'},
+            {"verbose",       no_argument,       0, 'v'},
+            {"version",       no_argument,       0, 'V'},
+            {"directory",     required_argument, 0, 'd'},
+            {"executable",    required_argument, 0, 'x'},
+            {"output",        required_argument, 0, 'o'},
+            {"baseline",      required_argument, 0, 'b'},
+            {"threshold",     required_argument, 0, 't'},
+            {"gridSize",      required_argument, 0, 's'},
+            {"repetitions",   required_argument, 0, 'n'},
+            {"maxThreads",    required_argument, 0, 'T'},
+            {"readerThreads", required_argument, 0, 'r'},
+            {0,               0,                 0, 0  }
+        };
+
+        int option_index = 0;
+        int c = getopt_long (argc, argv, "hvVd:x:o:b:t:s:n:T:r:", long_options, &option_index);
+        if (c == -1) break;
+
+        switch (c)
+        {
+            case 'h':
+                cout << "usage: " << argv[0] << " [options]" << endl
+                     << "  -d, --directory DIR      synthetic input directory (bench_data)" << endl
+                     << "  -x, --executable FILE    corine2wrfClm for the end-to-end runs" << endl
+                     << "  -o, --output FILE        JSON results, - for stdout (-)" << endl
+                     << "  -b, --baseline FILE      JSON results to compare with" << endl
+                     << "  -t, --threshold VALUE    allowed relative slow down (0.1)" << endl
+                     << "  -s, --gridSize N         WRF grid of N x N cells (64)" << endl
+                     << "  -n, --repetitions N      repetitions of each benchmark (3)" << endl
+                     << "  -T, --maxThreads N       most threads of the end-to-end runs" << endl
+                     << "  -r, --readerThreads N    reader threads of the end-to-end runs (1)" << endl;
+                return EXIT_SUCCESS;
+            case 'v':
+                verbosity++;
+                break;
+            case 'V':
+                cout << PACKAGE_STRING << endl;
+                return EXIT_SUCCESS;
+            case 'd':
+                directory = string (optarg);
+                break;
+            case 'x':
+                executable = string (optarg);
+                break;
+            case 'o':
+                outputFileName = string (optarg);
+                break;
+            case 'b':
+                baselineFileName = string (optarg);
+                break;
+            case 't':
+                threshold = atof (optarg);
+                break;
+            case 's':
+                gridSize = atoi (optarg);
+                break;
+            case 'n':
+                repetitions = atoi (optarg);
+                break;
+            case 'T':
+                maxThreads = atoi (optarg);
+                break;
+            case 'r':
+                readerCount = atoi (optarg);
+                break;
+            case '?':
+                break;
+            default:
+                exit (EXIT_FAILURE);
+        }
+    }
+
+    if (gridSize < bandSize)
+        gridSize = bandSize;
+
+    // the synthetic input, a 1 km grid and CORINE tiles of 250 m //
+    //------------------------------------------------------------//
+    OGRRegisterAll ();
+    const double dx = 1000.0;
+    string wrfTemplate = directory + "/wrfinput_template.nc";
+    string wrfMicro = directory + "/wrfinput_micro.nc";
+    if (system (("mkdir -p " + directory).c_str ()) != 0)
+        throw BenchmarkInputException ();
+    createWrfFile (wrfTemplate, gridSize, dx);
+    copyFile (wrfTemplate, wrfMicro);
+
+    vector<Result> results;
+    {
+        wrf::File wrf (wrfMicro, wrf::File::Write);
+        if (!executable.empty ())
+            createCorineFiles (directory, wrf, dx/4.0, 8);
+
+        FractionsAdd fractionsAdd;
+        results.push_back (measure ("fractions_add", fractionsAdd, 100000, repetitions));
+        Map2Clm map2Clm;
+        results.push_back (measure ("corine_map2Clm", map2Clm, 100000, repetitions));
+        MappingPlanes mappingPlanes (bandSize*wrf.iSize ());
+        results.push_back (measure ("mappingMatrix_planes", mappingPlanes, 1000, repetitions));
+        GetPolygon getPolygon (wrf);
+        results.push_back (measure ("geoRaster_getPolygon", getPolygon, 100000, repetitions));
+        Clip clip (wrf, 256);
+        results.push_back (measure ("overlay_clip", clip, 2000, repetitions));
+        WrfRead wrfRead (wrf);
+        results.push_back (measure ("wrf_readLandUse", wrfRead, 100, repetitions));
+        WrfWrite wrfWrite (wrf);
+        results.push_back (measure ("wrf_writePftFractions", wrfWrite, 100, repetitions));
+        Mosaic mosaic (wrf, 3);
+        results.push_back (measure ("wrf_mosaicArray", mosaic, 20, repetitions));
+    }
+
+    // thread scaling of whole runs //
+    //------------------------------//
+    vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back (threads);
+    threadCounts.push_back (maxThreads);
+
+    if (!executable.empty ())
+        for (size_t n = 0; n < threadCounts.size (); ++n)
+        {
+            stringstream name;
+            name << "endToEnd_threads" << threadCounts[n];
+            Result result = {name.str (), threadCounts[n], 1, HUGE_VAL};
+            for (size_t r = 0; r < repetitions; ++r)
+                result.seconds = min (result.seconds, runEndToEnd (
+                            executable, directory, wrfTemplate, threadCounts[n], readerCount));
+            if (verbosity > 0)
+                cerr << result.name << ": " << result.seconds << " s" << endl;
+            results.push_back (result);
+        }
+
+    if (outputFileName == "-")
+        writeJson (cout, results);
+    else
+    {
+        ofstream out (outputFileName.c_str ());
+        writeJson (out, results);
+    }
+
+    if (!baselineFileName.empty ()
+            and compare (results, baselineFileName, threshold) > 0)
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,300 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <getopt.h>
+#include <boost/scoped_ptr.hpp>
+
+#include <ogrsf_frmts.h>
+
+#include "corine.h"
+#include "wrf.h"
+#include "overlay.h"
+#include "stats.h"
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+using namespace std;
+
+namespace
+{
+
+    /**
+     * @brief Differences of one quantity over all compared cells
+     */
+    struct Difference
+    {
+        double max;
+        double sum;
+        double squareSum;
+
+        Difference () : max (0.0), sum (0.0), squareSum (0.0) {}
+
+        void add (double difference)
+        {
+            difference = fabs (difference);
+            max = std::max (max, difference);
+            sum += difference;
+            squareSum += difference*difference;
+        }
+
+        double mean (size_t count) const
+        {
+            return count ? sum/count : 0.0;
+        }
+
+        double rms (size_t count) const
+        {
+            return count ? sqrt (squareSum/count) : 0.0;
+        }
+    };
+
+    double getMissing (const SparseFractions& cell)
+    {
+        double missing = 1.0;
+        for (size_t n = 0; n < cell.size (); ++n)
+            missing -= cell.getValue (n);
+        return missing;
+    }
+
+}
+
+int main (int argc, char ** argv)
+{
+    string wrfFileName ("wrfinput_d01");
+    string corineFileDirectory (".");
+    string engineName ("pipelined");
+    overlay::ReadOptions readOptions;
+    double simplifyFactor = 0.0;
+    size_t splitPointCount = 0;
+    double reprojectionError = 0.0;
+    size_t readerCount = 1;
+    size_t sampleCount = 0;
+    unsigned int seed = 1;
+    double maxError = 1.0e-3;
+    double rmsError = 1.0e-4;
+    bool verbose = false;
+
+    while (true)
+    {
+        static struct option long_options[] =
+        {
+            {"help",          no_argument,       0, 'h'},
+            {"verbose",       no_argument,       0, 'v'},
+            {"version",       no_argument,       0, 'V'},
+            {"corineFile",    required_argument, 0, 'c'},
+            {"wrfFile",       required_argument, 0, 'w'},
+            {"engine",        required_argument, 0, 'e'},
+            {"readerThreads", required_argument, 0, 'r'},
+            {"sample",        required_argument, 0, 'n'},
+            {"seed",          required_argument, 0, 'N'},
+            {"maxError",      required_argument, 0, 'M'},
+            {"rmsError",      required_argument, 0, 'R'},
+            {"reader",        required_argument, 0, 'f'},
+            {"simplify",      required_argument, 0, 'S'},
+            {"simplifyCache", required_argument, 0, 'C'},
+            {"split",         required_argument, 0, 'P'},
+            {"classAttribute", required_argument, 0, 'A'},
+            {"reprojectionError", required_argument, 0, 'E'},
+            {0,               0,                 0, 0  }
+        };
+
+        int option_index = 0;
+        int c = getopt_long (argc, argv, "hvVc:w:e:r:n:N:M:R:f:S:C:P:A:E:", long_options, &option_index);
+        if (c == -1) break;
+
+        switch (c)
+        {
+            case 'h':
+                cout << "usage: " << argv[0] << " [options]" << endl
+                     << "  -c, --corineFile DIR     directory of the CORINE shape files (.)" << endl
+                     << "  -w, --wrfFile FILE       WRF file defining the grid (wrfinput_d01)" << endl
+                     << "  -e, --engine NAME        engine checked against the reference," << endl
+                     << "                           pipelined or reverse (pipelined)" << endl
+                     << "  -r, --readerThreads N    reader threads of the engine (1)" << endl
+                     << "  -n, --sample N           compare N random cells, 0 for all (0)" << endl
+                     << "  -N, --seed N             seed of the random cells (1)" << endl
+                     << "  -M, --maxError VALUE     allowed maximum difference per class (1e-3)" << endl
+                     << "  -R, --rmsError VALUE     allowed RMS difference per class (1e-4)" << endl
+                     << "  -f, --reader NAME        shape file reader, ogr or mapped (mapped)" << endl
+                     << "  -S, --simplify FACTOR    simplify the polygons of the engine run with" << endl
+                     << "                           FACTOR times the cell size, 0 for none (0)" << endl
+                     << "  -C, --simplifyCache DIR  directory of the simplified polygons" << endl
+                     << "  -P, --split N            split polygons of the engine run with more" << endl
+                     << "                           than N points, 0 for none (0)" << endl
+                     << "  -A, --classAttribute NAME read all classes from the single layer of" << endl
+                     << "                           --corineFile, NAME holds the CORINE code" << endl
+                     << "  -E, --reprojectionError METRES  reproject the polygons of the engine" << endl
+                     << "                           run approximately, 0 for exact (0)" << endl;
+                return EXIT_SUCCESS;
+            case 'v':
+                verbose = true;
+                break;
+            case 'V':
+                cout << PACKAGE_STRING << endl;
+                return EXIT_SUCCESS;
+            case 'c':
+                corineFileDirectory = string (optarg);
+                break;
+            case 'w':
+                wrfFileName = string (optarg);
+                break;
+            case 'e':
+                engineName = string (optarg);
+                break;
+            case 'r':
+                readerCount = atoi (optarg);
+                break;
+            case 'n':
+                sampleCount = atoi (optarg);
+                break;
+            case 'N':
+                seed = atoi (optarg);
+                break;
+            case 'M':
+                maxError = atof (optarg);
+                break;
+            case 'R':
+                rmsError = atof (optarg);
+                break;
+            case 'f':
+                readOptions.reader = string (optarg);
+                break;
+            case 'S':
+                simplifyFactor = atof (optarg);
+                break;
+            case 'C':
+                readOptions.cacheDirectory = string (optarg);
+                break;
+            case 'P':
+                splitPointCount = atoi (optarg);
+                break;
+            case 'A':
+                readOptions.classAttribute = string (optarg);
+                break;
+            case 'E':
+                reprojectionError = atof (optarg);
+                break;
+            case '?':
+                break;
+            default:
+                exit (EXIT_FAILURE);
+        }
+    }
+
+    OGRRegisterAll ();
+    wrf::File wrf (wrfFileName, wrf::File::ReadOnly);
+
+    overlay::CellList cells = sampleCount > 0
+        ? overlay::getSampleCells (wrf.iSize (), wrf.jSize (), sampleCount, seed)
+        : overlay::getAllCells (wrf.iSize (), wrf.jSize ());
+
+    // run both engines on the same cells //
+    //------------------------------------//
+    overlay::ReferenceEngine reference;
+    boost::scoped_ptr<overlay::Engine> engine (
+            overlay::createEngine (engineName, readerCount));
+    engine->setMaxReprojectionError (reprojectionError);
+
+    overlay::FractionGrid referenceFractions (wrf.iSize (), wrf.jSize (), corine::typeCount);
+    double start = stats::now ();
+    overlay::addCorineFractions (reference, corineFileDirectory, wrf, cells,
+            referenceFractions, readOptions, verbose);
+    double referenceSeconds = stats::now () - start;
+
+    // the engine may run on simplified, split or approximately reprojected
+    // polygons, so the differences include the error of these steps
+    overlay::ReadOptions engineReadOptions = readOptions;
+    engineReadOptions.simplifyFactor = simplifyFactor;
+    engineReadOptions.splitPointCount = splitPointCount;
+
+    overlay::FractionGrid engineFractions (wrf.iSize (), wrf.jSize (), corine::typeCount);
+    start = stats::now ();
+    overlay::addCorineFractions (*engine, corineFileDirectory, wrf, cells,
+            engineFractions, engineReadOptions, verbose);
+    double engineSeconds = stats::now () - start;
+
+    // differences per class and of the missing fraction //
+    //---------------------------------------------------//
+    vector<Difference> differences (corine::typeCount);
+    Difference missingDifference;
+    Difference referenceMissing;
+    Difference engineMissing;
+
+    // simplified neighbours leave gaps, which add to the missing fraction,
+    // and overlap, which takes from it, see simplifyGeometry
+    // --------------------------------------------------------------------
+    Difference gaps;
+    Difference overlaps;
+    for (size_t n = 0; n < cells.size (); ++n)
+    {
+        const SparseFractions& a = referenceFractions (cells[n].i, cells[n].j);
+        const SparseFractions& b = engineFractions (cells[n].i, cells[n].j);
+        for (size_t type = 0; type < corine::typeCount; ++type)
+            differences[type].add (b[type] - a[type]);
+
+        const double missing = getMissing (b) - getMissing (a);
+        missingDifference.add (missing);
+        if (missing > 0.0)
+            gaps.add (missing);
+        else
+            overlaps.add (missing);
+        referenceMissing.add (getMissing (a));
+        engineMissing.add (getMissing (b));
+    }
+
+    size_t failures = 0;
+    const size_t count = cells.size ();
+    cout << "engine " << engine->getName () << " against " << reference.getName ()
+         << " on " << count << " cells" << endl
+         << setw (6) << "class" << setw (14) << "max" << setw (14) << "mean"
+         << setw (14) << "rms" << endl;
+    cout << scientific << setprecision (3);
+    for (size_t type = 0; type < corine::typeCount; ++type)
+    {
+        bool failed = differences[type].max > maxError
+                   or differences[type].rms (count) > rmsError;
+        if (failed) ++failures;
+        cout << setw (6) << type
+             << setw (14) << differences[type].max
+             << setw (14) << differences[type].mean (count)
+             << setw (14) << differences[type].rms (count)
+             << (failed ? "  FAILED" : "") << endl;
+    }
+
+    cout << "missing fraction" << setw (14) << "max" << setw (14) << "mean" << endl
+         << setw (16) << reference.getName ()
+         << setw (14) << referenceMissing.max
+         << setw (14) << referenceMissing.mean (count) << endl
+         << setw (16) << engine->getName ()
+         << setw (14) << engineMissing.max
+         << setw (14) << engineMissing.mean (count) << endl
+         << setw (16) << "difference"
+         << setw (14) << missingDifference.max
+         << setw (14) << missingDifference.mean (count) << endl
+         << setw (16) << "gaps"
+         << setw (14) << gaps.max
+         << setw (14) << gaps.mean (count) << endl
+         << setw (16) << "overlaps"
+         << setw (14) << overlaps.max
+         << setw (14) << overlaps.mean (count) << endl;
+    cout << stats::getTotals ().counters[stats::limitedCells]
+         << " cells limited to a sum of 1" << endl;
+
+    cout << fixed << setprecision (3)
+         << "runtime " << reference.getName () << " " << referenceSeconds << " s, "
+         << engine->getName () << " " << engineSeconds << " s, speedup "
+         << (engineSeconds > 0.0 ? referenceSeconds/engineSeconds : 0.0) << endl;
+
+    if (failures > 0)
+    {
+        cout << failures << " classes exceed the allowed errors" << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
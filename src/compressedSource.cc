@@ -0,0 +1,18 @@
+#include <boost/scoped_ptr.hpp>
+#include "compressedSource.h"
+
+CompressedFeatureSource::CompressedFeatureSource (const FeatureSource& source,
+        double resolution)
+    : MemoryFeatureSource (source.getCoordinateSystem (), resolution)
+{
+    if (source.empty ())
+        return;
+
+    boost::scoped_ptr<FeatureCursor> cursor (source.createCursor ());
+    OGRGeometry* geometry;
+    while ((geometry = cursor->next ()))
+        add (geometry, cursor->getClass ());
+
+    copyAreaFactors (source);
+    buildIndex ();
+}
@@ -0,0 +1,25 @@
+#ifndef COMPRESSEDSOURCE_H
+#define COMPRESSEDSOURCE_H
+
+#include "featureSource.h"
+
+/**
+ * @brief The polygons of another source, packed in memory
+ *
+ * The polygons are read one by one and packed as they are read, see
+ * MemoryFeatureSource, so they are never all unpacked. Sources which
+ * simplify or split the polygons pack them themselves.
+ */
+class CompressedFeatureSource : public MemoryFeatureSource
+{
+  public:
+
+    /**
+     * @param source     The original polygons
+     * @param resolution The rounding of the coordinates in the coordinate
+     *                   system of the source, see GeometryCodec
+     */
+    CompressedFeatureSource (const FeatureSource& source, double resolution);
+};
+
+#endif
@@ -1,17 +1,12 @@
 #include "coordinate.h"
+#include "crsRegistry.h"
 
 Coordinate::Coordinate (double x, double y,
         OGRSpatialReference* coordinateSystem)
 {
     _x = x;
     _y = y;
-    _coordinateSystem = coordinateSystem;
-    _coordinateSystem->Reference ();
-}
-
-Coordinate::~Coordinate ()
-{
-    //_coordinateSystem->Release ();
+    _coordinateSystem = CrsRegistry::instance ().intern (coordinateSystem);
 }
 
 const double Coordinate::getX () const
@@ -31,16 +26,14 @@ OGRSpatialReference* Coordinate::getCoordinateSystem () const
 
 const Coordinate Coordinate::transform (OGRSpatialReference* targetCoordinateSystem) const
 {
-    if (getCoordinateSystem ()->IsSame (targetCoordinateSystem))
+    CrsRegistry& registry = CrsRegistry::instance ();
+    if (registry.isSame (getCoordinateSystem (), targetCoordinateSystem))
         return *this;
     else
     {
-        OGRCoordinateTransformation* trafo =
-            OGRCreateCoordinateTransformation (_coordinateSystem, targetCoordinateSystem);
         double xNew = getX ();
         double yNew = getY ();
-        trafo->Transform (1, &xNew, &yNew);
-        OGRCoordinateTransformation::DestroyCT (trafo);
+        registry.transform (_coordinateSystem, targetCoordinateSystem, 1, &xNew, &yNew);
         Coordinate result(xNew, yNew, targetCoordinateSystem);
         return result;
     }
@@ -8,6 +8,8 @@ using std::ostream;
 
 /**
  * 2D coordinates with informations of the coordinate system attached
+ *
+ * The coordinate system is interned in the CrsRegistry, which owns it.
  */
 class Coordinate
 {
@@ -17,7 +19,6 @@ class Coordinate
     OGRSpatialReference* _coordinateSystem;
   public:
     Coordinate (double, double, OGRSpatialReference*);
-    ~Coordinate ();
     const double getX () const;
     const double getY () const;
     OGRSpatialReference* getCoordinateSystem () const;
@@ -1,4 +1,5 @@
 #include <string>
+#include <sstream>
 #include "corine.h"
 #include "clm.h"
 
@@ -9,200 +10,156 @@ CorineFractions::CorineFractions ()
     : NotClmFractions (typeCount)
 {}
 
+static const MappingMatrix::Entry clmTable[] =
+{
+    {continuousUrbanFabric,                    clm::noPFT, 1.0},
+    {discontinuousUrbanFabric,                 clm::noPFT, 1.0},
+    {industrialCommercial,                     clm::noPFT, 1.0},
+    {roadAndRail,                              clm::noPFT, 1.0},
+    {port,                                     clm::noPFT, 1.0},
+    {airport,                                  clm::noPFT, 1.0},
+    {mineralExtractionSites,                   clm::noPFT, 1.0},
+    {dumpSites,                                clm::noPFT, 1.0},
+    {constructionSites,                        clm::noPFT, 1.0},
+    {greenUrbanAreas,                          clm::c3Grass, 1.0},
+    {sportLeisureFacilities,                   clm::c3Grass, 1.0},
+    {nonIrrigatedArableLand,                   clm::crop, 1.0},
+    {permanentIrrigatedLand,                   clm::crop, 1.0},
+    {riceFields,                               clm::crop, 1.0},
+    {vineyards,                                clm::broadleafDeciduousTreeTemperate, 1.0},
+    {fruitAndBerryPlantations,                 clm::broadleafDeciduousTreeTemperate, 1.0},
+    {oliveGroves,                              clm::broadleafDeciduousTreeTemperate, 1.0},
+    {pastures,                                 clm::c3Grass, 1.0},
+    {annualCropsAssociatedWithPermanentCrops,  clm::crop, 1.0},
+    {complexCultivationPatterns,               clm::crop, 1.0},
+    {landPrincipallyOccupiedByAgricultureWithSignificantAreasOfNaturalVegetation, clm::crop, 1.0},
+    {agroForestryAreas,                        clm::crop, 1.0},
+    {broadLeavedForest,                        clm::broadleafDeciduousTreeTemperate, 1.0},
+    {coniferousForest,                         clm::needleleafEvergreenTreeTemperate, 1.0},
+    {mixedForest,                              clm::broadleafDeciduousTreeTemperate, 1.0},
+    {naturalGrassland,                         clm::c3Grass, 1.0},
+    {moorsAndHeatland,                         clm::broadleafEvergreenShrubTemperate, 1.0},
+    {sclerophyllousVegetation,                 clm::broadleafEvergreenShrubTemperate, 1.0},
+    {transitionalWoodlandShrub,                clm::broadleafDeciduousShrubTemperate, 1.0},
+    {beachesDunesSands,                        clm::noPFT, 1.0},
+    {bareRocks,                                clm::noPFT, 1.0},
+    {sparselyVegetatedAreas,                   clm::noPFT, 1.0},
+    {burnedAreas,                              clm::noPFT, 1.0},
+    {claciersAndPerpetualSnow,                 clm::noPFT, 1.0},
+    {inlandMarshes,                            clm::noPFT, 1.0},
+    {peatBogs,                                 clm::noPFT, 1.0},
+    {saltMarshes,                              clm::noPFT, 1.0},
+    {salines,                                  clm::noPFT, 1.0},
+    {intertidalFlats,                          clm::noPFT, 1.0},
+    {waterCourses,                             clm::noPFT, 1.0},
+    {waterBodies,                              clm::noPFT, 1.0},
+    {coastalLagoons,                           clm::noPFT, 1.0},
+    {estuaries,                                clm::noPFT, 1.0},
+    {seaAndOcean,                              clm::noPFT, 1.0},
+};
+
+const MappingMatrix& corine::clmMapping ()
+{
+    static const MappingMatrix matrix (typeCount, clm::typeCount,
+            clmTable, sizeof (clmTable)/sizeof (clmTable[0]));
+    return matrix;
+}
+
 clm::ClmFractions CorineFractions::map2Clm () const
 {
     clm::ClmFractions clmFractions;
+    clmMapping ().apply (*this, clmFractions);
+    return clmFractions;
+}
 
-    clmFractions.add (clm::noPFT,                            operator[] (continuousUrbanFabric));
-    clmFractions.add (clm::noPFT,                            operator[] (discontinuousUrbanFabric));
-    clmFractions.add (clm::noPFT,                            operator[] (industrialCommercial));
-    clmFractions.add (clm::noPFT,                            operator[] (roadAndRail));
-    clmFractions.add (clm::noPFT,                            operator[] (port));
-    clmFractions.add (clm::noPFT,                            operator[] (airport));
-    clmFractions.add (clm::noPFT,                            operator[] (mineralExtractionSites));
-    clmFractions.add (clm::noPFT,                            operator[] (dumpSites));
-    clmFractions.add (clm::noPFT,                            operator[] (constructionSites));
-    clmFractions.add (clm::c3Grass,                          operator[] (greenUrbanAreas));
-    clmFractions.add (clm::c3Grass,                          operator[] (sportLeisureFacilities));
-    clmFractions.add (clm::crop,                             operator[] (nonIrrigatedArableLand));
-    clmFractions.add (clm::crop,                             operator[] (permanentIrrigatedLand));
-    clmFractions.add (clm::crop,                             operator[] (riceFields));
-    clmFractions.add (clm::broadleafDeciduousTreeTemperate,  operator[] (vineyards));
-    clmFractions.add (clm::broadleafDeciduousTreeTemperate,  operator[] (fruitAndBerryPlantations));
-    clmFractions.add (clm::broadleafDeciduousTreeTemperate,  operator[] (oliveGroves));
-    clmFractions.add (clm::c3Grass,                          operator[] (pastures));
-    clmFractions.add (clm::crop,                             operator[] (annualCropsAssociatedWithPermanentCrops));
-    clmFractions.add (clm::crop,                             operator[] (complexCultivationPatterns));
-    clmFractions.add (clm::crop,                             operator[] (landPrincipallyOccupiedByAgricultureWithSignificantAreasOfNaturalVegetation));
-    clmFractions.add (clm::crop,                             operator[] (agroForestryAreas));
-    clmFractions.add (clm::broadleafDeciduousTreeTemperate,  operator[] (broadLeavedForest));
-    clmFractions.add (clm::needleleafEvergreenTreeTemperate, operator[] (coniferousForest));
-    clmFractions.add (clm::broadleafDeciduousTreeTemperate,  operator[] (mixedForest));
-    clmFractions.add (clm::c3Grass,                          operator[] (naturalGrassland));
-    clmFractions.add (clm::broadleafEvergreenShrubTemperate, operator[] (moorsAndHeatland));
-    clmFractions.add (clm::broadleafEvergreenShrubTemperate, operator[] (sclerophyllousVegetation));
-    clmFractions.add (clm::broadleafDeciduousShrubTemperate, operator[] (transitionalWoodlandShrub));
-    clmFractions.add (clm::noPFT,                            operator[] (beachesDunesSands));
-    clmFractions.add (clm::noPFT,                            operator[] (bareRocks));
-    clmFractions.add (clm::noPFT,                            operator[] (sparselyVegetatedAreas));
-    clmFractions.add (clm::noPFT,                            operator[] (burnedAreas));
-    clmFractions.add (clm::noPFT,                            operator[] (claciersAndPerpetualSnow));
-    clmFractions.add (clm::noPFT,                            operator[] (inlandMarshes));
-    clmFractions.add (clm::noPFT,                            operator[] (peatBogs));
-    clmFractions.add (clm::noPFT,                            operator[] (saltMarshes));
-    clmFractions.add (clm::noPFT,                            operator[] (salines));
-    clmFractions.add (clm::noPFT,                            operator[] (intertidalFlats));
-    clmFractions.add (clm::noPFT,                            operator[] (waterCourses));
-    clmFractions.add (clm::noPFT,                            operator[] (waterBodies));
-    clmFractions.add (clm::noPFT,                            operator[] (coastalLagoons));
-    clmFractions.add (clm::noPFT,                            operator[] (estuaries));
-    clmFractions.add (clm::noPFT,                            operator[] (seaAndOcean));
+// the three digit CORINE code of each type //
+//-------------------------------------------//
+static const int codes[typeCount] =
+{
+    111, 112, 121, 122, 123, 124, 131, 132, 133, 141, 142,
+    211, 212, 213, 221, 222, 223, 231, 241, 242, 243, 244,
+    311, 312, 313, 321, 322, 323, 324, 331, 332, 333, 334,
+    335, 411, 412, 421, 422, 423, 511, 512, 521, 522, 523
+};
 
-    return clmFractions;
+int corine::getCode (size_t type)
+{
+    if (type >= typeCount)
+        throw UnknownCorineCodeException ();
+    return codes[type];
+}
+
+size_t corine::getType (int code)
+{
+    for (size_t type = 0; type < typeCount; ++type)
+        if (codes[type] == code)
+            return type;
+    throw UnknownCorineCodeException ();
+}
+
+string corine::getFileName (string path, size_t type, string prefix)
+{
+    std::ostringstream result;
+    result << path << "/" << prefix << getCode (type) << ".shp";
+    return result.str ();
+}
+
+static const MappingMatrix::Entry derivedTable[] =
+{
+    {continuousUrbanFabric,                    artificialFraction, 1.0},
+    {discontinuousUrbanFabric,                 artificialFraction, 1.0},
+    {industrialCommercial,                     artificialFraction, 1.0},
+    {roadAndRail,                              artificialFraction, 1.0},
+    {port,                                     artificialFraction, 1.0},
+    {airport,                                  artificialFraction, 1.0},
+    {mineralExtractionSites,                   artificialFraction, 1.0},
+    {dumpSites,                                artificialFraction, 1.0},
+    {constructionSites,                        artificialFraction, 1.0},
+    {greenUrbanAreas,                          artificialFraction, 1.0},
+    {sportLeisureFacilities,                   artificialFraction, 1.0},
+    {inlandMarshes,                            wetlandFraction,    1.0},
+    {peatBogs,                                 wetlandFraction,    1.0},
+    {saltMarshes,                              wetlandFraction,    1.0},
+    {salines,                                  wetlandFraction,    1.0},
+    {intertidalFlats,                          wetlandFraction,    1.0},
+    {waterCourses,                             waterFraction,      1.0},
+    {waterBodies,                              waterFraction,      1.0},
+    {coastalLagoons,                           waterFraction,      1.0},
+    {estuaries,                                waterFraction,      1.0},
+    {seaAndOcean,                              waterFraction,      1.0},
+    {claciersAndPerpetualSnow,                 glacierFraction,    1.0},
+};
+
+const MappingMatrix& corine::derivedMapping ()
+{
+    static const MappingMatrix matrix (typeCount, derivedTypeCount,
+            derivedTable, sizeof (derivedTable)/sizeof (derivedTable[0]));
+    return matrix;
 }
 
-string corine::getFileName (string path, size_t type)
+double CorineFractions::getDerivedFraction (DerivedType type) const
 {
-    string result ("");
-    result += path;
-    result += "/clc06_c";
-    switch (type)
-    {
-        case  0:
-            result += "111"; break;
-        case  1:
-            result += "112"; break;
-        case  2:
-            result += "121"; break;
-        case  3:
-            result += "122"; break;
-        case  4:
-            result += "123"; break;
-        case  5:
-            result += "124"; break;
-        case  6:
-            result += "131"; break;
-        case  7:
-            result += "132"; break;
-        case  8:
-            result += "133"; break;
-        case  9:
-            result += "141"; break;
-        case 10:
-            result += "142"; break;
-        case 11:
-            result += "211"; break;
-        case 12:
-            result += "212"; break;
-        case 13:
-            result += "213"; break;
-        case 14:
-            result += "221"; break;
-        case 15:
-            result += "222"; break;
-        case 16:
-            result += "223"; break;
-        case 17:
-            result += "231"; break;
-        case 18:
-            result += "241"; break;
-        case 19:
-            result += "242"; break;
-        case 20:
-            result += "243"; break;
-        case 21:
-            result += "244"; break;
-        case 22:
-            result += "311"; break;
-        case 23:
-            result += "312"; break;
-        case 24:
-            result += "313"; break;
-        case 25:
-            result += "321"; break;
-        case 26:
-            result += "322"; break;
-        case 27:
-            result += "323"; break;
-        case 28:
-            result += "324"; break;
-        case 29:
-            result += "331"; break;
-        case 30:
-            result += "332"; break;
-        case 31:
-            result += "333"; break;
-        case 32:
-            result += "334"; break;
-        case 33:
-            result += "335"; break;
-        case 34:
-            result += "411"; break;
-        case 35:
-            result += "412"; break;
-        case 36:
-            result += "421"; break;
-        case 37:
-            result += "422"; break;
-        case 38:
-            result += "423"; break;
-        case 39:
-            result += "511"; break;
-        case 40:
-            result += "512"; break;
-        case 41:
-            result += "521"; break;
-        case 42:
-            result += "522"; break;
-        case 43:
-            result += "523"; break;
-    }
-    result += ".shp";
-    return result;
+    Fractions derived (derivedTypeCount);
+    derivedMapping ().apply (*this, derived);
+    return derived[type];
 }
 
 double CorineFractions::getArtificialFraction () const
 {
-    double result = 0.0;
-    result += operator[] (continuousUrbanFabric);
-    result += operator[] (discontinuousUrbanFabric);
-    result += operator[] (industrialCommercial);
-    result += operator[] (roadAndRail);
-    result += operator[] (port);
-    result += operator[] (airport);
-    result += operator[] (mineralExtractionSites);
-    result += operator[] (dumpSites);
-    result += operator[] (constructionSites);
-    result += operator[] (greenUrbanAreas);
-    result += operator[] (sportLeisureFacilities);
-    return result;
+    return getDerivedFraction (artificialFraction);
 }
 
 double CorineFractions::getWetlandFraction () const
 {
-    double result = 0.0;
-    result += operator[] (inlandMarshes);
-    result += operator[] (peatBogs);
-    result += operator[] (saltMarshes);
-    result += operator[] (salines);
-    result += operator[] (intertidalFlats);
-    return result;
+    return getDerivedFraction (wetlandFraction);
 }
 
 double CorineFractions::getWaterFraction () const
 {
-    double result = 0.0;
-    result += operator[] (waterCourses);
-    result += operator[] (waterBodies);
-    result += operator[] (coastalLagoons);
-    result += operator[] (estuaries);
-    result += operator[] (seaAndOcean);
-    return result;
+    return getDerivedFraction (waterFraction);
 }
 
 double CorineFractions::getGlacierFraction () const
 {
-    double result = 0.0;
-    result += operator[] (claciersAndPerpetualSnow);
-    return result;
+    return getDerivedFraction (glacierFraction);
 }
@@ -4,6 +4,7 @@
 #include <string>
 #include "notClmFractions.h"
 #include "clm.h"
+#include "mappingMatrix.h"
 
 namespace corine
 {
@@ -58,8 +59,23 @@ namespace corine
         seaAndOcean                = 43,
     };
 
+    const size_t derivedTypeCount = 4;
+
+    /**
+     * @brief Aggregated fractions written besides the CLM types
+     */
+    enum DerivedType
+    {
+        artificialFraction = 0,
+        wetlandFraction    = 1,
+        waterFraction      = 2,
+        glacierFraction    = 3
+    };
+
     class CorineFractions : public NotClmFractions
     {
+        private:
+            double getDerivedFraction (DerivedType) const;
         public:
             CorineFractions ();
             clm::ClmFractions map2Clm () const;
@@ -69,7 +85,36 @@ namespace corine
             double getGlacierFraction () const;
     };
 
-    std::string getFileName (std::string, size_t);
+    class UnknownCorineCodeException {};
+
+    /**
+     * @brief The shape file of a type, e.g. path/clc06_c523.shp
+     *
+     * @param prefix The prefix of the file names of an edition, e.g.
+     *               clc00_c for CLC 2000
+     */
+    std::string getFileName (std::string path, size_t type,
+            std::string prefix = "clc06_c");
+
+    /**
+     * @brief The three digit CORINE code of a type, e.g. 523 for seaAndOcean
+     */
+    int getCode (size_t type);
+
+    /**
+     * @brief The type of a three digit CORINE code
+     */
+    size_t getType (int code);
+
+    /**
+     * @brief The built-in mapping of the CORINE types to the CLM types
+     */
+    const MappingMatrix& clmMapping ();
+
+    /**
+     * @brief The mapping of the CORINE types to the derived fractions
+     */
+    const MappingMatrix& derivedMapping ();
 
 }
                  
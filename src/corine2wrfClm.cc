@@ -1,27 +1,25 @@
 #include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <string>
+#include <vector>
 #include <getopt.h>
-#include <boost/multi_array.hpp>
-
-#include <ogr_spatialref.h>
-#include <ogrsf_frmts.h>
-#include <ogr_geometry.h>
+#include <boost/scoped_ptr.hpp>
 
 #include "corine.h"
-#include "wrf.h"
 #include "clm.h"
-
-
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include "mappingMatrix.h"
+#include "overlay.h"
+#include "epochs.h"
+#include "runs.h"
+#include "stats.h"
 
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
 
 using namespace std;
-void doTheWork  (const string, const string);
 
 static int verbosity = 0;
 
@@ -29,6 +27,22 @@ int main (int argc, char ** argv)
 {
     string wrfFileName ("wrfinput_d01");
     string corineFileDirectory (".");
+    string mappingTableFileName ("");
+    size_t readerCount = 1;
+    string engineName ("pipelined");
+    overlay::ReadOptions readOptions;
+    overlay::RunOptions runOptions;
+    string statsFileName ("");
+    bool merge = false;
+    string remapFileName ("");
+    double reprojectionError = 0.0;
+    string buildMasterFileName ("");
+    double masterCellSize = 250.0;
+    double masterExtent[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t masterLevelCount = 6;
+    vector<string> epochTexts;
+    string socketName ("");
+    size_t jobCount = 4;
 
     while (true)
     {
@@ -39,11 +53,37 @@ int main (int argc, char ** argv)
             {"version",    no_argument,       0, 'V'},
             {"corineFile", required_argument, 0, 'c'},
             {"wrfFile",    required_argument, 0, 'w'},
+            {"mappingTable", required_argument, 0, 'm'},
+            {"readerThreads", required_argument, 0, 'r'},
+            {"statsJson",  required_argument, 0, 's'},
+            {"engine",     required_argument, 0, 'e'},
+            {"window",     required_argument, 0, 'W'},
+            {"tile",       required_argument, 0, 't'},
+            {"partial",    required_argument, 0, 'p'},
+            {"merge",      no_argument,       0, 'M'},
+            {"reader",     required_argument, 0, 'f'},
+            {"simplify",   required_argument, 0, 'S'},
+            {"simplifyCache", required_argument, 0, 'C'},
+            {"split",      required_argument, 0, 'P'},
+            {"classAttribute", required_argument, 0, 'A'},
+            {"fractionFile", required_argument, 0, 'F'},
+            {"remap",      required_argument, 0, 'R'},
+            {"reprojectionError", required_argument, 0, 'E'},
+            {"max-memory", required_argument, 0, 'X'},
+            {"buildMaster", required_argument, 0, 'B'},
+            {"masterCellSize", required_argument, 0, 'g'},
+            {"masterExtent", required_argument, 0, 'x'},
+            {"masterLevels", required_argument, 0, 'L'},
+            {"master",     required_argument, 0, 'G'},
+            {"epoch",      required_argument, 0, 'Y'},
+            {"serve",      required_argument, 0, 'D'},
+            {"jobs",       required_argument, 0, 'j'},
+            {"compress",   required_argument, 0, 'Q'},
             {0,            0,                 0, 0  }
         };
 
         int option_index = 0;
-        int c = getopt_long (argc, argv, "hvVc:w:", long_options, &option_index);
+        int c = getopt_long (argc, argv, "hvVc:w:m:r:s:e:W:t:p:Mf:S:C:P:A:F:R:E:X:B:g:x:L:G:Y:D:j:Q:", long_options, &option_index);
         if (c == -1) break;
 
         switch (c)
@@ -71,6 +111,89 @@ int main (int argc, char ** argv)
             case 'w':
                 wrfFileName = string (optarg);
                 break;
+            case 'm':
+                mappingTableFileName = string (optarg);
+                break;
+            case 'r':
+                readerCount = atoi (optarg);
+                break;
+            case 's':
+                statsFileName = string (optarg);
+                break;
+            case 'e':
+                engineName = string (optarg);
+                break;
+            case 'W':
+                runOptions.window = string (optarg);
+                break;
+            case 't':
+                runOptions.tile = string (optarg);
+                break;
+            case 'p':
+                runOptions.partialFile = string (optarg);
+                break;
+            case 'M':
+                merge = true;
+                break;
+            case 'f':
+                readOptions.reader = string (optarg);
+                break;
+            case 'S':
+                readOptions.simplifyFactor = atof (optarg);
+                break;
+            case 'C':
+                readOptions.cacheDirectory = string (optarg);
+                break;
+            case 'P':
+                readOptions.splitPointCount = atoi (optarg);
+                break;
+            case 'A':
+                readOptions.classAttribute = string (optarg);
+                break;
+            case 'F':
+                runOptions.fractionFile = string (optarg);
+                break;
+            case 'R':
+                remapFileName = string (optarg);
+                break;
+            case 'E':
+                reprojectionError = atof (optarg);
+                break;
+            case 'X':
+                runOptions.maxMemory = (size_t) (atof (optarg)*1024*1024);
+                break;
+            case 'B':
+                buildMasterFileName = string (optarg);
+                break;
+            case 'g':
+                masterCellSize = atof (optarg);
+                break;
+            case 'x':
+                if (sscanf (optarg, "%lf,%lf,%lf,%lf", &masterExtent[0], &masterExtent[1],
+                            &masterExtent[2], &masterExtent[3]) != 4)
+                {
+                    cerr << "the master extent is given as x0,y0,x1,y1" << endl;
+                    exit (EXIT_FAILURE);
+                }
+                break;
+            case 'L':
+                masterLevelCount = atoi (optarg);
+                break;
+            case 'G':
+                runOptions.masterFile = string (optarg);
+                break;
+            case 'Y':
+                epochTexts.push_back (string (optarg));
+                break;
+            case 'D':
+                socketName = string (optarg);
+                break;
+            case 'j':
+                jobCount = atoi (optarg);
+                break;
+            case 'Q':
+                readOptions.compressResolution = atof (optarg);
+                break;
             case '?':
                 break;
             default:
@@ -78,184 +201,102 @@ int main (int argc, char ** argv)
         }
     }
 
+    // the master grid covers the given area only //
+    //---------------------------------------------//
+    if (    !buildMasterFileName.empty ()
+        and (masterExtent[2] <= masterExtent[0] or masterExtent[3] <= masterExtent[1]))
+    {
+        cerr << "the master grid needs --masterExtent x0,y0,x1,y1 with x0 < x1 and y0 < y1"
+             << endl;
+        exit (EXIT_FAILURE);
+    }
+
+    runOptions.verbosity = verbosity;
     if (verbosity > 0)
     {
         cout << "corineFileDirectory = '" << corineFileDirectory << "'" << endl;
         cout << "wrfFileName =         '" << wrfFileName << "'" << endl;
+        if (!mappingTableFileName.empty ())
+            cout << "mappingTableFileName = '" << mappingTableFileName << "'" << endl;
     }
 
-    doTheWork (corineFileDirectory, wrfFileName);
-
-    return EXIT_SUCCESS;
-}
-
-void doTheWork (const string corineFileDirectory, const string wrfFileName)
-{
-    // Open WRF file //
-    //---------------//
-    wrf::File wrf (wrfFileName, wrf::File::Write);
-    if (!(wrf.isUsgsLUType () or wrf.isModisLUType ()))
-        throw wrf::UnknownLUTypeException ();
-
-    boost::multi_array<corine::CorineFractions, 2>
-        fractions (boost::extents[wrf.iSize ()][wrf.jSize ()]);
-
-    OGRSpatialReference* wrfCoordSys = wrf.getCoordinateSystem();
-    wrfCoordSys->Reference ();
-    OGRRegisterAll();
-
-#ifdef DEBUG
-    for (size_t type = 0; type < 1; ++type)
-#else
-    for (size_t type = 0; type < corine::typeCount; ++type)
-#endif
+    // combine the partial outputs of windows, no overlay is done //
+    //--------------------------------------------------------------//
+    if (merge)
     {
-        string fileName = corine::getFileName (corineFileDirectory, type);
-        if (verbosity > 0) cout << "working on corine file " << fileName << endl;
-
-#ifdef DEBUG2
-        for (size_t i = 0; i < 1; ++i)
-#else
-#ifdef _OPENMP
-#pragma omp parallel for schedule(dynamic)
-#endif
-        for (size_t i = 0; i < wrf.iSize (); ++i)
-#endif
-        {
-            OGRDataSource* dataSource = OGRSFDriverRegistrar::Open (fileName.c_str (), FALSE);
-
-            OGRLayer* layer = dataSource->GetLayer (0);
-            if (layer->GetFeatureCount () > 0)
-            {
-                OGRSpatialReference* corineCoordSys = layer->GetSpatialRef ();
-                OGRCoordinateTransformation* trafoCorine2Wrf =
-                    OGRCreateCoordinateTransformation (corineCoordSys, wrfCoordSys);
-                OGRCoordinateTransformation* trafoWrf2Corine =
-                    OGRCreateCoordinateTransformation (wrfCoordSys, corineCoordSys);
-
-#ifdef DEBUG2
-                for (size_t j = 0; j < 1; ++j)
-#else
-                for (size_t j = 0; j < wrf.jSize (); ++j)
-#endif
-                {
-                    OGRGeometry* wrfPolygon = wrf.getPolygon (i, j);
-                    double wrfArea = ((OGRPolygon*)wrfPolygon)->get_Area ();
-
-                    OGRGeometry* wrfPolygonInCorineCoord =
-                        wrfPolygon->clone ();
-                    wrfPolygonInCorineCoord->transform (trafoWrf2Corine);
-                    layer->SetSpatialFilter (wrfPolygonInCorineCoord);
-                    if (layer->GetFeatureCount () > 0)
-                    {
-
-                        layer->ResetReading ();
-                        OGRFeature* feature;
-                        while ((feature = layer->GetNextFeature ()))
-                        {
-                            OGRGeometry* corinePolygon = feature->GetGeometryRef ();
-                            corinePolygon->transform (trafoCorine2Wrf);
-
-                            if (corinePolygon->Intersects (wrfPolygon))
-                            {
-                                OGRGeometry* intersection =
-                                    corinePolygon->Intersection (wrfPolygon);
-                                double intersectionArea =
-                                    ((OGRPolygon*)intersection)->get_Area ();
-
-                                fractions[i][j].add (type, intersectionArea/wrfArea);
-
-                                OGRGeometryFactory::destroyGeometry (intersection);
-                            }
-                            OGRFeature::DestroyFeature (feature);
-                        }
-                    }
-                    OGRGeometryFactory::destroyGeometry (wrfPolygonInCorineCoord);
-                    OGRGeometryFactory::destroyGeometry (wrfPolygon);
-                }
-
-                OGRCoordinateTransformation::DestroyCT (trafoCorine2Wrf);
-                OGRCoordinateTransformation::DestroyCT (trafoWrf2Corine);
-            }
-            OGRDataSource::DestroyDataSource (dataSource);
-        }
+        overlay::mergePartialFiles (wrfFileName, vector<string> (argv + optind, argv + argc),
+                verbosity > 0);
+        return EXIT_SUCCESS;
     }
-    wrfCoordSys->Release ();
 
-#ifdef _OPENMP
-    boost::scoped_ptr<omp_lock_t> lock (new omp_lock_t);
-    omp_init_lock (lock.get ());
-#endif
+    // the polygons are loaded once and jobs are taken from a socket //
+    //----------------------------------------------------------------//
+    if (!socketName.empty ())
+    {
+        overlay::serveJobs (socketName, jobCount, corineFileDirectory, wrfFileName,
+                readOptions, mappingTableFileName, engineName, readerCount, reprojectionError,
+                runOptions);
+        return EXIT_SUCCESS;
+    }
 
-#ifndef NOOUTPUT
-#ifdef DEBUG3
-    for (size_t i = 11; i < 12; ++i)
-        for (size_t j = 15; j < 16; ++j)
-#else
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < wrf.iSize (); ++i)
-        for (size_t j = 0; j < wrf.jSize (); ++j)
-#endif
+    // CORINE to CLM mapping, either built in or from a table file //
+    //-------------------------------------------------------------//
+    boost::scoped_ptr<MappingMatrix> mappingTable;
+    if (!mappingTableFileName.empty ())
+        mappingTable.reset (new MappingMatrix (corine::typeCount, clm::typeCount,
+                    mappingTableFileName));
+
+    const MappingMatrix& clmMapping = mappingTable ? *mappingTable : corine::clmMapping ();
+
+    // the remap stage maps the fractions of an earlier overlay, the
+    // geometries are not read again
+    // -------------------------------------------------------------
+    if (!remapFileName.empty ())
+        overlay::remapFractionFile (remapFileName, wrfFileName, clmMapping, runOptions);
+    else
+    {
+        boost::scoped_ptr<overlay::Engine> engine (
+                overlay::createEngine (engineName, readerCount));
+        engine->setMaxReprojectionError (reprojectionError);
+
+        // the master grid is computed once for many WRF grids, see
+        // overlay::remapMaster
+        // --------------------------------------------------------
+        if (!buildMasterFileName.empty ())
+            overlay::buildMasterFile (corineFileDirectory, buildMasterFileName, *engine,
+                    readOptions, masterExtent, masterCellSize, masterLevelCount, runOptions);
+        else if (!epochTexts.empty ())
         {
-
-            // map the corine fractions to CLM fractions
-            // -----------------------------------------
-            clm::ClmFractions clmFractions = fractions[i][j].map2Clm ();
-
-            // if missing is too large, fill with default values from the
-            // original WRF file mapped to CLM types
-            // ----------------------------------------------------------
-            double missing = clmFractions.missing ();
-            if (missing > 1.0e-5)
+            try
             {
-
-                if (verbosity > 1)
-                {
-#ifdef _OPENMP
-                    omp_set_lock (lock.get ());
-#endif
-                    cerr << "WARNING: using partly original land use in grid cell "
-                         << i << " " << j << " with missing fraction of " << 
-                         missing << endl;
-#ifdef _OPENMP
-                    omp_unset_lock (lock.get ());
-#endif
-                }
-
-                clm::ClmFractions originalLandUseFractions
-                    = wrf.getLandUseFraction (i, j)->map2Clm ();
-
-                for (size_t type = 0; type < clm::typeCount; ++type)
-                    clmFractions.set (type, originalLandUseFractions[type]*missing);
-                            
+                overlay::runEpochs (epochTexts, wrfFileName, *engine, readOptions, runOptions);
             }
-
-#ifdef CHECK
-            try
+            catch (overlay::EpochFormatException&)
             {
-                clmFractions.check ();
+                cerr << "an epoch is given as label:directory:prefix[:changes], "
+                     << "every epoch but the first with changes" << endl;
+                return EXIT_FAILURE;
             }
-            catch (std::exception& e)
+            catch (overlay::NoFractionFileException&)
             {
-                cout << clmFractions << endl;
-                throw e;
+                cerr << "the epochs are written to fraction files, see --fractionFile" << endl;
+                return EXIT_FAILURE;
             }
-#endif
-            
-            // write result to WRF file
-            // ------------------------
-            wrf.writeClmPftTypeFractions (i, j, clmFractions);
-            wrf.writeWaterFraction (i, j, fractions[i][j].getWaterFraction ());
-            wrf.writeUrbanFraction (i, j, fractions[i][j].getArtificialFraction ());
-            wrf.writeGlacierFraction (i, j, fractions[i][j].getGlacierFraction ());
-            wrf.writeWetlandFraction (i, j, fractions[i][j].getWetlandFraction ());
         }
-#endif
+        else
+            overlay::runOverlay (corineFileDirectory, wrfFileName, clmMapping, *engine,
+                    readOptions, runOptions);
+    }
 
-#ifdef _OPENMP
-    omp_destroy_lock (lock.get ());
-#endif
+    // counters and timers of the stages //
+    //-----------------------------------//
+    if (verbosity > 0)
+        stats::writeSummary (cout);
+    if (!statsFileName.empty ())
+    {
+        ofstream statsFile (statsFileName.c_str ());
+        stats::writeJson (statsFile);
+    }
 
+    return EXIT_SUCCESS;
 }
@@ -0,0 +1,150 @@
+#include <climits>
+#include <cpl_conv.h>
+#include "crsRegistry.h"
+
+CrsRegistry::CrsRegistry ()
+{
+    pthread_mutex_init (&_lock, NULL);
+    pthread_key_create (&_threadCacheKey, releaseThreadCache);
+}
+
+CrsRegistry::~CrsRegistry ()
+{
+    // threads ending later must not find the registry //
+    //--------------------------------------------------//
+    pthread_key_delete (_threadCacheKey);
+
+    std::set<ThreadCache*>::iterator cache;
+    for (cache = _threadCaches.begin (); cache != _threadCaches.end (); ++cache)
+        destroyThreadCache (*cache);
+
+    for (size_t n = 0; n < _coordinateSystems.size (); ++n)
+        _coordinateSystems[n]->Release ();
+
+    pthread_mutex_destroy (&_lock);
+}
+
+CrsRegistry& CrsRegistry::instance ()
+{
+    static CrsRegistry registry;
+    return registry;
+}
+
+void CrsRegistry::destroyThreadCache (ThreadCache* cache)
+{
+    std::map<Key, OGRCoordinateTransformation*>::iterator it;
+    for (it = cache->transformations.begin (); it != cache->transformations.end (); ++it)
+        OGRCoordinateTransformation::DestroyCT (it->second);
+    delete cache;
+}
+
+void CrsRegistry::releaseThreadCache (void* data)
+{
+    ThreadCache* cache = (ThreadCache*) data;
+    CrsRegistry& registry = instance ();
+
+    pthread_mutex_lock (&registry._lock);
+    registry._threadCaches.erase (cache);
+    pthread_mutex_unlock (&registry._lock);
+
+    destroyThreadCache (cache);
+}
+
+CrsRegistry::ThreadCache& CrsRegistry::getThreadCache ()
+{
+    ThreadCache* cache = (ThreadCache*) pthread_getspecific (_threadCacheKey);
+    if (!cache)
+    {
+        cache = new ThreadCache;
+        pthread_setspecific (_threadCacheKey, cache);
+        pthread_mutex_lock (&_lock);
+        _threadCaches.insert (cache);
+        pthread_mutex_unlock (&_lock);
+    }
+    return *cache;
+}
+
+OGRSpatialReference* CrsRegistry::internLocked (const std::string& wkt,
+        OGRSpatialReference* coordinateSystem)
+{
+    std::map<std::string, OGRSpatialReference*>::iterator it = _canonical.find (wkt);
+    if (it != _canonical.end ())
+        return it->second;
+
+    // a new text may still describe a known system //
+    //-----------------------------------------------//
+    OGRSpatialReference* result = NULL;
+    for (size_t n = 0; n < _coordinateSystems.size (); ++n)
+        if (_coordinateSystems[n]->IsSame (coordinateSystem))
+        {
+            result = _coordinateSystems[n];
+            break;
+        }
+    if (!result)
+    {
+        result = coordinateSystem->Clone ();
+        _coordinateSystems.push_back (result);
+    }
+
+    _canonical[wkt] = result;
+    return result;
+}
+
+OGRSpatialReference* CrsRegistry::intern (OGRSpatialReference* coordinateSystem)
+{
+    ThreadCache& cache = getThreadCache ();
+    if (cache.canonical.count (coordinateSystem))
+        return coordinateSystem;
+
+    char* text = NULL;
+    coordinateSystem->exportToWkt (&text);
+    const std::string wkt (text ? text : "");
+    CPLFree (text);
+
+    pthread_mutex_lock (&_lock);
+    OGRSpatialReference* result = internLocked (wkt, coordinateSystem);
+    pthread_mutex_unlock (&_lock);
+
+    cache.canonical.insert (result);
+    return result;
+}
+
+bool CrsRegistry::isSame (OGRSpatialReference* first, OGRSpatialReference* second)
+{
+    return first == second or intern (first) == intern (second);
+}
+
+OGRCoordinateTransformation* CrsRegistry::getTransformation (
+        OGRSpatialReference* source, OGRSpatialReference* target)
+{
+    ThreadCache& cache = getThreadCache ();
+    Key key (intern (source), intern (target));
+
+    std::map<Key, OGRCoordinateTransformation*>::iterator it =
+        cache.transformations.find (key);
+    if (it != cache.transformations.end ())
+        return it->second;
+
+    OGRCoordinateTransformation* transformation =
+        OGRCreateCoordinateTransformation (key.first, key.second);
+    if (!transformation)
+        throw CrsTransformationException ();
+
+    cache.transformations[key] = transformation;
+    return transformation;
+}
+
+void CrsRegistry::transform (OGRSpatialReference* source, OGRSpatialReference* target,
+        size_t count, double* x, double* y)
+{
+    if (isSame (source, target))
+        return;
+
+    OGRCoordinateTransformation* transformation = getTransformation (source, target);
+    for (size_t offset = 0; offset < count; offset += INT_MAX)
+    {
+        int chunk = (count - offset > (size_t) INT_MAX) ? INT_MAX : (int)(count - offset);
+        if (!transformation->Transform (chunk, x + offset, y + offset))
+            throw CrsTransformationException ();
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef CRSREGISTRY_H
+#define CRSREGISTRY_H
+
+#include <ogr_spatialref.h>
+#include <pthread.h>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+/**
+ * @brief Process-wide registry of coordinate systems and of the
+ *        transformations between them
+ *
+ * Every coordinate system passed to the registry is interned: equal systems
+ * are represented by one canonical object, a copy owned by the registry.
+ * The canonical objects are found by their WKT, so the registry holds one
+ * entry per distinct system however many objects describe it, and the
+ * objects of the callers are neither kept nor referenced.
+ *
+ * Transformations are created once per pair of systems and thread, because
+ * OGRCoordinateTransformation objects must not be shared between threads.
+ * The caches of the threads are thread-specific data of POSIX threads, so
+ * they are freed when their thread ends, with or without OpenMP.
+ */
+class CrsRegistry
+{
+  public:
+    typedef std::pair<OGRSpatialReference*, OGRSpatialReference*> Key;
+
+    /**
+     * @brief The per-thread part of the registry
+     *
+     * The canonical objects are never freed before the registry, so their
+     * addresses identify them without a lock.
+     */
+    struct ThreadCache
+    {
+        std::set<OGRSpatialReference*>               canonical;
+        std::map<Key, OGRCoordinateTransformation*> transformations;
+    };
+
+  private:
+    std::vector<OGRSpatialReference*>            _coordinateSystems;
+    std::map<std::string, OGRSpatialReference*>  _canonical;
+    std::set<ThreadCache*>                       _threadCaches;
+    pthread_mutex_t                              _lock;
+    pthread_key_t                                _threadCacheKey;
+
+    CrsRegistry ();
+    ~CrsRegistry ();
+    CrsRegistry (const CrsRegistry&);
+    CrsRegistry& operator= (const CrsRegistry&);
+
+    ThreadCache& getThreadCache ();
+    OGRSpatialReference* internLocked (const std::string&, OGRSpatialReference*);
+    static void destroyThreadCache (ThreadCache*);
+    static void releaseThreadCache (void*);
+
+  public:
+    /**
+     * @brief The registry of the process
+     */
+    static CrsRegistry& instance ();
+
+    /**
+     * @brief The canonical object of a coordinate system
+     *
+     * Canonical objects are found in the cache of the thread, any other
+     * object is exported to WKT and looked up under the lock of the
+     * registry, so long-lived objects are best interned once and replaced
+     * by the result.
+     *
+     * @param coordinateSystem Any coordinate system
+     *
+     * @return The registered system equal to coordinateSystem
+     */
+    OGRSpatialReference* intern (OGRSpatialReference* coordinateSystem);
+
+    /**
+     * @brief Check whether two coordinate systems are equal
+     */
+    bool isSame (OGRSpatialReference*, OGRSpatialReference*);
+
+    /**
+     * @brief The cached transformation of the calling thread
+     *
+     * @param source Coordinate system of the input
+     * @param target Coordinate system of the output
+     *
+     * @return A transformation owned by the registry
+     */
+    OGRCoordinateTransformation* getTransformation (
+            OGRSpatialReference* source, OGRSpatialReference* target);
+
+    /**
+     * @brief Transform arrays of points in place
+     *
+     * @param source Coordinate system of the input
+     * @param target Coordinate system of the output
+     * @param count  Number of points
+     * @param x      Array of x values
+     * @param y      Array of y values
+     */
+    void transform (OGRSpatialReference* source, OGRSpatialReference* target,
+            size_t count, double* x, double* y);
+};
+
+class CrsTransformationException {};
+
+#endif
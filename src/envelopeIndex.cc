@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cmath>
+#include "envelopeIndex.h"
+
+using std::vector;
+
+const size_t EnvelopeIndex::nodeCapacity;
+
+namespace
+{
+
+    struct CenterXLess
+    {
+        const vector<OGREnvelope>* envelopes;
+        bool operator() (size_t a, size_t b) const
+        {
+            return (*envelopes)[a].MinX + (*envelopes)[a].MaxX
+                 < (*envelopes)[b].MinX + (*envelopes)[b].MaxX;
+        }
+    };
+
+    struct CenterYLess
+    {
+        const vector<OGREnvelope>* envelopes;
+        bool operator() (size_t a, size_t b) const
+        {
+            return (*envelopes)[a].MinY + (*envelopes)[a].MaxY
+                 < (*envelopes)[b].MinY + (*envelopes)[b].MaxY;
+        }
+    };
+
+}
+
+bool EnvelopeIndex::intersects (const OGREnvelope& a, const OGREnvelope& b)
+{
+    return a.MinX <= b.MaxX and b.MinX <= a.MaxX
+       and a.MinY <= b.MaxY and b.MinY <= a.MaxY;
+}
+
+void EnvelopeIndex::merge (OGREnvelope& a, const OGREnvelope& b)
+{
+    a.MinX = std::min (a.MinX, b.MinX);
+    a.MaxX = std::max (a.MaxX, b.MaxX);
+    a.MinY = std::min (a.MinY, b.MinY);
+    a.MaxY = std::max (a.MaxY, b.MaxY);
+}
+
+EnvelopeIndex::EnvelopeIndex ()
+{}
+
+EnvelopeIndex::EnvelopeIndex (const vector<OGREnvelope>& envelopes)
+{
+    if (envelopes.empty ())
+        return;
+
+    // sort the items into tiles, each tile is one leaf //
+    //--------------------------------------------------//
+    vector<size_t> order (envelopes.size ());
+    for (size_t n = 0; n < order.size (); ++n)
+        order[n] = n;
+
+    vector<Node> leafs;
+    leafs.resize (envelopes.size ());
+    for (size_t n = 0; n < envelopes.size (); ++n)
+    {
+        leafs[n].envelope = envelopes[n];
+        leafs[n].first = n;
+        leafs[n].count = 1;
+    }
+    pack (leafs, order);
+
+    _envelopes.resize (envelopes.size ());
+    _ids.resize (envelopes.size ());
+    for (size_t n = 0; n < order.size (); ++n)
+    {
+        _envelopes[n] = envelopes[order[n]];
+        _ids[n] = order[n];
+    }
+
+    // group the nodes of each level into the nodes of the next one //
+    //--------------------------------------------------------------//
+    vector<Node> level;
+    size_t first = 0;
+    while (first < _envelopes.size ())
+    {
+        Node node;
+        node.first = first;
+        node.count = std::min (nodeCapacity, _envelopes.size () - first);
+        node.envelope = _envelopes[first];
+        for (size_t n = first + 1; n < first + node.count; ++n)
+            merge (node.envelope, _envelopes[n]);
+        level.push_back (node);
+        first += node.count;
+    }
+    _levels.push_back (level);
+
+    while (_levels.back ().size () > 1)
+    {
+        vector<Node> children = _levels.back ();
+        vector<size_t> childOrder (children.size ());
+        for (size_t n = 0; n < childOrder.size (); ++n)
+            childOrder[n] = n;
+        pack (children, childOrder);
+
+        vector<Node> sortedChildren (children.size ());
+        for (size_t n = 0; n < childOrder.size (); ++n)
+            sortedChildren[n] = children[childOrder[n]];
+        _levels.back () = sortedChildren;
+
+        vector<Node> parents;
+        for (size_t start = 0; start < sortedChildren.size (); start += nodeCapacity)
+        {
+            Node node;
+            node.first = start;
+            node.count = std::min (nodeCapacity, sortedChildren.size () - start);
+            node.envelope = sortedChildren[start].envelope;
+            for (size_t n = start + 1; n < start + node.count; ++n)
+                merge (node.envelope, sortedChildren[n].envelope);
+            parents.push_back (node);
+        }
+        _levels.push_back (parents);
+    }
+}
+
+void EnvelopeIndex::pack (vector<Node>& nodes, vector<size_t>& order)
+{
+    // sort-tile-recursive: slices along x, sorted along y in each slice //
+    //--------------------------------------------------------------------//
+    vector<OGREnvelope> envelopes (nodes.size ());
+    for (size_t n = 0; n < nodes.size (); ++n)
+        envelopes[n] = nodes[n].envelope;
+
+    size_t leafCount = (nodes.size () + nodeCapacity - 1)/nodeCapacity;
+    size_t sliceCount = (size_t) ceil (sqrt ((double) leafCount));
+    size_t sliceSize = sliceCount*nodeCapacity;
+
+    CenterXLess xLess = {&envelopes};
+    CenterYLess yLess = {&envelopes};
+    std::sort (order.begin (), order.end (), xLess);
+    for (size_t first = 0; first < order.size (); first += sliceSize)
+    {
+        size_t last = std::min (first + sliceSize, order.size ());
+        std::sort (order.begin () + first, order.begin () + last, yLess);
+    }
+}
+
+size_t EnvelopeIndex::size () const
+{
+    return _envelopes.size ();
+}
+
+void EnvelopeIndex::query (const OGREnvelope& envelope, vector<size_t>& result) const
+{
+    if (_levels.empty ())
+        return;
+
+    // depth-first traversal, a stack of (level, node) pairs //
+    //-------------------------------------------------------//
+    vector<std::pair<size_t, size_t> > stack;
+    size_t top = _levels.size () - 1;
+    for (size_t n = 0; n < _levels[top].size (); ++n)
+        stack.push_back (std::make_pair (top, n));
+
+    while (!stack.empty ())
+    {
+        size_t level = stack.back ().first;
+        const Node& node = _levels[level][stack.back ().second];
+        stack.pop_back ();
+
+        if (!intersects (node.envelope, envelope))
+            continue;
+
+        if (level == 0)
+        {
+            for (size_t n = node.first; n < node.first + node.count; ++n)
+                if (intersects (_envelopes[n], envelope))
+                    result.push_back (_ids[n]);
+        }
+        else
+        {
+            for (size_t n = node.first; n < node.first + node.count; ++n)
+                stack.push_back (std::make_pair (level - 1, n));
+        }
+    }
+}
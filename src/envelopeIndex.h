@@ -0,0 +1,61 @@
+#ifndef ENVELOPEINDEX_H
+#define ENVELOPEINDEX_H
+
+#include <ogr_core.h>
+#include <vector>
+
+/**
+ * @brief A static spatial index of envelopes
+ *
+ * The index is a packed R-tree built once with the sort-tile-recursive
+ * algorithm. Queries return the positions of the indexed envelopes that
+ * intersect the query envelope.
+ */
+class EnvelopeIndex
+{
+  private:
+    struct Node
+    {
+        OGREnvelope envelope;
+        size_t      first;
+        size_t      count;
+    };
+
+    std::vector<OGREnvelope>        _envelopes;
+    std::vector<size_t>             _ids;
+    std::vector<std::vector<Node> > _levels;
+
+    static void pack (std::vector<Node>&, std::vector<size_t>&);
+
+  public:
+
+    /**
+     * @brief Maximum number of children of a node
+     */
+    static const size_t nodeCapacity = 16;
+
+    EnvelopeIndex ();
+
+    /**
+     * @brief Constructor
+     *
+     * @param envelopes The envelopes to index, their positions are the ids
+     *                  returned by queries
+     */
+    EnvelopeIndex (const std::vector<OGREnvelope>& envelopes);
+
+    size_t size () const;
+
+    /**
+     * @brief Find all envelopes intersecting the given one
+     *
+     * @param envelope The query envelope
+     * @param result   The ids of the intersecting envelopes are appended
+     */
+    void query (const OGREnvelope& envelope, std::vector<size_t>& result) const;
+
+    static bool intersects (const OGREnvelope&, const OGREnvelope&);
+    static void merge (OGREnvelope&, const OGREnvelope&);
+};
+
+#endif
@@ -0,0 +1,53 @@
+#define BOOST_TEST_MODULE EnvelopeIndex
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "envelopeIndex.h"
+
+static OGREnvelope randomEnvelope (double maxSize)
+{
+    OGREnvelope envelope;
+    envelope.MinX = 1000.0*rand ()/RAND_MAX;
+    envelope.MinY = 1000.0*rand ()/RAND_MAX;
+    envelope.MaxX = envelope.MinX + maxSize*rand ()/RAND_MAX;
+    envelope.MaxY = envelope.MinY + maxSize*rand ()/RAND_MAX;
+    return envelope;
+}
+
+BOOST_AUTO_TEST_CASE( envelopeIndex_test )
+{
+    srand (42);
+
+    // an empty index finds nothing
+    std::vector<size_t> result;
+    EnvelopeIndex empty;
+    empty.query (randomEnvelope (1000.0), result);
+    BOOST_CHECK (result.empty ());
+
+    // small and a few huge envelopes, sizes around the node capacity
+    size_t sizes[] = {1, EnvelopeIndex::nodeCapacity, EnvelopeIndex::nodeCapacity + 1, 5000};
+    for (size_t s = 0; s < 4; ++s)
+    {
+        std::vector<OGREnvelope> envelopes;
+        for (size_t n = 0; n < sizes[s]; ++n)
+            envelopes.push_back (randomEnvelope (n%100 == 0 ? 800.0 : 10.0));
+        EnvelopeIndex index (envelopes);
+        BOOST_CHECK_EQUAL (index.size (), sizes[s]);
+
+        // compare every query with a brute force search
+        for (size_t q = 0; q < 200; ++q)
+        {
+            OGREnvelope envelope = randomEnvelope (50.0);
+            std::vector<size_t> expected;
+            for (size_t n = 0; n < envelopes.size (); ++n)
+                if (EnvelopeIndex::intersects (envelopes[n], envelope))
+                    expected.push_back (n);
+
+            result.clear ();
+            index.query (envelope, result);
+            std::sort (result.begin (), result.end ());
+            BOOST_CHECK (result == expected);
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#include <sstream>
+#include <boost/multi_array.hpp>
+#include "epochs.h"
+
+using std::string;
+
+using namespace overlay;
+
+Epoch overlay::parseEpoch (string text)
+{
+    std::istringstream stream (text);
+    Epoch epoch;
+    if (   !std::getline (stream, epoch.label, ':')
+        or !std::getline (stream, epoch.directory, ':'))
+        throw EpochFormatException ();
+    std::getline (stream, epoch.filePrefix, ':');
+    std::getline (stream, epoch.changeLayer);
+
+    if (epoch.label.empty () or epoch.directory.empty ())
+        throw EpochFormatException ();
+    if (epoch.filePrefix.empty ())
+        epoch.filePrefix = ReadOptions ().filePrefix;
+    return epoch;
+}
+
+string overlay::getEpochFileName (string fileName, const Epoch& epoch)
+{
+    const string suffix (".nc");
+    if (   fileName.size () > suffix.size ()
+        and fileName.compare (fileName.size () - suffix.size (), suffix.size (), suffix) == 0)
+        return fileName.substr (0, fileName.size () - suffix.size ())
+            + "_" + epoch.label + suffix;
+    return fileName + "_" + epoch.label;
+}
+
+CellList overlay::getChangedCells (const Engine& engine, const FeatureSource& changes,
+        const GeoRaster& grid, const Window& window)
+{
+    // the change polygons are overlaid as a single class //
+    //-----------------------------------------------------//
+    FractionGrid covered (window.iSize (), window.jSize (), 1, window.i0, window.j0);
+    const CellList windowCells = getWindowCells (window);
+    if (!changes.empty () and !windowCells.empty ())
+    {
+        const Window corners = getCornerWindow (windowCells, grid.iSize (), grid.jSize ());
+        engine.addFractions (changes, grid.getCornerLattice (corners),
+                grid.getCornerLattice (corners, changes.getCoordinateSystem ()),
+                windowCells, covered);
+    }
+
+    CellList cells;
+    for (size_t j = window.j0; j < window.j1; ++j)
+        for (size_t i = window.i0; i < window.i1; ++i)
+            if (covered (i, j).size () > 0)
+            {
+                Cell cell = {i, j};
+                cells.push_back (cell);
+            }
+    return cells;
+}
+
+void overlay::copyUnchangedFractions (const FractionGrid& previous, const CellList& changed,
+        FractionGrid& fractions)
+{
+    boost::multi_array<bool, 2> skip (boost::extents[previous.jSize ()][previous.iSize ()]);
+    for (size_t n = 0; n < changed.size (); ++n)
+        skip[changed[n].j - previous.jOffset ()][changed[n].i - previous.iOffset ()] = true;
+
+    for (size_t j = 0; j < previous.jSize (); ++j)
+        for (size_t i = 0; i < previous.iSize (); ++i)
+        {
+            if (skip[j][i]) continue;
+            const size_t gridI = previous.iOffset () + i;
+            const size_t gridJ = previous.jOffset () + j;
+            const SparseFractions& cell = previous (gridI, gridJ);
+            for (size_t n = 0; n < cell.size (); ++n)
+                fractions.add (gridI, gridJ, cell.getType (n), cell.getValue (n));
+        }
+}
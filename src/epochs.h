@@ -0,0 +1,77 @@
+#ifndef EPOCHS_H
+#define EPOCHS_H
+
+#include <string>
+#include "overlay.h"
+#include "window.h"
+
+namespace overlay
+{
+
+    class EpochFormatException {};
+
+    /**
+     * @brief One edition of CORINE in a run over several editions
+     *
+     * The first epoch is computed with a full overlay. Every later epoch
+     * names the change layer since the epoch before it, e.g. the CORINE
+     * change polygons of 2000 to 2006; only the cells touched by a change
+     * polygon are computed again, the others keep their fractions.
+     */
+    struct Epoch
+    {
+        // the name of the epoch, e.g. 2006
+        std::string label;
+
+        // the directory of the shape files, or the dataset of all classes,
+        // see ReadOptions::classAttribute
+        std::string directory;
+
+        // the prefix of the shape files, see ReadOptions::filePrefix
+        std::string filePrefix;
+
+        // the polygons of the changes since the previous epoch, empty for
+        // the first epoch
+        std::string changeLayer;
+    };
+
+    /**
+     * @brief Parse an epoch given as "label:directory:prefix[:changes]"
+     */
+    Epoch parseEpoch (std::string text);
+
+    /**
+     * @brief The name of the output of one epoch, the label is inserted
+     *        before a .nc suffix, e.g. fractions_2006.nc
+     */
+    std::string getEpochFileName (std::string fileName, const Epoch& epoch);
+
+    /**
+     * @brief The cells of a window covered by the polygons of a change
+     *        layer
+     *
+     * The covered area is computed by the engine, so exactly the cells
+     * whose fractions can differ between the epochs are returned.
+     *
+     * @param engine  The engine computing the fractions
+     * @param changes The change polygons, all of class 0
+     * @param grid    The grid of the cells
+     * @param window  The cells to test
+     */
+    CellList getChangedCells (const Engine& engine, const FeatureSource& changes,
+            const GeoRaster& grid, const Window& window);
+
+    /**
+     * @brief Copy the fractions of the cells of a grid but the changed ones
+     *
+     * @param previous  The fractions of the previous epoch
+     * @param changed   The cells not copied, see getChangedCells
+     * @param fractions The fractions of the next epoch, covering the same
+     *                  window as previous
+     */
+    void copyUnchangedFractions (const FractionGrid& previous, const CellList& changed,
+            FractionGrid& fractions);
+
+}
+
+#endif
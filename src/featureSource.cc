@@ -0,0 +1,722 @@
+#include <algorithm>
+#include "featureSource.h"
+#include "geometryCodec.h"
+#include "overlay.h"
+#include "shapeFile.h"
+#include "crsRegistry.h"
+#include "stats.h"
+
+using std::string;
+using std::vector;
+
+namespace
+{
+
+    OGRLinearRing* createRing (const RingSpan& span)
+    {
+        OGRLinearRing* ring = new OGRLinearRing;
+        ring->setNumPoints (span.size ());
+        for (size_t n = 0; n < span.size (); ++n)
+            ring->setPoint (n, span.x (n), span.y (n));
+        return ring;
+    }
+
+    /**
+     * @brief The polygon of a record, holes are assigned to their outer
+     *        rings like the OGR shape file driver does
+     */
+    OGRGeometry* createGeometry (const ShapeRecord& record)
+    {
+        if (record.partCount () == 1)
+        {
+            OGRPolygon* polygon = new OGRPolygon;
+            polygon->addRingDirectly (createRing (record.getRing (0)));
+            return polygon;
+        }
+
+        vector<OGRGeometry*> polygons (record.partCount ());
+        for (size_t part = 0; part < record.partCount (); ++part)
+        {
+            OGRPolygon* polygon = new OGRPolygon;
+            polygon->addRingDirectly (createRing (record.getRing (part)));
+            polygons[part] = polygon;
+        }
+
+        int valid;
+        return OGRGeometryFactory::organizePolygons (&polygons[0], polygons.size (),
+                &valid, NULL);
+    }
+
+    /**
+     * @brief The points of a ring without the closing point
+     */
+    void addRing (const OGRLinearRing* ring, vector<Ring>& rings)
+    {
+        int count = ring->getNumPoints ();
+        if (    count > 1
+            and ring->getX (0) == ring->getX (count - 1)
+            and ring->getY (0) == ring->getY (count - 1))
+            count--;
+        if (count == 0)
+            return;
+
+        rings.push_back (Ring ());
+        for (int n = 0; n < count; ++n)
+            rings.back ().addPoint (ring->getX (n), ring->getY (n));
+    }
+
+    /**
+     * @brief The rings of the polygons of a geometry, see GeometryCodec
+     */
+    void collectRings (const OGRGeometry* geometry, vector<size_t>& ringCounts,
+            vector<Ring>& rings)
+    {
+        switch (wkbFlatten (geometry->getGeometryType ()))
+        {
+            case wkbPolygon:
+            {
+                const OGRPolygon* polygon = (const OGRPolygon*) geometry;
+                if (!polygon->getExteriorRing ())
+                    break;
+                const size_t first = rings.size ();
+                addRing (polygon->getExteriorRing (), rings);
+                if (rings.size () == first)
+                    break;
+                for (int n = 0; n < polygon->getNumInteriorRings (); ++n)
+                    addRing (polygon->getInteriorRing (n), rings);
+                ringCounts.push_back (rings.size () - first);
+                break;
+            }
+            case wkbMultiPolygon:
+            case wkbGeometryCollection:
+            {
+                const OGRGeometryCollection* collection =
+                    (const OGRGeometryCollection*) geometry;
+                for (int n = 0; n < collection->getNumGeometries (); ++n)
+                    collectRings (collection->getGeometryRef (n), ringCounts, rings);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    OGRLinearRing* createRing (const Ring& ring)
+    {
+        OGRLinearRing* result = new OGRLinearRing;
+        result->setPoints (ring.size (), const_cast<double*> (&ring.x[0]),
+                const_cast<double*> (&ring.y[0]));
+        result->closeRings ();
+        return result;
+    }
+
+    /**
+     * @brief The geometry of unpacked rings, a polygon for a single one
+     *        like the original sources return
+     */
+    OGRGeometry* createGeometry (const vector<size_t>& ringCounts, const vector<Ring>& rings)
+    {
+        OGRMultiPolygon* multiPolygon = NULL;
+        OGRPolygon* polygon = NULL;
+        size_t ring = 0;
+        for (size_t n = 0; n < ringCounts.size (); ++n)
+        {
+            polygon = new OGRPolygon;
+            for (size_t k = 0; k < ringCounts[n]; ++k)
+                polygon->addRingDirectly (createRing (rings[ring++]));
+
+            if (ringCounts.size () > 1)
+            {
+                if (!multiPolygon) multiPolygon = new OGRMultiPolygon;
+                multiPolygon->addGeometryDirectly (polygon);
+            }
+        }
+        if (multiPolygon)
+            return multiPolygon;
+        return polygon ? (OGRGeometry*) polygon : new OGRPolygon;
+    }
+
+}
+
+FeatureCursor::~FeatureCursor ()
+{}
+
+size_t FeatureCursor::getClass () const
+{
+    return 0;
+}
+
+FeatureSource::~FeatureSource ()
+{}
+
+double FeatureSource::getAreaFactor (size_t) const
+{
+    return 1.0;
+}
+
+OgrFeatureSource::OgrFeatureSource (string fileName)
+    : _fileName (fileName)
+{
+    OGRRegisterAll ();
+    OGRDataSource* dataSource = OGRSFDriverRegistrar::Open (fileName.c_str (), FALSE);
+    if (!dataSource)
+        throw ShapeFileOpenFileException ();
+    OGRLayer* layer = dataSource->GetLayer (0);
+    if (!layer)
+        throw ShapeFileGetLayerException ();
+    if (!layer->GetSpatialRef ())
+        throw ShapeFileGetSpatialRefException ();
+
+    // the registry keeps the coordinate system alive //
+    //------------------------------------------------//
+    _coordinateSystem = CrsRegistry::instance ().intern (layer->GetSpatialRef ());
+    _empty = layer->GetFeatureCount () == 0;
+
+    OGRDataSource::DestroyDataSource (dataSource);
+}
+
+OGRSpatialReference* OgrFeatureSource::getCoordinateSystem () const
+{
+    return _coordinateSystem;
+}
+
+bool OgrFeatureSource::empty () const
+{
+    return _empty;
+}
+
+FeatureCursor* OgrFeatureSource::createCursor () const
+{
+    return new OgrFeatureCursor (_fileName);
+}
+
+OgrFeatureCursor::OgrFeatureCursor (string fileName)
+{
+    if (!(_dataSource = OGRSFDriverRegistrar::Open (fileName.c_str (), FALSE)))
+        throw ShapeFileOpenFileException ();
+    if (!(_layer = _dataSource->GetLayer (0)))
+        throw ShapeFileGetLayerException ();
+}
+
+OgrFeatureCursor::~OgrFeatureCursor ()
+{
+    OGRDataSource::DestroyDataSource (_dataSource);
+}
+
+void OgrFeatureCursor::setSpatialFilter (const OGREnvelope& envelope)
+{
+    _layer->SetSpatialFilterRect (envelope.MinX, envelope.MinY,
+            envelope.MaxX, envelope.MaxY);
+    _layer->ResetReading ();
+}
+
+OGRGeometry* OgrFeatureCursor::next ()
+{
+    OGRFeature* feature;
+    while ((feature = _layer->GetNextFeature ()))
+    {
+        OGRGeometry* geometry = feature->StealGeometry ();
+        OGRFeature::DestroyFeature (feature);
+        stats::count (stats::featuresRead);
+        if (geometry)
+            return geometry;
+    }
+    return NULL;
+}
+
+OgrClassFeatureSource::OgrClassFeatureSource (string fileName, string attributeName,
+        const vector<int>& codes)
+    : _fileName (fileName), _attributeName (attributeName), _codes (codes)
+{
+    OGRRegisterAll ();
+    OGRDataSource* dataSource = OGRSFDriverRegistrar::Open (fileName.c_str (), FALSE);
+    if (!dataSource)
+        throw ShapeFileOpenFileException ();
+    OGRLayer* layer = dataSource->GetLayer (0);
+    if (!layer)
+        throw ShapeFileGetLayerException ();
+    if (!layer->GetSpatialRef ())
+        throw ShapeFileGetSpatialRefException ();
+    if (layer->GetLayerDefn ()->GetFieldIndex (attributeName.c_str ()) < 0)
+        throw ClassAttributeNotFoundException ();
+
+    _coordinateSystem = CrsRegistry::instance ().intern (layer->GetSpatialRef ());
+    _empty = layer->GetFeatureCount () == 0;
+
+    OGRDataSource::DestroyDataSource (dataSource);
+}
+
+OGRSpatialReference* OgrClassFeatureSource::getCoordinateSystem () const
+{
+    return _coordinateSystem;
+}
+
+bool OgrClassFeatureSource::empty () const
+{
+    return _empty;
+}
+
+FeatureCursor* OgrClassFeatureSource::createCursor () const
+{
+    return new OgrClassFeatureCursor (_fileName, _attributeName, _codes);
+}
+
+OgrClassFeatureCursor::OgrClassFeatureCursor (string fileName, string attributeName,
+        const vector<int>& codes)
+    : _class (0)
+{
+    if (!(_dataSource = OGRSFDriverRegistrar::Open (fileName.c_str (), FALSE)))
+        throw ShapeFileOpenFileException ();
+    if (!(_layer = _dataSource->GetLayer (0)))
+        throw ShapeFileGetLayerException ();
+
+    OGRFeatureDefn* definition = _layer->GetLayerDefn ();
+    if ((_field = definition->GetFieldIndex (attributeName.c_str ())) < 0)
+        throw ClassAttributeNotFoundException ();
+
+    // the driver skips all attributes except the code //
+    //--------------------------------------------------//
+    vector<const char*> ignored;
+    for (int field = 0; field < definition->GetFieldCount (); ++field)
+        if (field != _field)
+            ignored.push_back (definition->GetFieldDefn (field)->GetNameRef ());
+    ignored.push_back (NULL);
+    _layer->SetIgnoredFields (&ignored[0]);
+
+    for (size_t type = 0; type < codes.size (); ++type)
+        _classes[codes[type]] = type;
+}
+
+OgrClassFeatureCursor::~OgrClassFeatureCursor ()
+{
+    OGRDataSource::DestroyDataSource (_dataSource);
+}
+
+void OgrClassFeatureCursor::setSpatialFilter (const OGREnvelope& envelope)
+{
+    _layer->SetSpatialFilterRect (envelope.MinX, envelope.MinY,
+            envelope.MaxX, envelope.MaxY);
+    _layer->ResetReading ();
+}
+
+OGRGeometry* OgrClassFeatureCursor::next ()
+{
+    OGRFeature* feature;
+    while ((feature = _layer->GetNextFeature ()))
+    {
+        stats::count (stats::featuresRead);
+        std::map<int, size_t>::const_iterator type =
+            _classes.find (feature->GetFieldAsInteger (_field));
+        OGRGeometry* geometry = type != _classes.end () ? feature->StealGeometry () : NULL;
+        OGRFeature::DestroyFeature (feature);
+        if (geometry)
+        {
+            _class = type->second;
+            return geometry;
+        }
+    }
+    return NULL;
+}
+
+size_t OgrClassFeatureCursor::getClass () const
+{
+    return _class;
+}
+
+MultiClassFeatureSource::MultiClassFeatureSource ()
+{}
+
+MultiClassFeatureSource::~MultiClassFeatureSource ()
+{
+    for (size_t n = 0; n < _sources.size (); ++n)
+        delete _sources[n];
+}
+
+void MultiClassFeatureSource::add (FeatureSource* source, size_t type)
+{
+    if (!_sources.empty ()
+            and source->getCoordinateSystem () != getCoordinateSystem ())
+    {
+        delete source;
+        throw MixedCoordinateSystemsException ();
+    }
+    _sources.push_back (source);
+    _classes.push_back (type);
+}
+
+OGRSpatialReference* MultiClassFeatureSource::getCoordinateSystem () const
+{
+    return _sources.empty () ? NULL : _sources.front ()->getCoordinateSystem ();
+}
+
+bool MultiClassFeatureSource::empty () const
+{
+    for (size_t n = 0; n < _sources.size (); ++n)
+        if (!_sources[n]->empty ())
+            return false;
+    return true;
+}
+
+FeatureCursor* MultiClassFeatureSource::createCursor () const
+{
+    return new MultiClassFeatureCursor (*this);
+}
+
+double MultiClassFeatureSource::getAreaFactor (size_t type) const
+{
+    // the sources hold a single class each //
+    //---------------------------------------//
+    for (size_t n = 0; n < _sources.size (); ++n)
+        if (_classes[n] == type)
+            return _sources[n]->getAreaFactor (0);
+    return 1.0;
+}
+
+size_t MultiClassFeatureSource::size () const
+{
+    return _sources.size ();
+}
+
+const FeatureSource& MultiClassFeatureSource::getSource (size_t n) const
+{
+    return *_sources[n];
+}
+
+size_t MultiClassFeatureSource::getClass (size_t n) const
+{
+    return _classes[n];
+}
+
+MultiClassFeatureCursor::MultiClassFeatureCursor (const MultiClassFeatureSource& source)
+    : _source (source), _cursors (source.size ()), _current (0)
+{
+    for (size_t n = 0; n < _cursors.size (); ++n)
+        _cursors[n] = source.getSource (n).createCursor ();
+}
+
+MultiClassFeatureCursor::~MultiClassFeatureCursor ()
+{
+    for (size_t n = 0; n < _cursors.size (); ++n)
+        delete _cursors[n];
+}
+
+void MultiClassFeatureCursor::setSpatialFilter (const OGREnvelope& envelope)
+{
+    for (size_t n = 0; n < _cursors.size (); ++n)
+        _cursors[n]->setSpatialFilter (envelope);
+    _current = 0;
+}
+
+OGRGeometry* MultiClassFeatureCursor::next ()
+{
+    for (; _current < _cursors.size (); ++_current)
+    {
+        OGRGeometry* geometry = _cursors[_current]->next ();
+        if (geometry)
+            return geometry;
+    }
+    return NULL;
+}
+
+size_t MultiClassFeatureCursor::getClass () const
+{
+    return _source.getClass (_current);
+}
+
+MappedFeatureSource::MappedFeatureSource (string fileName)
+    : _file (fileName)
+{
+    // the coordinate system is read once through OGR //
+    //-------------------------------------------------//
+    OGRRegisterAll ();
+    OGRDataSource* dataSource = OGRSFDriverRegistrar::Open (fileName.c_str (), FALSE);
+    if (!dataSource)
+        throw ShapeFileOpenFileException ();
+    OGRLayer* layer = dataSource->GetLayer (0);
+    if (!layer)
+        throw ShapeFileGetLayerException ();
+    if (!layer->GetSpatialRef ())
+        throw ShapeFileGetSpatialRefException ();
+    _coordinateSystem = CrsRegistry::instance ().intern (layer->GetSpatialRef ());
+    OGRDataSource::DestroyDataSource (dataSource);
+
+    vector<OGREnvelope> envelopes;
+    _file.getEnvelopes (0, _file.size (), envelopes, _ids);
+    _index = EnvelopeIndex (envelopes);
+}
+
+OGRSpatialReference* MappedFeatureSource::getCoordinateSystem () const
+{
+    return _coordinateSystem;
+}
+
+bool MappedFeatureSource::empty () const
+{
+    return _ids.empty ();
+}
+
+FeatureCursor* MappedFeatureSource::createCursor () const
+{
+    return new MappedFeatureCursor (*this, 0, _file.size ());
+}
+
+FeatureCursor* MappedFeatureSource::createCursor (size_t first, size_t last) const
+{
+    return new MappedFeatureCursor (*this, first, std::min (last, _file.size ()));
+}
+
+const MappedShapeFile& MappedFeatureSource::getFile () const
+{
+    return _file;
+}
+
+void MappedFeatureSource::query (const OGREnvelope& envelope, size_t first, size_t last,
+        vector<size_t>& records) const
+{
+    vector<size_t> found;
+    _index.query (envelope, found);
+    for (size_t n = 0; n < found.size (); ++n)
+    {
+        size_t record = _ids[found[n]];
+        if (record >= first and record < last)
+            records.push_back (record);
+    }
+
+    // the order of the file, like OGR //
+    //----------------------------------//
+    std::sort (records.begin (), records.end ());
+}
+
+MappedFeatureCursor::MappedFeatureCursor (const MappedFeatureSource& source,
+        size_t first, size_t last)
+    : _source (source), _first (first), _last (last), _position (0)
+{
+    // without a filter all records of the range are read //
+    //-----------------------------------------------------//
+    for (size_t record = first; record < last; ++record)
+        _records.push_back (record);
+}
+
+void MappedFeatureCursor::setSpatialFilter (const OGREnvelope& envelope)
+{
+    _records.clear ();
+    _source.query (envelope, _first, _last, _records);
+    _position = 0;
+}
+
+OGRGeometry* MappedFeatureCursor::next ()
+{
+    while (_position < _records.size ())
+    {
+        ShapeRecord record = _source.getFile ().getRecord (_records[_position++]);
+        stats::count (stats::featuresRead);
+        if (!record.empty ())
+            return createGeometry (record);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Returns the geometries of a MemoryFeatureSource, packed ones
+ *        unpacked into buffers of the cursor
+ */
+class MemoryFeatureCursor : public FeatureCursor
+{
+  private:
+    const MemoryFeatureSource& _source;
+    std::vector<size_t>        _ids;
+    size_t                     _position;
+    std::vector<size_t>        _ringCounts;
+    std::vector<Ring>          _rings;
+  public:
+    MemoryFeatureCursor (const MemoryFeatureSource&);
+    void setSpatialFilter (const OGREnvelope&);
+    OGRGeometry* next ();
+    size_t getClass () const;
+};
+
+MemoryFeatureSource::MemoryFeatureSource (OGRSpatialReference* coordinateSystem,
+        double resolution)
+    : _resolution (resolution),
+      _packed (resolution > 0.0),
+      _pointCount (0),
+      _coordinateSystem (coordinateSystem)
+{}
+
+MemoryFeatureSource::~MemoryFeatureSource ()
+{
+    clear ();
+}
+
+void MemoryFeatureSource::add (OGRGeometry* geometry, size_t type)
+{
+    OGREnvelope envelope;
+    geometry->getEnvelope (&envelope);
+    if (!_packed)
+    {
+        _pointCount += overlay::getPointCount (geometry);
+        _geometries.push_back (geometry);
+        _classes.push_back (type);
+        _envelopes.push_back (envelope);
+        return;
+    }
+
+    // packed one by one, empty geometries are dropped //
+    //--------------------------------------------------//
+    vector<size_t> ringCounts;
+    vector<Ring> rings;
+    collectRings (geometry, ringCounts, rings);
+    OGRGeometryFactory::destroyGeometry (geometry);
+    if (rings.empty ())
+        return;
+
+    // the envelope allows for the rounding //
+    //---------------------------------------//
+    envelope.MinX -= _resolution;
+    envelope.MinY -= _resolution;
+    envelope.MaxX += _resolution;
+    envelope.MaxY += _resolution;
+
+    _offsets.push_back (_data.size ());
+    GeometryCodec (_resolution).encode (ringCounts, rings, _data);
+    // with the closing points, like the unpacked rings //
+    //--------------------------------------------------//
+    for (size_t n = 0; n < rings.size (); ++n)
+        _pointCount += rings[n].size () + 1;
+    _classes.push_back (type);
+    _envelopes.push_back (envelope);
+}
+
+void MemoryFeatureSource::clear ()
+{
+    for (size_t n = 0; n < _geometries.size (); ++n)
+        OGRGeometryFactory::destroyGeometry (_geometries[n]);
+    _geometries.clear ();
+    _data.clear ();
+    _offsets.clear ();
+    _classes.clear ();
+    _envelopes.clear ();
+    _pointCount = 0;
+}
+
+void MemoryFeatureSource::buildIndex ()
+{
+    // only the index keeps the envelopes //
+    //-------------------------------------//
+    _index = EnvelopeIndex (_envelopes);
+    vector<OGREnvelope> ().swap (_envelopes);
+    vector<unsigned char> (_data).swap (_data);
+}
+
+void MemoryFeatureSource::copyAreaFactors (const FeatureSource& source)
+{
+    size_t typeCount = 0;
+    for (size_t n = 0; n < _classes.size (); ++n)
+        typeCount = std::max (typeCount, _classes[n] + 1);
+    _areaFactors.resize (typeCount);
+    for (size_t type = 0; type < typeCount; ++type)
+        _areaFactors[type] = source.getAreaFactor (type);
+}
+
+OGRSpatialReference* MemoryFeatureSource::getCoordinateSystem () const
+{
+    return _coordinateSystem;
+}
+
+bool MemoryFeatureSource::empty () const
+{
+    return _classes.empty ();
+}
+
+FeatureCursor* MemoryFeatureSource::createCursor () const
+{
+    return new MemoryFeatureCursor (*this);
+}
+
+double MemoryFeatureSource::getAreaFactor (size_t type) const
+{
+    return type < _areaFactors.size () ? _areaFactors[type] : 1.0;
+}
+
+size_t MemoryFeatureSource::size () const
+{
+    return _classes.size ();
+}
+
+size_t MemoryFeatureSource::getClass (size_t n) const
+{
+    return _classes[n];
+}
+
+OGRGeometry* MemoryFeatureSource::createGeometry (size_t n, vector<size_t>& ringCounts,
+        vector<Ring>& rings) const
+{
+    if (!_packed)
+        return _geometries[n]->clone ();
+    GeometryCodec (_resolution).decode (&_data[_offsets[n]], ringCounts, rings);
+    return ::createGeometry (ringCounts, rings);
+}
+
+OGRGeometry* MemoryFeatureSource::createGeometry (size_t n) const
+{
+    vector<size_t> ringCounts;
+    vector<Ring> rings;
+    return createGeometry (n, ringCounts, rings);
+}
+
+void MemoryFeatureSource::query (const OGREnvelope& envelope, vector<size_t>& ids) const
+{
+    _index.query (envelope, ids);
+    std::sort (ids.begin (), ids.end ());
+}
+
+bool MemoryFeatureSource::isPacked () const
+{
+    return _packed;
+}
+
+size_t MemoryFeatureSource::getPointCount () const
+{
+    return _pointCount;
+}
+
+size_t MemoryFeatureSource::getByteCount () const
+{
+    return _data.size ();
+}
+
+MemoryFeatureCursor::MemoryFeatureCursor (const MemoryFeatureSource& source)
+    : _source (source), _ids (source.size ()), _position (0)
+{
+    for (size_t n = 0; n < _ids.size (); ++n)
+        _ids[n] = n;
+}
+
+void MemoryFeatureCursor::setSpatialFilter (const OGREnvelope& envelope)
+{
+    _ids.clear ();
+    _source.query (envelope, _ids);
+    _position = 0;
+}
+
+OGRGeometry* MemoryFeatureCursor::next ()
+{
+    if (_position >= _ids.size ())
+        return NULL;
+    stats::count (stats::featuresRead);
+    return _source.createGeometry (_ids[_position++], _ringCounts, _rings);
+}
+
+size_t MemoryFeatureCursor::getClass () const
+{
+    return _position > 0 ? _source.getClass (_ids[_position - 1]) : 0;
+}
+
+FeatureSource* createFeatureSource (string reader, string fileName)
+{
+    if (reader == "ogr")
+        return new OgrFeatureSource (fileName);
+    if (reader == "mapped")
+        return new MappedFeatureSource (fileName);
+    throw UnknownReaderException ();
+}
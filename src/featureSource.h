@@ -0,0 +1,353 @@
+#ifndef FEATURESOURCE_H
+#define FEATURESOURCE_H
+
+#include <ogrsf_frmts.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "mappedShapeFile.h"
+#include "envelopeIndex.h"
+
+struct Ring;
+
+/**
+ * @brief Sequential access to the geometries of a FeatureSource
+ *
+ * A cursor is used by a single thread only.
+ */
+class FeatureCursor
+{
+  public:
+    virtual ~FeatureCursor ();
+
+    /**
+     * @brief Restrict the following geometries to the ones whose envelope
+     *        intersects the given one, and restart reading
+     */
+    virtual void setSpatialFilter (const OGREnvelope&) = 0;
+
+    /**
+     * @brief The next geometry passing the filter
+     *
+     * @return A geometry owned by the caller, or NULL at the end
+     */
+    virtual OGRGeometry* next () = 0;
+
+    /**
+     * @brief The class of the geometry returned last by next
+     *
+     * Sources of a single class return 0.
+     */
+    virtual size_t getClass () const;
+};
+
+/**
+ * @brief A set of polygons in one coordinate system
+ *
+ * The source itself is shared between threads, each thread reads through
+ * its own cursor.
+ */
+class FeatureSource
+{
+  public:
+    virtual ~FeatureSource ();
+    virtual OGRSpatialReference* getCoordinateSystem () const = 0;
+    virtual bool empty () const = 0;
+
+    /**
+     * @return A new cursor owned by the caller
+     */
+    virtual FeatureCursor* createCursor () const = 0;
+
+    /**
+     * @brief The factor the fractions of a class are corrected with
+     *
+     * Sources whose polygons do not keep their area, like simplified ones,
+     * return the ratio of the original to their area of the class. The
+     * default is 1.0.
+     */
+    virtual double getAreaFactor (size_t type) const;
+};
+
+/**
+ * @brief The first layer of an OGR data source, e.g. a shape file
+ */
+class OgrFeatureSource : public FeatureSource
+{
+  private:
+    std::string          _fileName;
+    OGRSpatialReference* _coordinateSystem;
+    bool                 _empty;
+  public:
+    OgrFeatureSource (std::string);
+    OGRSpatialReference* getCoordinateSystem () const;
+    bool empty () const;
+    FeatureCursor* createCursor () const;
+};
+
+class OgrFeatureCursor : public FeatureCursor
+{
+  private:
+    OGRDataSource* _dataSource;
+    OGRLayer*      _layer;
+  public:
+    OgrFeatureCursor (std::string);
+    ~OgrFeatureCursor ();
+    void setSpatialFilter (const OGREnvelope&);
+    OGRGeometry* next ();
+};
+
+/**
+ * @brief The first layer of an OGR data source holding all classes, e.g. a
+ *        GeoPackage, told apart by an integer code attribute
+ *
+ * Only the code attribute is read, all other attributes are ignored by the
+ * driver. Features with unknown codes are skipped.
+ */
+class OgrClassFeatureSource : public FeatureSource
+{
+  private:
+    std::string          _fileName;
+    std::string          _attributeName;
+    std::vector<int>     _codes;
+    OGRSpatialReference* _coordinateSystem;
+    bool                 _empty;
+  public:
+
+    /**
+     * @param fileName      The name of the data source
+     * @param attributeName The name of the code attribute
+     * @param codes         The code of each class
+     */
+    OgrClassFeatureSource (std::string fileName, std::string attributeName,
+            const std::vector<int>& codes);
+    OGRSpatialReference* getCoordinateSystem () const;
+    bool empty () const;
+    FeatureCursor* createCursor () const;
+};
+
+class OgrClassFeatureCursor : public FeatureCursor
+{
+  private:
+    OGRDataSource*         _dataSource;
+    OGRLayer*              _layer;
+    int                    _field;
+    std::map<int, size_t>  _classes;
+    size_t                 _class;
+  public:
+    OgrClassFeatureCursor (std::string, std::string, const std::vector<int>&);
+    ~OgrClassFeatureCursor ();
+    void setSpatialFilter (const OGREnvelope&);
+    OGRGeometry* next ();
+    size_t getClass () const;
+};
+
+/**
+ * @brief The polygons of several sources, each holding one class
+ *
+ * One pass over the cells reads all classes, instead of one pass per
+ * class. All sources use the same coordinate system.
+ */
+class MultiClassFeatureSource : public FeatureSource
+{
+  private:
+    std::vector<FeatureSource*> _sources;
+    std::vector<size_t>         _classes;
+
+    MultiClassFeatureSource (const MultiClassFeatureSource&);
+    MultiClassFeatureSource& operator= (const MultiClassFeatureSource&);
+
+  public:
+    MultiClassFeatureSource ();
+    ~MultiClassFeatureSource ();
+
+    /**
+     * @brief Add the source of a class, owned by this source afterwards
+     */
+    void add (FeatureSource* source, size_t type);
+
+    OGRSpatialReference* getCoordinateSystem () const;
+    bool empty () const;
+    FeatureCursor* createCursor () const;
+    double getAreaFactor (size_t) const;
+
+    size_t size () const;
+    const FeatureSource& getSource (size_t) const;
+    size_t getClass (size_t) const;
+};
+
+class MultiClassFeatureCursor : public FeatureCursor
+{
+  private:
+    const MultiClassFeatureSource& _source;
+    std::vector<FeatureCursor*>    _cursors;
+    size_t                         _current;
+  public:
+    MultiClassFeatureCursor (const MultiClassFeatureSource&);
+    ~MultiClassFeatureCursor ();
+    void setSpatialFilter (const OGREnvelope&);
+    OGRGeometry* next ();
+    size_t getClass () const;
+};
+
+class MixedCoordinateSystemsException {};
+class ClassAttributeNotFoundException {};
+
+/**
+ * @brief The polygons of a shape file read directly from the mapped file
+ *
+ * Skips the attributes and the feature objects of OGR, only the geometry
+ * handed out is created. The records are found through a spatial index of
+ * their envelopes, built when the source is opened.
+ */
+class MappedFeatureSource : public FeatureSource
+{
+  private:
+    MappedShapeFile      _file;
+    OGRSpatialReference* _coordinateSystem;
+    std::vector<size_t>  _ids;
+    EnvelopeIndex        _index;
+  public:
+    MappedFeatureSource (std::string);
+    OGRSpatialReference* getCoordinateSystem () const;
+    bool empty () const;
+    FeatureCursor* createCursor () const;
+
+    /**
+     * @brief A cursor reading only the records first <= n < last
+     *
+     * Cursors of disjoint ranges decode different parts of the file, e.g.
+     * in different threads.
+     */
+    FeatureCursor* createCursor (size_t first, size_t last) const;
+
+    const MappedShapeFile& getFile () const;
+
+    /**
+     * @brief The numbers of the records in a range whose envelopes
+     *        intersect the given one, in ascending order
+     */
+    void query (const OGREnvelope&, size_t first, size_t last,
+            std::vector<size_t>& records) const;
+};
+
+class MappedFeatureCursor : public FeatureCursor
+{
+  private:
+    const MappedFeatureSource& _source;
+    size_t                     _first;
+    size_t                     _last;
+    std::vector<size_t>        _records;
+    size_t                     _position;
+  public:
+    MappedFeatureCursor (const MappedFeatureSource&, size_t first, size_t last);
+    void setSpatialFilter (const OGREnvelope&);
+    OGRGeometry* next ();
+};
+
+/**
+ * @brief Polygons held in memory behind a spatial index of their envelopes
+ *
+ * Base of sources which prepare all polygons of another source once. With a
+ * resolution the polygons are packed by a GeometryCodec as they are added,
+ * which takes about a tenth of the memory of OGR geometries, so a source
+ * preparing the polygons batch by batch never holds all of them unpacked.
+ * Every cursor unpacks the polygons it returns into its own buffers, so the
+ * threads of an engine share the packed data without synchronisation.
+ */
+class MemoryFeatureSource : public FeatureSource
+{
+  private:
+    double                     _resolution;
+    bool                       _packed;
+    std::vector<OGRGeometry*>  _geometries;
+    std::vector<unsigned char> _data;
+    std::vector<size_t>        _offsets;
+    std::vector<OGREnvelope>   _envelopes;
+    size_t                     _pointCount;
+
+    MemoryFeatureSource (const MemoryFeatureSource&);
+    MemoryFeatureSource& operator= (const MemoryFeatureSource&);
+
+  protected:
+    OGRSpatialReference*      _coordinateSystem;
+    std::vector<size_t>       _classes;
+    std::vector<double>       _areaFactors;
+    EnvelopeIndex             _index;
+
+    /**
+     * @brief Append a geometry of a class, owned by the source afterwards
+     */
+    void add (OGRGeometry*, size_t type);
+
+    /**
+     * @brief Remove all geometries
+     */
+    void clear ();
+
+    /**
+     * @brief Index the geometries, called once they are complete
+     */
+    void buildIndex ();
+
+    /**
+     * @brief Take the area factors of the classes held from another source
+     */
+    void copyAreaFactors (const FeatureSource&);
+
+  public:
+
+    /**
+     * @param coordinateSystem The coordinate system of the polygons
+     * @param resolution       The rounding of the coordinates of packed
+     *                         polygons, see GeometryCodec; 0.0 to keep the
+     *                         geometries as they are
+     */
+    MemoryFeatureSource (OGRSpatialReference* coordinateSystem, double resolution = 0.0);
+    ~MemoryFeatureSource ();
+    OGRSpatialReference* getCoordinateSystem () const;
+    bool empty () const;
+    FeatureCursor* createCursor () const;
+    double getAreaFactor (size_t) const;
+
+    size_t size () const;
+    size_t getClass (size_t) const;
+
+    /**
+     * @brief A copy of a geometry, owned by the caller
+     *
+     * Packed geometries are unpacked into the given buffers, see
+     * GeometryCodec::decode.
+     */
+    OGRGeometry* createGeometry (size_t, std::vector<size_t>& ringCounts,
+            std::vector<Ring>& rings) const;
+    OGRGeometry* createGeometry (size_t) const;
+
+    /**
+     * @brief The numbers of the geometries whose envelopes intersect the
+     *        given one, in ascending order
+     */
+    void query (const OGREnvelope&, std::vector<size_t>&) const;
+
+    bool isPacked () const;
+    size_t getPointCount () const;
+
+    /**
+     * @brief Bytes of the packed geometries, 0 if they are not packed
+     */
+    size_t getByteCount () const;
+};
+
+class UnknownReaderException {};
+
+/**
+ * @brief Open a shape file with the given reader
+ *
+ * @param reader   "ogr" or "mapped"
+ * @param fileName The name of the shape file
+ *
+ * @return A new source owned by the caller
+ */
+FeatureSource* createFeatureSource (std::string reader, std::string fileName);
+
+#endif
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <boost/multi_array.hpp>
+#include "fractionFile.h"
+#include "corine.h"
+#include "wrf.h"
+
+using std::string;
+
+using namespace overlay;
+
+const int FractionFile::deflateLevel;
+const size_t FractionFile::bandSize;
+
+namespace
+{
+    const char* fractionName = "CORINE_FRACTION";
+    const char* codeName = "CORINE_CODE";
+    const char* classDimensionName = "corine_class";
+    const char* windowI0Name = "WINDOW_I0";
+    const char* windowJ0Name = "WINDOW_J0";
+    const char* parentISizeName = "PARENT_WEST_EAST";
+    const char* parentJSizeName = "PARENT_SOUTH_NORTH";
+
+    size_t getSizeAttribute (NcFile& file, const char* name)
+    {
+        boost::scoped_ptr<NcAtt> attribute (file.get_att (name));
+        if (!attribute)
+            throw WrongFractionFileException ();
+        return attribute->as_int (0);
+    }
+}
+
+FractionFile::FractionFile (string fileName, const Window& window,
+        size_t parentISize, size_t parentJSize)
+    : NcFile (fileName.c_str (), Replace, NULL, 0, Netcdf4),
+      _window (window),
+      _parentISize (parentISize),
+      _parentJSize (parentJSize),
+      _errorBehavior (new NcError (NcError::silent_nonfatal))
+{
+    if (!is_valid ())
+        throw WrongFractionFileException ();
+
+    const NcDim* dims[3];
+    dims[0] = add_dim (classDimensionName, corine::typeCount);
+    dims[1] = add_dim ("south_north", window.jSize ());
+    dims[2] = add_dim ("west_east", window.iSize ());
+
+    add_att (windowI0Name, (int) window.i0);
+    add_att (windowJ0Name, (int) window.j0);
+    add_att (parentISizeName, (int) parentISize);
+    add_att (parentJSizeName, (int) parentJSize);
+
+    // the codes identify the planes, files of another class table are
+    // rejected when read
+    NcVar* codes = add_var (codeName, ncInt, dims[0]);
+    NcVar* fractions = add_var (fractionName, ncFloat, 3, dims);
+    if (!codes or !fractions)
+        throw wrf::VariableNotExistException ();
+    fractions->add_att ("units", "1");
+
+#ifdef NC_NETCDF4
+    // one chunk is a band of rows of one class, most of them are all zero //
+    //----------------------------------------------------------------------//
+    size_t chunks[3] = {1, std::min (bandSize, window.jSize ()), window.iSize ()};
+    if (   nc_def_var_chunking (id (), fractions->id (), NC_CHUNKED, chunks) != NC_NOERR
+        or nc_def_var_deflate (id (), fractions->id (), 1, 1, deflateLevel) != NC_NOERR)
+        throw WrongFractionFileException ();
+#endif
+
+    int values[corine::typeCount];
+    for (size_t type = 0; type < corine::typeCount; ++type)
+        values[type] = corine::getCode (type);
+    codes->put (values, corine::typeCount);
+}
+
+FractionFile::FractionFile (string fileName)
+    : NcFile (fileName.c_str (), ReadOnly),
+      _errorBehavior (new NcError (NcError::silent_nonfatal))
+{
+    if (!is_valid ())
+        throw WrongFractionFileException ();
+
+    NcDim* classDimension = get_dim (classDimensionName);
+    NcDim* iDimension = get_dim ("west_east");
+    NcDim* jDimension = get_dim ("south_north");
+    if (classDimension == NULL or iDimension == NULL or jDimension == NULL)
+        throw WrongFractionFileException ();
+
+    _window.i0 = getSizeAttribute (*this, windowI0Name);
+    _window.j0 = getSizeAttribute (*this, windowJ0Name);
+    _window.i1 = _window.i0 + iDimension->size ();
+    _window.j1 = _window.j0 + jDimension->size ();
+    _parentISize = getSizeAttribute (*this, parentISizeName);
+    _parentJSize = getSizeAttribute (*this, parentJSizeName);
+
+    if (_window.i1 > _parentISize or _window.j1 > _parentJSize)
+        throw WrongFractionFileException ();
+
+    // the planes must be the classes of this program, in the same order //
+    //--------------------------------------------------------------------//
+    NcVar* codes = get_var (codeName);
+    if (!codes or classDimension->size () != (long) corine::typeCount)
+        throw WrongFractionFileException ();
+    int values[corine::typeCount];
+    codes->get (values, corine::typeCount);
+    for (size_t type = 0; type < corine::typeCount; ++type)
+        if (values[type] != corine::getCode (type))
+            throw WrongFractionFileException ();
+}
+
+FractionFile::~FractionFile ()
+{
+    close ();
+}
+
+const Window& FractionFile::getWindow () const
+{
+    return _window;
+}
+
+size_t FractionFile::parentISize () const
+{
+    return _parentISize;
+}
+
+size_t FractionFile::parentJSize () const
+{
+    return _parentJSize;
+}
+
+NcVar* FractionFile::getVariable ()
+{
+    NcVar* variable = get_var (fractionName);
+    if (!variable)
+        throw wrf::VariableNotExistException ();
+    return variable;
+}
+
+void FractionFile::write (const FractionGrid& fractions)
+{
+    const Window window = getGridWindow (fractions);
+
+    // the sparse cells are made dense one band of rows at a time //
+    //-------------------------------------------------------------//
+    NcVar* variable = getVariable ();
+    const size_t iCount = window.iSize ();
+    for (size_t jFirst = window.j0; jFirst < window.j1; jFirst += bandSize)
+    {
+        const size_t jCount = std::min (bandSize, window.j1 - jFirst);
+        boost::multi_array<float, 3> planes (
+                boost::extents[corine::typeCount][jCount][iCount]);
+        for (size_t j = 0; j < jCount; ++j)
+            for (size_t i = 0; i < iCount; ++i)
+            {
+                const SparseFractions& cell = fractions (window.i0 + i, jFirst + j);
+                for (size_t n = 0; n < cell.size (); ++n)
+                    planes[cell.getType (n)][j][i] = cell.getValue (n);
+            }
+
+        variable->set_cur (0, jFirst - _window.j0, window.i0 - _window.i0);
+        if (!variable->put (planes.data (), corine::typeCount, jCount, iCount))
+            throw WrongFractionFileException ();
+    }
+}
+
+void FractionFile::read (FractionGrid& fractions)
+{
+    const Window window = getGridWindow (fractions);
+
+    NcVar* variable = getVariable ();
+    const size_t iCount = window.iSize ();
+    for (size_t jFirst = window.j0; jFirst < window.j1; jFirst += bandSize)
+    {
+        const size_t jCount = std::min (bandSize, window.j1 - jFirst);
+        boost::multi_array<float, 3> planes (
+                boost::extents[corine::typeCount][jCount][iCount]);
+        variable->set_cur (0, jFirst - _window.j0, window.i0 - _window.i0);
+        if (!variable->get (planes.data (), corine::typeCount, jCount, iCount))
+            throw WrongFractionFileException ();
+
+        // only the non-zero fractions are stored in the sparse cells //
+        //-------------------------------------------------------------//
+        for (size_t type = 0; type < corine::typeCount; ++type)
+            for (size_t j = 0; j < jCount; ++j)
+                for (size_t i = 0; i < iCount; ++i)
+                    if (planes[type][j][i] != 0.0f)
+                        fractions.add (window.i0 + i, jFirst + j, type, planes[type][j][i]);
+    }
+}
+
+Window FractionFile::getGridWindow (const FractionGrid& fractions) const
+{
+    Window window = {fractions.iOffset (), fractions.iOffset () + fractions.iSize (),
+                     fractions.jOffset (), fractions.jOffset () + fractions.jSize ()};
+    if (   window.i0 < _window.i0 or window.i1 > _window.i1
+        or window.j0 < _window.j0 or window.j1 > _window.j1
+        or fractions.typeCount () != corine::typeCount)
+        throw wrf::WrongDimensionSizeException ();
+    return window;
+}
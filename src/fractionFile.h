@@ -0,0 +1,88 @@
+#ifndef FRACTIONFILE_H
+#define FRACTIONFILE_H
+
+#include <netcdfcpp.h>
+#include <string>
+#include <boost/scoped_ptr.hpp>
+#include "overlay.h"
+#include "window.h"
+
+namespace overlay
+{
+
+    class WrongFractionFileException {};
+
+    /**
+     * @brief The CORINE fractions of a window of a WRF grid, the result of
+     *        the overlay
+     *
+     * The fractions of all classes are stored in one variable with a plane
+     * per class. The file is written in the NetCDF-4 format, the planes are
+     * mostly zero and are compressed. The window and the size of the whole
+     * grid are stored as global attributes, like in a wrf::PartialFile, so
+     * a window can be remapped to the CLM fractions on its own.
+     */
+    class FractionFile : public NcFile
+    {
+      private:
+        Window _window;
+        size_t _parentISize;
+        size_t _parentJSize;
+        boost::scoped_ptr<NcError> _errorBehavior;
+
+        NcVar* getVariable ();
+        Window getGridWindow (const FractionGrid&) const;
+
+      public:
+
+        /**
+         * @brief Level of the deflate compression of the fractions
+         */
+        static const int deflateLevel = 4;
+
+        /**
+         * @brief Number of rows read or written at once
+         */
+        static const size_t bandSize = 64;
+
+        /**
+         * @brief Create a fraction file, replacing an existing one
+         *
+         * @param fileName    Name of the new file
+         * @param window      The window of the fractions
+         * @param parentISize Size of the whole grid along i
+         * @param parentJSize Size of the whole grid along j
+         */
+        FractionFile (std::string fileName, const Window& window,
+                size_t parentISize, size_t parentJSize);
+
+        /**
+         * @brief Open an existing fraction file for reading
+         */
+        FractionFile (std::string fileName);
+        ~FractionFile ();
+
+        const Window& getWindow () const;
+        size_t parentISize () const;
+        size_t parentJSize () const;
+
+        /**
+         * @brief Write the fractions of the cells of a grid
+         *
+         * @param fractions Fractions of corine::typeCount classes, the grid
+         *                  may cover a part of the window
+         */
+        void write (const FractionGrid& fractions);
+
+        /**
+         * @brief Add the stored fractions of the cells of a grid
+         *
+         * @param fractions Fractions of corine::typeCount classes, the grid
+         *                  may cover a part of the window
+         */
+        void read (FractionGrid& fractions);
+    };
+
+}
+
+#endif
@@ -24,6 +24,11 @@ void Fractions::check () const
     if (missing () < -1e-6) throw FractionInconsistent ();
 }
     
+size_t Fractions::size () const
+{
+    return _typeCount;
+}
+
 const double& Fractions::operator[] (size_t index) const
 {
     if (index >= _typeCount) throw FractionOutOfRange ();
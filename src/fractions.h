@@ -35,6 +35,13 @@ class Fractions
          */
         void check () const;
 
+        /**
+         * @brief 
+         *
+         * @return The amount of types
+         */
+        size_t size () const;
+
         /**
          * @brief 
          *
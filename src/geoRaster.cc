@@ -1,9 +1,119 @@
 #include <gdal_priv.h>
+#include <algorithm>
+#include <cmath>
 #include "geoRaster.h"
 #include "clm.h"
+#include "crsRegistry.h"
 
 using namespace std;
 
+CornerLattice::CornerLattice ()
+    : _i0 (0), _j0 (0), _iSize (0), _jSize (0), _coordinateSystem (NULL)
+{}
+
+CornerLattice::CornerLattice (const Window& window, OGRSpatialReference* coordinateSystem)
+    : _i0 (window.i0), _j0 (window.j0), _iSize (window.iSize ()), _jSize (window.jSize ()),
+      _x ((_iSize + 1)*(_jSize + 1)), _y ((_iSize + 1)*(_jSize + 1)),
+      _coordinateSystem (coordinateSystem)
+{}
+
+size_t CornerLattice::i0 () const
+{
+    return _i0;
+}
+
+size_t CornerLattice::j0 () const
+{
+    return _j0;
+}
+
+size_t CornerLattice::iSize () const
+{
+    return _iSize;
+}
+
+size_t CornerLattice::jSize () const
+{
+    return _jSize;
+}
+
+double CornerLattice::getX (size_t ci, size_t cj) const
+{
+    return _x[(cj - _j0)*(_iSize + 1) + ci - _i0];
+}
+
+double CornerLattice::getY (size_t ci, size_t cj) const
+{
+    return _y[(cj - _j0)*(_iSize + 1) + ci - _i0];
+}
+
+OGRSpatialReference* CornerLattice::getCoordinateSystem () const
+{
+    return _coordinateSystem;
+}
+
+// offsets of the corners of a cell, counter-clockwise
+static const size_t cornerOffsetI[4] = {0, 1, 1, 0};
+static const size_t cornerOffsetJ[4] = {0, 0, 1, 1};
+
+CellView::CellView (const CornerLattice& lattice, size_t i, size_t j)
+    : _lattice (&lattice), _i (i), _j (j)
+{
+    if (   i < lattice.i0 () or i >= lattice.i0 () + lattice.iSize ()
+        or j < lattice.j0 () or j >= lattice.j0 () + lattice.jSize ())
+        throw OutOfDomainException ();
+}
+
+double CellView::getX (size_t corner) const
+{
+    return _lattice->getX (_i + cornerOffsetI[corner], _j + cornerOffsetJ[corner]);
+}
+
+double CellView::getY (size_t corner) const
+{
+    return _lattice->getY (_i + cornerOffsetI[corner], _j + cornerOffsetJ[corner]);
+}
+
+double CellView::getArea () const
+{
+    double area = 0.0;
+    for (size_t corner = 0; corner < 4; ++corner)
+    {
+        size_t next = (corner + 1)%4;
+        area += getX (corner)*getY (next) - getX (next)*getY (corner);
+    }
+    return fabs (area)/2.0;
+}
+
+void CellView::getEnvelope (OGREnvelope* envelope) const
+{
+    envelope->MinX = envelope->MaxX = getX (0);
+    envelope->MinY = envelope->MaxY = getY (0);
+    for (size_t corner = 1; corner < 4; ++corner)
+    {
+        envelope->MinX = min (envelope->MinX, getX (corner));
+        envelope->MaxX = max (envelope->MaxX, getX (corner));
+        envelope->MinY = min (envelope->MinY, getY (corner));
+        envelope->MaxY = max (envelope->MaxY, getY (corner));
+    }
+}
+
+void CellView::fillPolygon (OGRPolygon& polygon) const
+{
+    // reuse the ring of the polygon, if there is one //
+    //------------------------------------------------//
+    OGRLinearRing* ring = polygon.getExteriorRing ();
+    if (!ring)
+    {
+        ring = new OGRLinearRing ();
+        polygon.addRingDirectly (ring);
+    }
+    ring->setNumPoints (5);
+    for (size_t corner = 0; corner < 4; ++corner)
+        ring->setPoint (corner, getX (corner), getY (corner));
+    ring->setPoint (4, getX (0), getY (0));
+}
+
 GeoRaster::GeoRaster ()
 {
     _coordinateSystem = new OGRSpatialReference ();
@@ -13,6 +123,16 @@ GeoRaster::~GeoRaster ()
 {
     _coordinateSystem->Release ();
 }
+
+void GeoRaster::internCoordinateSystem ()
+{
+    // the destructor releases the reference like the own object //
+    //------------------------------------------------------------//
+    OGRSpatialReference* canonical = CrsRegistry::instance ().intern (_coordinateSystem);
+    canonical->Reference ();
+    _coordinateSystem->Release ();
+    _coordinateSystem = canonical;
+}
     
 Coordinate GeoRaster::getCoordinate (double i, double j) const
 {
@@ -79,16 +199,85 @@ OGRGeometry* GeoRaster::getCompleteExtend () const
     return (OGRGeometry*)result;
 }
 
+CornerLattice GeoRaster::getCornerLattice () const
+{
+    return getCornerLattice (getFullWindow (iSize (), jSize ()));
+}
+
+CornerLattice GeoRaster::getCornerLattice (OGRSpatialReference* coordinateSystem) const
+{
+    return getCornerLattice (getFullWindow (iSize (), jSize ()), coordinateSystem);
+}
+
+CornerLattice GeoRaster::getCornerLattice (const Window& window) const
+{
+    if (window.i1 > iSize () or window.j1 > jSize ())
+        throw OutOfDomainException ();
+
+    CornerLattice result (window, getCoordinateSystem ());
+    for (size_t cj = 0; cj <= window.jSize (); ++cj)
+        for (size_t ci = 0; ci <= window.iSize (); ++ci)
+        {
+            size_t index = cj*(window.iSize () + 1) + ci;
+            affineTransformation ((double)(window.i0 + ci) - 0.5, (double)(window.j0 + cj) - 0.5,
+                    result._x[index], result._y[index]);
+        }
+    return result;
+}
+
+CornerLattice GeoRaster::getCornerLattice (const Window& window,
+        OGRSpatialReference* coordinateSystem) const
+{
+    // all corners are transformed at once //
+    //-------------------------------------//
+    CornerLattice result = getCornerLattice (window);
+    CrsRegistry::instance ().transform (getCoordinateSystem (), coordinateSystem,
+            result._x.size (), &result._x[0], &result._y[0]);
+    result._coordinateSystem = coordinateSystem;
+    return result;
+}
+
 OGRSpatialReference* GeoRaster::getCoordinateSystem () const
 {
     return _coordinateSystem;
 }
 
+double GeoRaster::getCellSize () const
+{
+    return std::min (fabs (_padfTransform[1]), fabs (_padfTransform[5]));
+}
+
+double GeoRaster::getCellSizeInMetres () const
+{
+    return getCellSize ()*getMetresPerUnit (getCoordinateSystem ());
+}
+
+double getMetresPerUnit (OGRSpatialReference* coordinateSystem)
+{
+    if (coordinateSystem->IsGeographic ())
+        return coordinateSystem->GetSemiMajor ()*M_PI/180.0;
+    return coordinateSystem->GetLinearUnits ();
+}
+
 void GeoRaster::getArrayIndex (const Coordinate coord, double& i, double& j) const
 {
-    Coordinate coordInMySystem = coord.transform (getCoordinateSystem ());
-    inverseAffineTransformation (coordInMySystem.getX (),
-	    coordInMySystem.getY (), i, j);
+    double x = coord.getX ();
+    double y = coord.getY ();
+    getArrayIndex (coord.getCoordinateSystem (), 1, &x, &y, &i, &j);
+}
+
+void GeoRaster::getArrayIndex (OGRSpatialReference* coordinateSystem, size_t count,
+        const double* x, const double* y, double* i, double* j) const
+{
+    // transform all points at once, using i and j as buffers //
+    //--------------------------------------------------------//
+    std::copy (x, x + count, i);
+    std::copy (y, y + count, j);
+    CrsRegistry::instance ().transform (coordinateSystem, getCoordinateSystem (),
+            count, i, j);
+
+    for (size_t n = 0; n < count; ++n)
+        inverseAffineTransformation (i[n], j[n], i[n], j[n]);
 }
 
 void GeoRaster::writeEmptyGeoTiff (string fileName)
@@ -4,8 +4,73 @@
 #include <ogr_spatialref.h>
 #include <ogr_geometry.h>
 #include <string>
+#include <vector>
 #include <boost/multi_array.hpp>
 #include "coordinate.h"
+#include "window.h"
+
+/**
+ * @brief The corners of all cells of a raster in one coordinate system
+ *
+ * Corner (ci, cj) is the lower left corner of cell (ci, cj), so a raster of
+ * iSize x jSize cells has (iSize+1) x (jSize+1) corners. A lattice may hold
+ * the corners of a window of the raster only, they keep the numbers of the
+ * whole raster, i0 <= ci <= i0 + iSize and j0 <= cj <= j0 + jSize.
+ */
+class CornerLattice
+{
+  private:
+    size_t               _i0;
+    size_t               _j0;
+    size_t               _iSize;
+    size_t               _jSize;
+    std::vector<double>  _x;
+    std::vector<double>  _y;
+    OGRSpatialReference* _coordinateSystem;
+
+    friend class GeoRaster;
+
+  public:
+    CornerLattice ();
+    CornerLattice (const Window&, OGRSpatialReference*);
+    size_t i0 () const;
+    size_t j0 () const;
+    size_t iSize () const;
+    size_t jSize () const;
+    double getX (size_t, size_t) const;
+    double getY (size_t, size_t) const;
+    OGRSpatialReference* getCoordinateSystem () const;
+};
+
+/**
+ * @brief A lightweight view of one cell of a CornerLattice
+ *
+ * The corners are numbered counter-clockwise starting at the lower left one,
+ * in the same order as the points of GeoRaster::getPolygon.
+ */
+class CellView
+{
+  private:
+    const CornerLattice* _lattice;
+    size_t               _i;
+    size_t               _j;
+
+  public:
+    CellView (const CornerLattice&, size_t, size_t);
+    double getX (size_t) const;
+    double getY (size_t) const;
+    double getArea () const;
+    void getEnvelope (OGREnvelope*) const;
+    void fillPolygon (OGRPolygon&) const;
+};
+
+/**
+ * @brief The length of a unit of a coordinate system in metres
+ *
+ * For geographic systems the length of a degree along a meridian of a
+ * sphere with the semi-major axis of the ellipsoid.
+ */
+double getMetresPerUnit (OGRSpatialReference*);
 
 class GeoRaster
 {
@@ -18,6 +83,16 @@ class GeoRaster
     double               _padfTransformInverse[6];
     OGRSpatialReference* _coordinateSystem;
 
+    /**
+     * @brief Replace the coordinate system by its canonical object, see
+     *        CrsRegistry::intern
+     *
+     * Called once the constructor of a raster has set up its system, so
+     * that the coordinates and transformations of the raster find it in the
+     * cache of their thread without exporting it to WKT or locking.
+     */
+    void internCoordinateSystem ();
+
   public:
     GeoRaster ();
     ~GeoRaster ();
@@ -26,8 +101,29 @@ class GeoRaster
     Coordinate getCoordinate (double, double) const;
     OGRGeometry* getPolygon (size_t, size_t) const;
     OGRGeometry* getCompleteExtend () const;
+    CornerLattice getCornerLattice () const;
+    CornerLattice getCornerLattice (OGRSpatialReference*) const;
+
+    /**
+     * @brief The corners of the cells of a window only
+     */
+    CornerLattice getCornerLattice (const Window&) const;
+    CornerLattice getCornerLattice (const Window&, OGRSpatialReference*) const;
     OGRSpatialReference* getCoordinateSystem () const;
+
+    /**
+     * @brief The smaller of the cell sizes along i and j, e.g. DX and DY
+     *        of a WRF grid
+     */
+    double getCellSize () const;
+
+    /**
+     * @brief The cell size in metres, see getMetresPerUnit
+     */
+    double getCellSizeInMetres () const;
     void getArrayIndex (const Coordinate, double&, double&) const;
+    void getArrayIndex (OGRSpatialReference*, size_t, const double*, const double*,
+            double*, double*) const;
     void writeEmptyGeoTiff (std::string);
     virtual boost::multi_array<float, 2> getClmType (size_t) = 0;
 };
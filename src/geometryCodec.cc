@@ -0,0 +1,113 @@
+#include <cmath>
+#include "geometryCodec.h"
+
+using std::vector;
+
+namespace
+{
+
+    unsigned long long zigzag (long long value)
+    {
+        return value < 0 ? 2*(unsigned long long) (-(value + 1)) + 1
+                         : 2*(unsigned long long) value;
+    }
+
+    long long unzigzag (unsigned long long value)
+    {
+        return value & 1 ? -(long long) (value >> 1) - 1 : (long long) (value >> 1);
+    }
+
+}
+
+void writeVarint (unsigned long long value, vector<unsigned char>& data)
+{
+    while (value >= 0x80)
+    {
+        data.push_back ((unsigned char) (value | 0x80));
+        value >>= 7;
+    }
+    data.push_back ((unsigned char) value);
+}
+
+unsigned long long readVarint (const unsigned char*& data)
+{
+    unsigned long long value = 0;
+    unsigned int shift = 0;
+    while (*data & 0x80)
+    {
+        value |= (unsigned long long) (*data++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= (unsigned long long) *data++ << shift;
+    return value;
+}
+
+GeometryCodec::GeometryCodec (double resolution)
+    : _resolution (resolution)
+{}
+
+double GeometryCodec::getResolution () const
+{
+    return _resolution;
+}
+
+void GeometryCodec::encode (const vector<size_t>& ringCounts, const vector<Ring>& rings,
+        vector<unsigned char>& data) const
+{
+    writeVarint (ringCounts.size (), data);
+    for (size_t n = 0; n < ringCounts.size (); ++n)
+        writeVarint (ringCounts[n], data);
+
+    // the first point is the anchor, the differences to it start at zero //
+    //----------------------------------------------------------------------//
+    long long previousX = 0;
+    long long previousY = 0;
+    for (size_t n = 0; n < rings.size (); ++n)
+    {
+        if (rings[n].size () == 0)
+            throw GeometryCodecException ();
+        writeVarint (rings[n].size (), data);
+        for (size_t k = 0; k < rings[n].size (); ++k)
+        {
+            const long long x = (long long) floor (rings[n].x[k]/_resolution + 0.5);
+            const long long y = (long long) floor (rings[n].y[k]/_resolution + 0.5);
+            writeVarint (zigzag (x - previousX), data);
+            writeVarint (zigzag (y - previousY), data);
+            previousX = x;
+            previousY = y;
+        }
+    }
+}
+
+const unsigned char* GeometryCodec::decode (const unsigned char* data,
+        vector<size_t>& ringCounts, vector<Ring>& rings) const
+{
+    ringCounts.resize (readVarint (data));
+    size_t ringCount = 0;
+    for (size_t n = 0; n < ringCounts.size (); ++n)
+    {
+        ringCounts[n] = readVarint (data);
+        ringCount += ringCounts[n];
+    }
+
+    long long x = 0;
+    long long y = 0;
+    rings.resize (ringCount);
+    for (size_t n = 0; n < ringCount; ++n)
+    {
+        const size_t pointCount = readVarint (data);
+        if (pointCount == 0)
+            throw GeometryCodecException ();
+        Ring& ring = rings[n];
+        ring.x.resize (pointCount);
+        ring.y.resize (pointCount);
+        for (size_t k = 0; k < pointCount; ++k)
+        {
+            x += unzigzag (readVarint (data));
+            y += unzigzag (readVarint (data));
+            ring.x[k] = x*_resolution;
+            ring.y[k] = y*_resolution;
+        }
+    }
+    return data;
+}
@@ -0,0 +1,69 @@
+#ifndef GEOMETRYCODEC_H
+#define GEOMETRYCODEC_H
+
+#include <vector>
+#include <cstddef>
+#include "rectangleClip.h"
+
+class GeometryCodecException {};
+
+/**
+ * @brief Append an unsigned integer in 7 bit groups, low group first
+ */
+void writeVarint (unsigned long long value, std::vector<unsigned char>& data);
+
+/**
+ * @brief Read an integer written by writeVarint and advance behind it
+ */
+unsigned long long readVarint (const unsigned char*& data);
+
+/**
+ * @brief Packs the polygons of a feature into a few bytes per point
+ *
+ * The coordinates are rounded to multiples of the resolution. The first
+ * point of the feature is its anchor and is stored as it is, every further
+ * point as the difference to the point before it, which is small for the
+ * dense rings of CORINE. All integers are stored as varints, the signed
+ * ones zigzag encoded, so a difference below 64 resolution steps takes a
+ * single byte.
+ *
+ * A feature is given as the number of rings of every polygon and the rings
+ * of all polygons in order, exterior ring first. The rings do not repeat
+ * their first point at the end.
+ */
+class GeometryCodec
+{
+  private:
+    double _resolution;
+
+  public:
+
+    /**
+     * @param resolution The rounding of the coordinates, the default is
+     *                   1 cm for coordinates in metres
+     */
+    GeometryCodec (double resolution = 0.01);
+
+    double getResolution () const;
+
+    /**
+     * @brief Append the packed feature
+     */
+    void encode (const std::vector<size_t>& ringCounts, const std::vector<Ring>& rings,
+            std::vector<unsigned char>& data) const;
+
+    /**
+     * @brief Unpack a feature
+     *
+     * The vectors are resized but keep their memory, so buffers reused for
+     * many features allocate only for the largest one.
+     *
+     * @return The end of the packed feature
+     *
+     * @throws GeometryCodecException for a ring without points
+     */
+    const unsigned char* decode (const unsigned char* data, std::vector<size_t>& ringCounts,
+            std::vector<Ring>& rings) const;
+};
+
+#endif
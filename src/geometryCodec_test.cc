@@ -0,0 +1,80 @@
+#define BOOST_TEST_MODULE GeometryCodec
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include "geometryCodec.h"
+
+BOOST_AUTO_TEST_CASE( varint_test )
+{
+    const unsigned long long values[] = {0, 1, 127, 128, 300, 16383, 16384,
+                                         4294967296ULL, 18446744073709551615ULL};
+    const size_t sizes[] = {1, 1, 1, 2, 2, 2, 3, 5, 10};
+
+    for (size_t n = 0; n < sizeof (values)/sizeof (values[0]); ++n)
+    {
+        std::vector<unsigned char> data;
+        writeVarint (values[n], data);
+        BOOST_CHECK_EQUAL (data.size (), sizes[n]);
+
+        const unsigned char* position = &data[0];
+        BOOST_CHECK_EQUAL (readVarint (position), values[n]);
+        BOOST_CHECK (position == &data[0] + data.size ());
+    }
+}
+
+BOOST_AUTO_TEST_CASE( codec_test )
+{
+    // two polygons, the first with a hole, far from the origin like LAEA
+    std::vector<size_t> ringCounts;
+    ringCounts.push_back (2);
+    ringCounts.push_back (1);
+
+    std::vector<Ring> rings (3);
+    for (size_t k = 0; k < 200; ++k)
+    {
+        const double angle = 2.0*M_PI*k/200;
+        rings[0].addPoint (4321000.123 + 100.0*cos (angle), 3210000.456 + 100.0*sin (angle));
+        rings[1].addPoint (4321000.123 + 10.0*cos (-angle), 3210000.456 + 10.0*sin (-angle));
+    }
+    rings[2].addPoint (4400000.0, 3300000.0);
+    rings[2].addPoint (4400010.0, 3300000.0);
+    rings[2].addPoint (4400000.0, 3300010.005);
+
+    const GeometryCodec codec (0.01);
+    std::vector<unsigned char> data (1, 0xff);
+    codec.encode (ringCounts, rings, data);
+    codec.encode (ringCounts, rings, data);
+
+    // neighbouring points of dense rings take a few bytes
+    BOOST_CHECK (data.size () < 2*(24 + 403*6));
+
+    // decoded into buffers holding larger features before
+    std::vector<size_t> decodedCounts (5, 7);
+    std::vector<Ring> decoded (4);
+    decoded[0].x.resize (1000);
+    decoded[0].y.resize (1000);
+    const unsigned char* position = &data[1];
+    for (size_t copy = 0; copy < 2; ++copy)
+    {
+        position = codec.decode (position, decodedCounts, decoded);
+        BOOST_REQUIRE_EQUAL (decodedCounts.size (), 2u);
+        BOOST_CHECK_EQUAL (decodedCounts[0], 2u);
+        BOOST_CHECK_EQUAL (decodedCounts[1], 1u);
+        BOOST_REQUIRE_EQUAL (decoded.size (), 3u);
+        for (size_t n = 0; n < rings.size (); ++n)
+        {
+            BOOST_REQUIRE_EQUAL (decoded[n].size (), rings[n].size ());
+            for (size_t k = 0; k < rings[n].size (); ++k)
+            {
+                BOOST_CHECK (fabs (decoded[n].x[k] - rings[n].x[k]) <= 0.005 + 1e-9);
+                BOOST_CHECK (fabs (decoded[n].y[k] - rings[n].y[k]) <= 0.005 + 1e-9);
+            }
+        }
+    }
+    BOOST_CHECK (position == &data[0] + data.size ());
+
+    // rings need points
+    std::vector<Ring> empty (1);
+    std::vector<unsigned char> rejected;
+    BOOST_CHECK_THROW (codec.encode (std::vector<size_t> (1, 1), empty, rejected),
+            GeometryCodecException);
+}
@@ -0,0 +1,187 @@
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "jobServer.h"
+
+using std::string;
+
+using namespace jobServer;
+
+namespace
+{
+
+    /**
+     * @brief Read a line from a connection, without the newline
+     */
+    bool readLine (int connection, string& line)
+    {
+        line.clear ();
+        char c;
+        while (line.size () <= maxJobLength)
+        {
+            const ssize_t result = read (connection, &c, 1);
+            if (result < 0 and errno == EINTR) continue;
+            if (result <= 0) return !line.empty ();
+            if (c == '\n') return true;
+            line += c;
+        }
+        return false;
+    }
+
+    void writeLine (int connection, string line)
+    {
+        line += '\n';
+        const char* data = line.data ();
+        size_t size = line.size ();
+        while (size > 0)
+        {
+            const ssize_t result = write (connection, data, size);
+            if (result < 0 and errno == EINTR) continue;
+            if (result <= 0) return;
+            data += result;
+            size -= result;
+        }
+    }
+
+    /**
+     * @brief Run the job of a connection, in the child process
+     *
+     * @return The exit status of the child
+     */
+    int runConnection (int connection, JobRunner& runner, bool verbose)
+    {
+        string line;
+        string status ("OK");
+        try
+        {
+            if (!readLine (connection, line))
+                throw JobFormatException ();
+            if (verbose) std::cout << "starting job: " << line << std::endl;
+            runner.run (parseJob (line));
+        }
+        catch (JobFormatException&)
+        {
+            status = "ERROR malformed job";
+        }
+        catch (WrongGridException&)
+        {
+            status = "ERROR cell size differs from the prepared polygons";
+        }
+        catch (std::exception& e)
+        {
+            status = string ("ERROR ") + e.what ();
+        }
+        catch (...)
+        {
+            status = "ERROR job failed";
+        }
+
+        if (verbose) std::cout << "job: " << line << ": " << status << std::endl;
+        writeLine (connection, status);
+        close (connection);
+        return status == "OK" ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+}
+
+bool Job::has (string key) const
+{
+    return _options.find (key) != _options.end ();
+}
+
+string Job::get (string key, string defaultValue) const
+{
+    std::map<string, string>::const_iterator it = _options.find (key);
+    return it == _options.end () ? defaultValue : it->second;
+}
+
+void Job::set (string key, string value)
+{
+    _options[key] = value;
+}
+
+Job jobServer::parseJob (string line)
+{
+    std::istringstream stream (line);
+    Job job;
+    string word;
+    while (stream >> word)
+    {
+        const size_t equals = word.find ('=');
+        if (equals == 0 or equals == string::npos)
+            throw JobFormatException ();
+        const string key = word.substr (0, equals);
+        if (job.has (key))
+            throw JobFormatException ();
+        job.set (key, word.substr (equals + 1));
+    }
+    return job;
+}
+
+JobRunner::~JobRunner ()
+{}
+
+void jobServer::serve (string socketName, size_t maxJobs, JobRunner& runner, bool verbose)
+{
+    sockaddr_un address;
+    std::memset (&address, 0, sizeof (address));
+    address.sun_family = AF_UNIX;
+    if (socketName.size () >= sizeof (address.sun_path))
+        throw SocketException ();
+    std::strcpy (address.sun_path, socketName.c_str ());
+
+    const int server = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0)
+        throw SocketException ();
+    unlink (socketName.c_str ());
+    if (   bind (server, (sockaddr*) &address, sizeof (address)) != 0
+        or listen (server, 16) != 0)
+    {
+        close (server);
+        throw SocketException ();
+    }
+
+    // a client leaving early must not end a job //
+    //--------------------------------------------//
+    signal (SIGPIPE, SIG_IGN);
+    if (verbose) std::cout << "serving on " << socketName << std::endl;
+
+    size_t running = 0;
+    while (true)
+    {
+        // finished jobs are reaped, at most maxJobs run at once //
+        //--------------------------------------------------------//
+        while (running > 0 and waitpid (-1, NULL, running < maxJobs ? WNOHANG : 0) > 0)
+            running--;
+
+        const int connection = accept (server, NULL, NULL);
+        if (connection < 0)
+        {
+            if (errno == EINTR) continue;
+            close (server);
+            throw SocketException ();
+        }
+
+        std::cout.flush ();
+        const pid_t child = fork ();
+        if (child == 0)
+        {
+            close (server);
+            _exit (runConnection (connection, runner, verbose));
+        }
+
+        if (child < 0)
+            writeLine (connection, "ERROR no process for the job");
+        else
+            running++;
+        close (connection);
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef JOBSERVER_H
+#define JOBSERVER_H
+
+#include <string>
+#include <map>
+#include <exception>
+
+/**
+ * @brief Serving overlay jobs over a local Unix socket
+ *
+ * A client connects, sends one line naming the job and reads one line of
+ * status, "OK" or "ERROR" followed by a reason. The server runs every job in
+ * a child process forked from itself, so the jobs share the polygons loaded
+ * before, copy on write, and a failing job cannot take the server down.
+ */
+namespace jobServer
+{
+
+    class JobFormatException : public std::exception {};
+    class SocketException : public std::exception {};
+
+    /**
+     * @brief The grid of a job does not fit the polygons the server
+     *        prepared
+     */
+    class WrongGridException : public std::exception {};
+
+    /**
+     * @brief The options of a job, given as key=value words, e.g.
+     *        "wrfFile=wrfinput_d02 window=0:100,0:50"
+     */
+    class Job
+    {
+      private:
+        std::map<std::string, std::string> _options;
+
+      public:
+        bool has (std::string key) const;
+
+        /**
+         * @brief The value of an option, or the default if it is not given
+         */
+        std::string get (std::string key, std::string defaultValue = "") const;
+        void set (std::string key, std::string value);
+    };
+
+    /**
+     * @brief Parse the line of a job
+     *
+     * @throws JobFormatException for words without a key, or keys given
+     *         twice
+     */
+    Job parseJob (std::string line);
+
+    /**
+     * @brief Runs one job in a child process of the server
+     */
+    class JobRunner
+    {
+      public:
+        virtual ~JobRunner ();
+
+        /**
+         * @brief Run a job, a failure is reported by an exception
+         */
+        virtual void run (const Job&) = 0;
+    };
+
+    /**
+     * @brief Longest line of a job, longer lines are rejected
+     */
+    const size_t maxJobLength = 4096;
+
+    /**
+     * @brief Accept jobs until the server is killed
+     *
+     * The socket file is replaced if it exists.
+     *
+     * @param socketName The file name of the socket
+     * @param maxJobs    Number of jobs running at once, further clients
+     *                   wait to be accepted
+     * @param runner     Runs the jobs
+     * @param verbose    Print every job and its status
+     */
+    void serve (std::string socketName, size_t maxJobs, JobRunner& runner, bool verbose);
+
+}
+
+#endif
@@ -0,0 +1,158 @@
+#define BOOST_TEST_MODULE JobServer
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "jobServer.h"
+
+using namespace jobServer;
+
+BOOST_AUTO_TEST_CASE( job_test )
+{
+    // words are key=value pairs, values may be empty or contain '='
+    Job job = parseJob ("wrfFile=/data/wrfinput_d02  window=0:10,0:20 partial= x=a=b");
+    BOOST_CHECK (job.has ("wrfFile"));
+    BOOST_CHECK_EQUAL (job.get ("wrfFile"), "/data/wrfinput_d02");
+    BOOST_CHECK_EQUAL (job.get ("window"), "0:10,0:20");
+    BOOST_CHECK (job.has ("partial"));
+    BOOST_CHECK_EQUAL (job.get ("partial", "default"), "");
+    BOOST_CHECK_EQUAL (job.get ("x"), "a=b");
+    BOOST_CHECK (!job.has ("tile"));
+    BOOST_CHECK_EQUAL (job.get ("tile", "0/1"), "0/1");
+
+    BOOST_CHECK (!parseJob ("").has ("wrfFile"));
+    BOOST_CHECK_THROW (parseJob ("wrfFile"), JobFormatException);
+    BOOST_CHECK_THROW (parseJob ("=value"), JobFormatException);
+    BOOST_CHECK_THROW (parseJob ("tile=0/2 tile=1/2"), JobFormatException);
+}
+
+static bool exists (std::string fileName)
+{
+    return access (fileName.c_str (), F_OK) == 0;
+}
+
+/**
+ * @brief Jobs of the test, run in the children of the server
+ *
+ * mark=FILE creates the file when the job starts, wait=FILE waits until the
+ * file exists and fail=REASON throws.
+ */
+class StubRunner : public JobRunner
+{
+  public:
+    void run (const Job& job)
+    {
+        if (job.has ("mark"))
+            std::ofstream (job.get ("mark").c_str ());
+        if (job.has ("wait"))
+            while (!exists (job.get ("wait")))
+                usleep (10000);
+        if (job.has ("fail"))
+            throw std::runtime_error (job.get ("fail"));
+    }
+};
+
+/**
+ * @brief Connect to the server and send a job, waiting for the server to
+ *        listen
+ *
+ * @return The connection, the status is read with readStatus
+ */
+static int sendJob (std::string socketName, std::string line)
+{
+    sockaddr_un address;
+    std::memset (&address, 0, sizeof (address));
+    address.sun_family = AF_UNIX;
+    std::strcpy (address.sun_path, socketName.c_str ());
+
+    for (size_t attempt = 0; attempt < 500; ++attempt)
+    {
+        const int connection = socket (AF_UNIX, SOCK_STREAM, 0);
+        BOOST_REQUIRE (connection >= 0);
+        if (connect (connection, (sockaddr*) &address, sizeof (address)) == 0)
+        {
+            line += '\n';
+            BOOST_REQUIRE (write (connection, line.data (), line.size ()) == (ssize_t) line.size ());
+            return connection;
+        }
+        close (connection);
+        usleep (10000);
+    }
+    BOOST_FAIL ("no server on " + socketName);
+    return -1;
+}
+
+static std::string readStatus (int connection)
+{
+    std::string status;
+    char c;
+    while (read (connection, &c, 1) == 1 and c != '\n')
+        status += c;
+    close (connection);
+    return status;
+}
+
+BOOST_AUTO_TEST_CASE( serve_test )
+{
+    const std::string socketName = "jobServer_test.socket";
+    const std::string gate = "jobServer_test.gate";
+    const std::string first = "jobServer_test.first";
+    const std::string second = "jobServer_test.second";
+    std::remove (gate.c_str ());
+    std::remove (first.c_str ());
+    std::remove (second.c_str ());
+
+    // a single job at once //
+    //----------------------//
+    std::cout.flush ();
+    const pid_t server = fork ();
+    BOOST_REQUIRE (server >= 0);
+    if (server == 0)
+    {
+        StubRunner runner;
+        try
+        {
+            serve (socketName, 1, runner, false);
+        }
+        catch (...)
+        {}
+        _exit (EXIT_FAILURE);
+    }
+
+    BOOST_CHECK_EQUAL (readStatus (sendJob (socketName, "mark=" + first)), "OK");
+    BOOST_CHECK (exists (first));
+    std::remove (first.c_str ());
+
+    BOOST_CHECK_EQUAL (readStatus (sendJob (socketName, "fail=broken")), "ERROR broken");
+    BOOST_CHECK_EQUAL (readStatus (sendJob (socketName, "fail")), "ERROR malformed job");
+
+    // the second job only starts when the first is done //
+    //----------------------------------------------------//
+    const int firstJob = sendJob (socketName, "mark=" + first + " wait=" + gate);
+    while (!exists (first))
+        usleep (10000);
+    const int secondJob = sendJob (socketName, "mark=" + second);
+    usleep (300000);
+    BOOST_CHECK (!exists (second));
+
+    std::ofstream (gate.c_str ());
+    BOOST_CHECK_EQUAL (readStatus (firstJob), "OK");
+    BOOST_CHECK_EQUAL (readStatus (secondJob), "OK");
+    BOOST_CHECK (exists (second));
+
+    kill (server, SIGTERM);
+    waitpid (server, NULL, 0);
+    std::remove (socketName.c_str ());
+    std::remove (gate.c_str ());
+    std::remove (first.c_str ());
+    std::remove (second.c_str ());
+}
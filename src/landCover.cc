@@ -0,0 +1,120 @@
+#include "landCover.h"
+#include "corine.h"
+
+using std::string;
+
+using namespace landCover;
+
+Grid::Grid (size_t iSize, size_t jSize, const double geoTransform[6],
+        string coordinateSystem)
+    : _iSize (iSize),
+      _jSize (jSize)
+{
+    if (   iSize == 0 or jSize == 0
+        or _coordinateSystem->SetFromUserInput (coordinateSystem.c_str ()) != OGRERR_NONE)
+        throw GridDefinitionException ();
+    internCoordinateSystem ();
+
+    for (size_t n = 0; n < 6; ++n)
+        _padfTransform[n] = geoTransform[n];
+
+    // calculate parameters for inverse transformation //
+    //-------------------------------------------------//
+    const double determinant = geoTransform[1]*geoTransform[5] - geoTransform[2]*geoTransform[4];
+    if (determinant == 0.0)
+        throw GridDefinitionException ();
+    _padfTransformInverse[1] =  geoTransform[5]/determinant;
+    _padfTransformInverse[2] = -geoTransform[2]/determinant;
+    _padfTransformInverse[4] = -geoTransform[4]/determinant;
+    _padfTransformInverse[5] =  geoTransform[1]/determinant;
+    _padfTransformInverse[0] = -geoTransform[0]*_padfTransformInverse[1]
+                               -geoTransform[3]*_padfTransformInverse[2];
+    _padfTransformInverse[3] = -geoTransform[0]*_padfTransformInverse[4]
+                               -geoTransform[3]*_padfTransformInverse[5];
+}
+
+size_t Grid::iSize () const
+{
+    return _iSize;
+}
+
+size_t Grid::jSize () const
+{
+    return _jSize;
+}
+
+boost::multi_array<float, 2> Grid::getClmType (size_t)
+{
+    throw NoLandUseException ();
+}
+
+Source::Source (string directory, const overlay::ReadOptions& options, double cellSize,
+        bool verbose)
+    : _sources (overlay::openCorineSources (directory, cellSize, options, verbose))
+{}
+
+const overlay::SourceList& Source::getSources () const
+{
+    return _sources;
+}
+
+FractionPlanes::FractionPlanes (const Window& window, size_t typeCount)
+    : _window (window),
+      _planes (boost::extents[typeCount][window.jSize ()][window.iSize ()])
+{}
+
+const Window& FractionPlanes::getWindow () const
+{
+    return _window;
+}
+
+size_t FractionPlanes::typeCount () const
+{
+    return _planes.shape ()[0];
+}
+
+float& FractionPlanes::operator() (size_t type, size_t i, size_t j)
+{
+    return _planes[type][j - _window.j0][i - _window.i0];
+}
+
+float FractionPlanes::operator() (size_t type, size_t i, size_t j) const
+{
+    return _planes[type][j - _window.j0][i - _window.i0];
+}
+
+const boost::multi_array<float, 3>& FractionPlanes::getPlanes () const
+{
+    return _planes;
+}
+
+FractionPlanes FractionPlanes::map (const MappingMatrix& mapping) const
+{
+    if (mapping.sourceCount () != typeCount ())
+        throw WrongTypeCountException ();
+
+    FractionPlanes result (_window, mapping.targetCount ());
+    mapping.apply (_planes.data (), _window.iSize ()*_window.jSize (), result._planes.data ());
+    return result;
+}
+
+FractionPlanes landCover::computeFractions (const overlay::Engine& engine,
+        const Source& source, const GeoRaster& grid, const Window& window)
+{
+    overlay::FractionGrid fractions (window.iSize (), window.jSize (), corine::typeCount,
+            window.i0, window.j0);
+    overlay::addFractions (engine, source.getSources (), grid,
+            overlay::getWindowCells (window), fractions);
+
+    // only the non-zero fractions were stored //
+    //------------------------------------------//
+    FractionPlanes planes (window, corine::typeCount);
+    for (size_t j = window.j0; j < window.j1; ++j)
+        for (size_t i = window.i0; i < window.i1; ++i)
+        {
+            const SparseFractions& cell = fractions (i, j);
+            for (size_t n = 0; n < cell.size (); ++n)
+                planes (cell.getType (n), i, j) = cell.getValue (n);
+        }
+    return planes;
+}
@@ -0,0 +1,154 @@
+#ifndef LANDCOVER_H
+#define LANDCOVER_H
+
+#include <string>
+#include <boost/multi_array.hpp>
+#include "geoRaster.h"
+#include "overlay.h"
+#include "mappingMatrix.h"
+#include "window.h"
+
+/**
+ * @brief The interface of libcorine2wrfClm for programs embedding the
+ *        overlay
+ *
+ * A Grid describes the cells in memory, a Source keeps the CORINE polygons
+ * open for any number of grids, and computeFractions returns the fractions
+ * of a window as dense planes. No WRF file is needed, any GeoRaster like a
+ * wrf::File may be used as the grid.
+ */
+namespace landCover
+{
+
+    class GridDefinitionException {};
+    class NoLandUseException {};
+    class WrongTypeCountException {};
+
+    /**
+     * @brief A grid defined in memory
+     */
+    class Grid : public GeoRaster
+    {
+      private:
+        size_t _iSize;
+        size_t _jSize;
+
+        Grid (const Grid&);
+        Grid& operator= (const Grid&);
+
+      public:
+
+        /**
+         * @brief Constructor
+         *
+         * @param iSize            Number of cells along i
+         * @param jSize            Number of cells along j
+         * @param geoTransform     The affine transformation from cell
+         *                         indices to the coordinates of the cell
+         *                         centres, in the order of GDAL: x0, dx/di,
+         *                         dx/dj, y0, dy/di, dy/dj
+         * @param coordinateSystem The coordinate system as PROJ.4 string or
+         *                         as WKT
+         */
+        Grid (size_t iSize, size_t jSize, const double geoTransform[6],
+                std::string coordinateSystem);
+
+        size_t iSize () const;
+        size_t jSize () const;
+
+        /**
+         * @brief Not available, a grid in memory has no land use
+         */
+        boost::multi_array<float, 2> getClmType (size_t);
+    };
+
+    /**
+     * @brief The polygons of all CORINE classes, opened once
+     *
+     * Simplified and split polygons are prepared in the constructor, for
+     * grids of the given cell size.
+     */
+    class Source
+    {
+      private:
+        overlay::SourceList _sources;
+
+      public:
+
+        /**
+         * @param directory The directory of the CORINE shape files, or the
+         *                  dataset of all classes, see
+         *                  overlay::ReadOptions::classAttribute
+         * @param options   How the polygons are read
+         * @param cellSize  The cell size in metres the polygons are
+         *                  simplified and split for, see
+         *                  GeoRaster::getCellSizeInMetres
+         * @param verbose   Print the name of every file
+         */
+        Source (std::string directory,
+                const overlay::ReadOptions& options = overlay::ReadOptions (),
+                double cellSize = 0.0, bool verbose = false);
+
+        const overlay::SourceList& getSources () const;
+    };
+
+    /**
+     * @brief Dense fractions of the cells of a window, one plane per type
+     */
+    class FractionPlanes
+    {
+      private:
+        Window                       _window;
+        boost::multi_array<float, 3> _planes;
+
+      public:
+
+        /**
+         * @param window    The cells, indices of the whole grid
+         * @param typeCount Number of types
+         */
+        FractionPlanes (const Window& window, size_t typeCount);
+
+        const Window& getWindow () const;
+        size_t typeCount () const;
+
+        /**
+         * @brief The fraction of one type in a cell of the window
+         */
+        float& operator() (size_t type, size_t i, size_t j);
+        float operator() (size_t type, size_t i, size_t j) const;
+
+        /**
+         * @brief All fractions, indexed by type, j - window.j0 and
+         *        i - window.i0
+         */
+        const boost::multi_array<float, 3>& getPlanes () const;
+
+        /**
+         * @brief Map the fractions to other types
+         *
+         * @param mapping A mapping from typeCount () types, e.g.
+         *                corine::clmMapping ()
+         *
+         * @throws WrongTypeCountException for a mapping from other types
+         */
+        FractionPlanes map (const MappingMatrix& mapping) const;
+    };
+
+    /**
+     * @brief The fractions of the CORINE classes in the cells of a window
+     *
+     * @param engine The engine computing the fractions, see
+     *               overlay::createEngine
+     * @param source The polygons
+     * @param grid   The grid of the cells
+     * @param window The cells to compute
+     *
+     * @return corine::typeCount planes
+     */
+    FractionPlanes computeFractions (const overlay::Engine& engine, const Source& source,
+            const GeoRaster& grid, const Window& window);
+
+}
+
+#endif
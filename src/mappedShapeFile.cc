@@ -0,0 +1,249 @@
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "mappedShapeFile.h"
+
+using std::string;
+using std::vector;
+
+const int MappedShapeFile::polygonType;
+
+namespace
+{
+
+    const size_t headerSize = 100;
+    const size_t indexRecordSize = 8;
+    const int fileCode = 9994;
+
+    // byte order independent reading of the fields of a shape file //
+    //---------------------------------------------------------------//
+
+    int getBigInt (const unsigned char* p)
+    {
+        return (int) ((unsigned int) p[0] << 24 | (unsigned int) p[1] << 16
+                    | (unsigned int) p[2] << 8  | (unsigned int) p[3]);
+    }
+
+    int getLittleInt (const unsigned char* p)
+    {
+        return (int) ((unsigned int) p[3] << 24 | (unsigned int) p[2] << 16
+                    | (unsigned int) p[1] << 8  | (unsigned int) p[0]);
+    }
+
+    double getLittleDouble (const unsigned char* p)
+    {
+        unsigned long long bits = 0;
+        for (int n = 7; n >= 0; --n)
+            bits = bits << 8 | p[n];
+        double value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+
+    bool isPolygonType (int shapeType)
+    {
+        // polygons with z or measure values start like plain polygons //
+        //--------------------------------------------------------------//
+        return shapeType == MappedShapeFile::polygonType
+            or shapeType == 15 or shapeType == 25;
+    }
+
+    const unsigned char* mapFile (string fileName, size_t& size)
+    {
+        int descriptor = open (fileName.c_str (), O_RDONLY);
+        if (descriptor < 0)
+            throw MappedShapeFileOpenException ();
+
+        struct stat status;
+        if (fstat (descriptor, &status) != 0 or (size_t) status.st_size < headerSize)
+        {
+            ::close (descriptor);
+            throw MappedShapeFileOpenException ();
+        }
+        size = status.st_size;
+
+        void* data = mmap (NULL, size, PROT_READ, MAP_SHARED, descriptor, 0);
+        ::close (descriptor);
+        if (data == MAP_FAILED)
+            throw MappedShapeFileOpenException ();
+        return (const unsigned char*) data;
+    }
+
+    void checkHeader (const unsigned char* header)
+    {
+        if (   getBigInt (header) != fileCode
+            or getLittleInt (header + 28) != 1000
+            or !isPolygonType (getLittleInt (header + 32)))
+            throw MappedShapeFileFormatException ();
+    }
+
+}
+
+RingSpan::RingSpan (const unsigned char* points, size_t pointCount)
+    : _points (points), _pointCount (pointCount)
+{}
+
+size_t RingSpan::size () const
+{
+    return _pointCount;
+}
+
+double RingSpan::x (size_t n) const
+{
+    return getLittleDouble (_points + 16*n);
+}
+
+double RingSpan::y (size_t n) const
+{
+    return getLittleDouble (_points + 16*n + 8);
+}
+
+ShapeRecord::ShapeRecord (const unsigned char* content, size_t length)
+    : _content (content), _shapeType (0), _partCount (0), _pointCount (0)
+{
+    if (length < 4)
+        throw MappedShapeFileFormatException ();
+
+    _shapeType = getLittleInt (content);
+    if (_shapeType == 0)
+        return;
+    if (!isPolygonType (_shapeType) or length < 44)
+        throw MappedShapeFileFormatException ();
+
+    int partCount = getLittleInt (content + 36);
+    int pointCount = getLittleInt (content + 40);
+    if (   partCount < 0 or pointCount < 0
+        or 44 + 4*(size_t) partCount + 16*(size_t) pointCount > length)
+        throw MappedShapeFileFormatException ();
+
+    _partCount = partCount;
+    _pointCount = pointCount;
+}
+
+int ShapeRecord::getShapeType () const
+{
+    return _shapeType;
+}
+
+bool ShapeRecord::empty () const
+{
+    return _partCount == 0 or _pointCount == 0;
+}
+
+void ShapeRecord::getEnvelope (OGREnvelope* envelope) const
+{
+    if (_shapeType == 0)
+        throw MappedShapeFileFormatException ();
+
+    envelope->MinX = getLittleDouble (_content + 4);
+    envelope->MinY = getLittleDouble (_content + 12);
+    envelope->MaxX = getLittleDouble (_content + 20);
+    envelope->MaxY = getLittleDouble (_content + 28);
+}
+
+size_t ShapeRecord::partCount () const
+{
+    return _partCount;
+}
+
+size_t ShapeRecord::pointCount () const
+{
+    return _pointCount;
+}
+
+RingSpan ShapeRecord::getRing (size_t part) const
+{
+    if (part >= _partCount)
+        throw MappedShapeFileFormatException ();
+
+    const unsigned char* parts = _content + 44;
+    const unsigned char* points = parts + 4*_partCount;
+
+    size_t first = getLittleInt (parts + 4*part);
+    size_t last = part + 1 < _partCount
+        ? (size_t) getLittleInt (parts + 4*(part + 1)) : _pointCount;
+    if (first > last or last > _pointCount)
+        throw MappedShapeFileFormatException ();
+
+    return RingSpan (points + 16*first, last - first);
+}
+
+MappedShapeFile::MappedShapeFile (string fileName)
+    : _shp (NULL), _shpSize (0), _shx (NULL), _shxSize (0), _recordCount (0)
+{
+    string indexFileName = fileName;
+    if (indexFileName.size () < 4)
+        throw MappedShapeFileOpenException ();
+    indexFileName.replace (indexFileName.size () - 3, 3,
+            indexFileName[indexFileName.size () - 1] == 'P' ? "SHX" : "shx");
+
+    _shp = mapFile (fileName, _shpSize);
+    try
+    {
+        _shx = mapFile (indexFileName, _shxSize);
+        checkHeader (_shp);
+        checkHeader (_shx);
+    }
+    catch (...)
+    {
+        if (_shx) munmap ((void*) _shx, _shxSize);
+        munmap ((void*) _shp, _shpSize);
+        throw;
+    }
+
+    _recordCount = (_shxSize - headerSize)/indexRecordSize;
+}
+
+MappedShapeFile::~MappedShapeFile ()
+{
+    munmap ((void*) _shx, _shxSize);
+    munmap ((void*) _shp, _shpSize);
+}
+
+size_t MappedShapeFile::size () const
+{
+    return _recordCount;
+}
+
+void MappedShapeFile::getEnvelope (OGREnvelope* envelope) const
+{
+    envelope->MinX = getLittleDouble (_shp + 36);
+    envelope->MinY = getLittleDouble (_shp + 44);
+    envelope->MaxX = getLittleDouble (_shp + 52);
+    envelope->MaxY = getLittleDouble (_shp + 60);
+}
+
+ShapeRecord MappedShapeFile::getRecord (size_t n) const
+{
+    if (n >= _recordCount)
+        throw MappedShapeFileFormatException ();
+
+    // offsets and lengths are counted in 16 bit words //
+    //-------------------------------------------------//
+    const unsigned char* entry = _shx + headerSize + indexRecordSize*n;
+    size_t offset = 2*(size_t) getBigInt (entry);
+    size_t length = 2*(size_t) getBigInt (entry + 4);
+    if (offset < headerSize or offset + 8 + length > _shpSize)
+        throw MappedShapeFileFormatException ();
+
+    return ShapeRecord (_shp + offset + 8, length);
+}
+
+void MappedShapeFile::getEnvelopes (size_t first, size_t last,
+        vector<OGREnvelope>& envelopes, vector<size_t>& ids) const
+{
+    for (size_t n = first; n < last and n < _recordCount; ++n)
+    {
+        ShapeRecord record = getRecord (n);
+        if (record.empty ())
+            continue;
+
+        OGREnvelope envelope;
+        record.getEnvelope (&envelope);
+        envelopes.push_back (envelope);
+        ids.push_back (n);
+    }
+}
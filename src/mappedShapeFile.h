@@ -0,0 +1,99 @@
+#ifndef MAPPEDSHAPEFILE_H
+#define MAPPEDSHAPEFILE_H
+
+#include <ogr_core.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The points of one ring, read in place from a mapped shape file
+ *
+ * The coordinates are little endian doubles which need not be aligned, so
+ * they are only accessed through x and y.
+ */
+class RingSpan
+{
+  private:
+    const unsigned char* _points;
+    size_t               _pointCount;
+  public:
+    RingSpan (const unsigned char* points, size_t pointCount);
+    size_t size () const;
+    double x (size_t) const;
+    double y (size_t) const;
+};
+
+/**
+ * @brief One record of a mapped shape file
+ *
+ * Only polygon records have parts, null records are empty. The record is
+ * valid as long as its file is.
+ */
+class ShapeRecord
+{
+  private:
+    const unsigned char* _content;
+    int                  _shapeType;
+    size_t               _partCount;
+    size_t               _pointCount;
+  public:
+    ShapeRecord (const unsigned char* content, size_t length);
+    int getShapeType () const;
+    bool empty () const;
+    void getEnvelope (OGREnvelope*) const;
+    size_t partCount () const;
+    size_t pointCount () const;
+    RingSpan getRing (size_t part) const;
+};
+
+/**
+ * @brief The .shp and .shx file of a polygon shape file mapped into memory
+ *
+ * Records are located through the offsets in the .shx file, so disjoint
+ * ranges of records can be decoded by different threads without any
+ * synchronisation. Nothing is copied out of the file, the attributes in
+ * the .dbf file are never read.
+ */
+class MappedShapeFile
+{
+  private:
+    const unsigned char* _shp;
+    size_t               _shpSize;
+    const unsigned char* _shx;
+    size_t               _shxSize;
+    size_t               _recordCount;
+
+    MappedShapeFile (const MappedShapeFile&);
+    MappedShapeFile& operator= (const MappedShapeFile&);
+
+  public:
+
+    /**
+     * @brief Shape type of polygons in the file header and in records
+     */
+    static const int polygonType = 5;
+
+    /**
+     * @param fileName The name of the .shp file, the .shx file is next to it
+     */
+    MappedShapeFile (std::string fileName);
+    ~MappedShapeFile ();
+
+    size_t size () const;
+    void getEnvelope (OGREnvelope*) const;
+    ShapeRecord getRecord (size_t n) const;
+
+    /**
+     * @brief The envelopes of records first <= n < last, empty records
+     *        are skipped
+     *
+     * @param ids The numbers of the records of the envelopes
+     */
+    void getEnvelopes (size_t first, size_t last, std::vector<OGREnvelope>& envelopes,
+            std::vector<size_t>& ids) const;
+};
+
+class MappedShapeFileOpenException {};
+class MappedShapeFileFormatException {};
+
+#endif
@@ -0,0 +1,152 @@
+#define BOOST_TEST_MODULE MappedShapeFile
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "mappedShapeFile.h"
+
+typedef std::vector<unsigned char> Bytes;
+
+static void putBigInt (Bytes& bytes, size_t position, int value)
+{
+    for (int n = 0; n < 4; ++n)
+        bytes[position + n] = (value >> (24 - 8*n)) & 0xff;
+}
+
+static void appendLittleInt (Bytes& bytes, int value)
+{
+    for (int n = 0; n < 4; ++n)
+        bytes.push_back ((value >> 8*n) & 0xff);
+}
+
+static void appendLittleDouble (Bytes& bytes, double value)
+{
+    unsigned char raw[8];
+    std::memcpy (raw, &value, 8);
+    bytes.insert (bytes.end (), raw, raw + 8);
+}
+
+static Bytes header ()
+{
+    Bytes bytes (28, 0);
+    putBigInt (bytes, 0, 9994);
+    appendLittleInt (bytes, 1000);
+    appendLittleInt (bytes, MappedShapeFile::polygonType);
+    for (int n = 0; n < 8; ++n)
+        appendLittleDouble (bytes, n < 4 ? n : 0.0);
+    return bytes;
+}
+
+/**
+ * A polygon record of squares [x, x + 1] x [0, 1], one square per part
+ */
+static Bytes polygonRecord (std::vector<double> xs)
+{
+    Bytes bytes;
+    appendLittleInt (bytes, MappedShapeFile::polygonType);
+    appendLittleDouble (bytes, xs.front ());
+    appendLittleDouble (bytes, 0.0);
+    appendLittleDouble (bytes, xs.back () + 1.0);
+    appendLittleDouble (bytes, 1.0);
+    appendLittleInt (bytes, xs.size ());
+    appendLittleInt (bytes, 5*xs.size ());
+    for (size_t part = 0; part < xs.size (); ++part)
+        appendLittleInt (bytes, 5*part);
+    for (size_t part = 0; part < xs.size (); ++part)
+    {
+        double x[5] = {xs[part], xs[part], xs[part] + 1.0, xs[part] + 1.0, xs[part]};
+        double y[5] = {0.0, 1.0, 1.0, 0.0, 0.0};
+        for (int n = 0; n < 5; ++n)
+        {
+            appendLittleDouble (bytes, x[n]);
+            appendLittleDouble (bytes, y[n]);
+        }
+    }
+    return bytes;
+}
+
+static void write (std::string fileName, const Bytes& bytes)
+{
+    FILE* file = fopen (fileName.c_str (), "wb");
+    fwrite (&bytes[0], 1, bytes.size (), file);
+    fclose (file);
+}
+
+BOOST_AUTO_TEST_CASE( mappedShapeFile_test )
+{
+    // records: a square, a null shape and two squares in two parts
+    std::vector<Bytes> records;
+    records.push_back (polygonRecord (std::vector<double> (1, 0.0)));
+    Bytes null;
+    appendLittleInt (null, 0);
+    records.push_back (null);
+    std::vector<double> xs;
+    xs.push_back (2.0);
+    xs.push_back (4.0);
+    records.push_back (polygonRecord (xs));
+
+    Bytes shp = header ();
+    Bytes shx = header ();
+    for (size_t n = 0; n < records.size (); ++n)
+    {
+        shx.resize (shx.size () + 8);
+        putBigInt (shx, shx.size () - 8, shp.size ()/2);
+        putBigInt (shx, shx.size () - 4, records[n].size ()/2);
+
+        shp.resize (shp.size () + 8);
+        putBigInt (shp, shp.size () - 8, n + 1);
+        putBigInt (shp, shp.size () - 4, records[n].size ()/2);
+        shp.insert (shp.end (), records[n].begin (), records[n].end ());
+    }
+    putBigInt (shp, 24, shp.size ()/2);
+    putBigInt (shx, 24, shx.size ()/2);
+    write ("mappedShapeFile_test.shp", shp);
+    write ("mappedShapeFile_test.shx", shx);
+
+    {
+        MappedShapeFile file ("mappedShapeFile_test.shp");
+        BOOST_CHECK_EQUAL (file.size (), 3u);
+
+        ShapeRecord square = file.getRecord (0);
+        BOOST_CHECK (!square.empty ());
+        BOOST_CHECK_EQUAL (square.partCount (), 1u);
+        BOOST_CHECK_EQUAL (square.getRing (0).size (), 5u);
+        BOOST_CHECK_EQUAL (square.getRing (0).x (2), 1.0);
+        BOOST_CHECK_EQUAL (square.getRing (0).y (2), 1.0);
+
+        BOOST_CHECK (file.getRecord (1).empty ());
+
+        ShapeRecord twoSquares = file.getRecord (2);
+        BOOST_CHECK_EQUAL (twoSquares.partCount (), 2u);
+        BOOST_CHECK_EQUAL (twoSquares.getRing (1).size (), 5u);
+        BOOST_CHECK_EQUAL (twoSquares.getRing (1).x (0), 4.0);
+        BOOST_CHECK_EQUAL (twoSquares.getRing (1).x (3), 5.0);
+        OGREnvelope envelope;
+        twoSquares.getEnvelope (&envelope);
+        BOOST_CHECK_EQUAL (envelope.MinX, 2.0);
+        BOOST_CHECK_EQUAL (envelope.MaxX, 5.0);
+        BOOST_CHECK_THROW (twoSquares.getRing (2), MappedShapeFileFormatException);
+        BOOST_CHECK_THROW (file.getRecord (3), MappedShapeFileFormatException);
+
+        // envelopes of a record range skip the null shape
+        std::vector<OGREnvelope> envelopes;
+        std::vector<size_t> ids;
+        file.getEnvelopes (0, file.size (), envelopes, ids);
+        BOOST_CHECK_EQUAL (ids.size (), 2u);
+        BOOST_CHECK_EQUAL (ids[1], 2u);
+        envelopes.clear ();
+        ids.clear ();
+        file.getEnvelopes (1, 2, envelopes, ids);
+        BOOST_CHECK (ids.empty ());
+    }
+
+    // a file which is no shape file
+    write ("mappedShapeFile_test.shx", Bytes (100, 0));
+    BOOST_CHECK_THROW (MappedShapeFile ("mappedShapeFile_test.shp"),
+            MappedShapeFileFormatException);
+    BOOST_CHECK_THROW (MappedShapeFile ("missing.shp"), MappedShapeFileOpenException);
+
+    remove ("mappedShapeFile_test.shp");
+    remove ("mappedShapeFile_test.shx");
+}
@@ -0,0 +1,166 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "mappingMatrix.h"
+
+using std::string;
+using std::vector;
+
+const size_t MappingMatrix::blockSize;
+
+static bool entryLess (const MappingMatrix::Entry& a, const MappingMatrix::Entry& b)
+{
+    if (a.source != b.source) return a.source < b.source;
+    return a.target < b.target;
+}
+
+MappingMatrix::MappingMatrix (size_t sourceCount, size_t targetCount,
+        const Entry* entries, size_t entryCount)
+    : _sourceCount (sourceCount),
+      _targetCount (targetCount)
+{
+    build (vector<Entry> (entries, entries + entryCount));
+}
+
+MappingMatrix::MappingMatrix (size_t sourceCount, size_t targetCount, string fileName)
+    : _sourceCount (sourceCount),
+      _targetCount (targetCount)
+{
+    std::ifstream file (fileName.c_str ());
+    if (!file)
+        throw MappingTableOpenException ();
+
+    vector<Entry> entries;
+    string line;
+    while (std::getline (file, line))
+    {
+        size_t first = line.find_first_not_of (" \t\r");
+        if (first == string::npos or line[first] == '#')
+            continue;
+
+        std::istringstream stream (line);
+        long source, target;
+        Entry entry;
+        if (!(stream >> source >> target >> entry.weight)
+                or source < 0 or target < 0)
+            throw MappingTableFormatException ();
+        entry.source = source;
+        entry.target = target;
+        entries.push_back (entry);
+    }
+
+    build (entries);
+}
+
+void MappingMatrix::build (vector<Entry> entries)
+{
+    std::sort (entries.begin (), entries.end (), entryLess);
+
+    _rowStart.assign (_sourceCount + 1, 0);
+    _target.clear ();
+    _weight.clear ();
+
+    for (size_t k = 0; k < entries.size (); ++k)
+    {
+        if (entries[k].source >= _sourceCount or entries[k].target >= _targetCount)
+            throw MappingOutOfRange ();
+
+        // merge duplicate weights of the same source and target
+        if (k > 0
+                and entries[k].source == entries[k - 1].source
+                and entries[k].target == entries[k - 1].target)
+        {
+            _weight.back () += entries[k].weight;
+            continue;
+        }
+
+        _target.push_back (entries[k].target);
+        _weight.push_back (entries[k].weight);
+        _rowStart[entries[k].source + 1] = _target.size ();
+    }
+
+    for (size_t type = 1; type <= _sourceCount; ++type)
+        if (_rowStart[type] < _rowStart[type - 1])
+            _rowStart[type] = _rowStart[type - 1];
+}
+
+size_t MappingMatrix::sourceCount () const
+{
+    return _sourceCount;
+}
+
+size_t MappingMatrix::targetCount () const
+{
+    return _targetCount;
+}
+
+MappingMatrix MappingMatrix::compose (const MappingMatrix& next) const
+{
+    if (next._sourceCount != _targetCount)
+        throw MappingOutOfRange ();
+
+    vector<Entry> entries;
+    for (size_t source = 0; source < _sourceCount; ++source)
+        for (size_t k = _rowStart[source]; k < _rowStart[source + 1]; ++k)
+        {
+            size_t middle = _target[k];
+            for (size_t l = next._rowStart[middle]; l < next._rowStart[middle + 1]; ++l)
+            {
+                Entry entry = {source, next._target[l], _weight[k]*next._weight[l]};
+                entries.push_back (entry);
+            }
+        }
+
+    MappingMatrix result (_sourceCount, next._targetCount, NULL, 0);
+    result.build (entries);
+    return result;
+}
+
+MappingMatrix MappingMatrix::stack (const MappingMatrix& other) const
+{
+    if (other._sourceCount != _sourceCount)
+        throw MappingOutOfRange ();
+
+    vector<Entry> entries;
+    for (size_t source = 0; source < _sourceCount; ++source)
+    {
+        for (size_t k = _rowStart[source]; k < _rowStart[source + 1]; ++k)
+        {
+            Entry entry = {source, _target[k], _weight[k]};
+            entries.push_back (entry);
+        }
+        for (size_t k = other._rowStart[source]; k < other._rowStart[source + 1]; ++k)
+        {
+            Entry entry = {source, _targetCount + other._target[k], other._weight[k]};
+            entries.push_back (entry);
+        }
+    }
+
+    MappingMatrix result (_sourceCount, _targetCount + other._targetCount, NULL, 0);
+    result.build (entries);
+    return result;
+}
+
+void MappingMatrix::apply (const Fractions& source, Fractions& target) const
+{
+    if (source.size () != _sourceCount or target.size () != _targetCount)
+        throw MappingOutOfRange ();
+
+    for (size_t type = 0; type < _sourceCount; ++type)
+    {
+        double value = source[type];
+        if (value == 0.0) continue;
+        for (size_t k = _rowStart[type]; k < _rowStart[type + 1]; ++k)
+            target.add (_target[k], _weight[k]*value);
+    }
+}
+
+std::ostream& operator<< (std::ostream& out, const MappingMatrix& matrix)
+{
+    out << "# source\ttarget\tweight" << std::endl;
+    for (size_t source = 0; source < matrix._sourceCount; ++source)
+        for (size_t k = matrix._rowStart[source]; k < matrix._rowStart[source + 1]; ++k)
+            out << source << "\t" << matrix._target[k] << "\t"
+                << matrix._weight[k] << std::endl;
+    return out;
+}
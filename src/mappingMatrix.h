@@ -0,0 +1,152 @@
+#ifndef MAPPINGMATRIX_H
+#define MAPPINGMATRIX_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include "fractions.h"
+
+/**
+ * @brief A sparse matrix of weights mapping the fractions of one type system
+ *        onto the fractions of another one
+ *
+ * The weights are stored row-compressed by source type, so that applying the
+ * matrix to whole planes of a grid is a sequence of scaled plane additions.
+ */
+class MappingMatrix
+{
+    public:
+
+        /**
+         * @brief One non-zero weight of the matrix
+         */
+        struct Entry
+        {
+            size_t source;
+            size_t target;
+            double weight;
+        };
+
+    private:
+        size_t              _sourceCount;
+        size_t              _targetCount;
+        std::vector<size_t> _rowStart;
+        std::vector<size_t> _target;
+        std::vector<double> _weight;
+
+        void build (std::vector<Entry>);
+
+    public:
+
+        /**
+         * @brief Number of grid cells processed at once by the plane kernel
+         */
+        static const size_t blockSize = 512;
+
+        /**
+         * @brief Constructor
+         *
+         * @param sourceCount The amount of source types
+         * @param targetCount The amount of target types
+         * @param entries     Array of non-zero weights
+         * @param entryCount  Length of the array
+         */
+        MappingMatrix (size_t sourceCount, size_t targetCount,
+                const Entry* entries, size_t entryCount);
+
+        /**
+         * @brief Constructor reading the weights from a table file
+         *
+         * Every line of the file holds a source index, a target index and a
+         * weight. Empty lines and lines starting with '#' are ignored.
+         *
+         * @param sourceCount The amount of source types
+         * @param targetCount The amount of target types
+         * @param fileName    Name of the table file
+         */
+        MappingMatrix (size_t sourceCount, size_t targetCount, std::string fileName);
+
+        size_t sourceCount () const;
+        size_t targetCount () const;
+
+        /**
+         * @brief Concatenation of two mappings
+         *
+         * @param next Mapping applied to the result of this mapping
+         *
+         * @return A single matrix equivalent to applying this, then next
+         */
+        MappingMatrix compose (const MappingMatrix& next) const;
+
+        /**
+         * @brief Mapping producing the targets of this and other at once
+         *
+         * @param other Mapping of the same source types
+         *
+         * @return A matrix whose targets are the ones of this, followed by
+         *         the ones of other
+         */
+        MappingMatrix stack (const MappingMatrix& other) const;
+
+        /**
+         * @brief Map a single set of fractions
+         *
+         * @param source Fractions of the source types
+         * @param target Fractions of the target types, the result is added
+         */
+        void apply (const Fractions& source, Fractions& target) const;
+
+        /**
+         * @brief Map whole planes of fractions
+         *
+         * Both arrays are stored type by type, each type holding a contiguous
+         * plane of planeSize values. All target planes are computed in one
+         * pass over the cells.
+         *
+         * @param source    sourceCount () planes of source fractions
+         * @param planeSize Number of values in one plane
+         * @param target    targetCount () planes, overwritten with the result
+         */
+        template<typename S, typename T>
+        void apply (const S* source, size_t planeSize, T* target) const;
+
+        /**
+         * @brief Write the weights in the format of the table file
+         */
+        friend std::ostream& operator<< (std::ostream& out, const MappingMatrix& matrix);
+};
+
+class MappingTableOpenException   : public std::exception {};
+class MappingTableFormatException : public std::exception {};
+class MappingOutOfRange           : public std::exception {};
+
+template<typename S, typename T>
+void MappingMatrix::apply (const S* source, size_t planeSize, T* target) const
+{
+    for (size_t blockStart = 0; blockStart < planeSize; blockStart += blockSize)
+    {
+        size_t blockEnd = blockStart + blockSize;
+        if (blockEnd > planeSize) blockEnd = planeSize;
+
+        for (size_t type = 0; type < _targetCount; ++type)
+        {
+            T* out = target + type*planeSize;
+            for (size_t n = blockStart; n < blockEnd; ++n)
+                out[n] = 0.0;
+        }
+
+        for (size_t type = 0; type < _sourceCount; ++type)
+        {
+            const S* in = source + type*planeSize;
+            for (size_t k = _rowStart[type]; k < _rowStart[type + 1]; ++k)
+            {
+                T* out = target + _target[k]*planeSize;
+                const double weight = _weight[k];
+                for (size_t n = blockStart; n < blockEnd; ++n)
+                    out[n] += weight*in[n];
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,124 @@
+#define BOOST_TEST_MODULE MappingMatrix
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include "mappingMatrix.h"
+#include "corine.h"
+#include "modis.h"
+#include "usgs.h"
+#include "clm.h"
+
+BOOST_AUTO_TEST_CASE( mappingMatrix_test )
+{
+    double tolerance = 1.0e-10;
+    MappingMatrix::Entry entries[] =
+    {
+        {0, 1, 0.25},
+        {0, 0, 0.75},
+        {2, 1, 1.0},
+        {2, 1, 0.5},
+    };
+    MappingMatrix matrix (3, 2, entries, 4);
+    BOOST_CHECK_EQUAL (matrix.sourceCount (), 3);
+    BOOST_CHECK_EQUAL (matrix.targetCount (), 2);
+
+    // check for range check
+    MappingMatrix::Entry outOfRange[] = {{3, 0, 1.0}};
+    BOOST_CHECK_THROW (MappingMatrix (3, 2, outOfRange, 1), MappingOutOfRange);
+
+    // check single fractions, duplicates are summed up
+    Fractions source (3);
+    source.set (0, 0.4);
+    source.set (1, 0.1);
+    source.set (2, 0.2);
+    Fractions target (2);
+    matrix.apply (source, target);
+    BOOST_CHECK_CLOSE (target[0], 0.3, tolerance);
+    BOOST_CHECK_CLOSE (target[1], 0.4, tolerance);
+
+    // check planes give the same result as single fractions
+    size_t planeSize = 3*MappingMatrix::blockSize + 7;
+    std::vector<double> sourcePlanes (3*planeSize);
+    std::vector<double> targetPlanes (2*planeSize, -1.0);
+    for (size_t n = 0; n < planeSize; ++n)
+        for (size_t type = 0; type < 3; ++type)
+            sourcePlanes[type*planeSize + n] = source[type]*(n%5);
+    matrix.apply (&sourcePlanes[0], planeSize, &targetPlanes[0]);
+    for (size_t n = 0; n < planeSize; ++n)
+    {
+        BOOST_CHECK_CLOSE (targetPlanes[n] + 1.0,             target[0]*(n%5) + 1.0, tolerance);
+        BOOST_CHECK_CLOSE (targetPlanes[planeSize + n] + 1.0, target[1]*(n%5) + 1.0, tolerance);
+    }
+
+    // check stacking
+    MappingMatrix stacked = matrix.stack (matrix);
+    BOOST_CHECK_EQUAL (stacked.targetCount (), 4);
+    Fractions stackedTarget (4);
+    stacked.apply (source, stackedTarget);
+    BOOST_CHECK_CLOSE (stackedTarget[2], target[0], tolerance);
+    BOOST_CHECK_CLOSE (stackedTarget[3], target[1], tolerance);
+
+    // check reading the written table
+    const char* fileName = "mappingMatrix_test.tbl";
+    {
+        std::ofstream file (fileName);
+        file << "# a comment" << std::endl << std::endl << matrix;
+    }
+    MappingMatrix read (3, 2, fileName);
+    Fractions readTarget (2);
+    read.apply (source, readTarget);
+    BOOST_CHECK_CLOSE (readTarget[0], target[0], tolerance);
+    BOOST_CHECK_CLOSE (readTarget[1], target[1], tolerance);
+    {
+        std::ofstream file (fileName);
+        file << "0 1" << std::endl;
+    }
+    BOOST_CHECK_THROW (MappingMatrix (3, 2, fileName), MappingTableFormatException);
+    std::remove (fileName);
+    BOOST_CHECK_THROW (MappingMatrix (3, 2, fileName), MappingTableOpenException);
+}
+
+BOOST_AUTO_TEST_CASE( builtinMappings_test )
+{
+    double tolerance = 1.0e-10;
+
+    // every built-in mapping conserves the total fraction
+    const MappingMatrix* mappings[] =
+    {
+        &corine::clmMapping (), &usgs::clmMapping (),
+        &modis::usgsMapping (), &modis::clmMapping ()
+    };
+    for (size_t m = 0; m < 4; ++m)
+        for (size_t type = 0; type < mappings[m]->sourceCount (); ++type)
+        {
+            Fractions source (mappings[m]->sourceCount ());
+            source.set (type, 1.0);
+            Fractions target (mappings[m]->targetCount ());
+            mappings[m]->apply (source, target);
+            BOOST_CHECK_SMALL (target.missing (), tolerance);
+        }
+
+    // the composed MODIS mapping equals the mapping via USGS
+    modis::ModisFractions modisFractions;
+    for (size_t type = 0; type < modis::typeCount; ++type)
+        modisFractions.set (type, 1.0/modis::typeCount);
+    usgs::UsgsFractions usgsFractions;
+    modis::usgsMapping ().apply (modisFractions, usgsFractions);
+    clm::ClmFractions viaUsgs = usgsFractions.map2Clm ();
+    clm::ClmFractions composed = modisFractions.map2Clm ();
+    for (size_t type = 0; type < clm::typeCount; ++type)
+        BOOST_CHECK_SMALL (composed[type] - viaUsgs[type], tolerance);
+
+    // the derived fractions of CORINE
+    corine::CorineFractions corineFractions;
+    corineFractions.set (corine::port,            0.1);
+    corineFractions.set (corine::peatBogs,        0.2);
+    corineFractions.set (corine::seaAndOcean,     0.3);
+    corineFractions.set (corine::waterBodies,     0.1);
+    corineFractions.set (corine::claciersAndPerpetualSnow, 0.05);
+    BOOST_CHECK_CLOSE (corineFractions.getArtificialFraction (), 0.1,  tolerance);
+    BOOST_CHECK_CLOSE (corineFractions.getWetlandFraction (),    0.2,  tolerance);
+    BOOST_CHECK_CLOSE (corineFractions.getWaterFraction (),      0.4,  tolerance);
+    BOOST_CHECK_CLOSE (corineFractions.getGlacierFraction (),    0.05, tolerance);
+}
@@ -0,0 +1,417 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include "masterFile.h"
+#include "landCover.h"
+#include "rectangleClip.h"
+#include "crsRegistry.h"
+#include "threads.h"
+#include "corine.h"
+#include "wrf.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using std::string;
+using std::vector;
+
+using namespace overlay;
+
+const int MasterFile::deflateLevel;
+const size_t MasterFile::tileSize;
+const size_t MasterFile::minCellsPerEdge;
+
+namespace
+{
+    const char* codeName = "CORINE_CODE";
+    const char* classDimensionName = "corine_class";
+    const char* x0Name = "MASTER_X0";
+    const char* y0Name = "MASTER_Y0";
+    const char* cellSizeName = "MASTER_CELL_SIZE";
+    const char* levelCountName = "LEVEL_COUNT";
+    const char* coordinateSystemName = "spatial_ref";
+
+    /**
+     * @brief Cells of a target grid remapped together, they share one read
+     */
+    const size_t blockSize = 16;
+
+    string getLevelName (const char* name, size_t level)
+    {
+        std::ostringstream stream;
+        stream << name << "_L" << level;
+        return stream.str ();
+    }
+
+    NcAtt* getAttribute (NcFile& file, const char* name)
+    {
+        NcAtt* attribute = file.get_att (name);
+        if (!attribute)
+            throw WrongMasterFileException ();
+        return attribute;
+    }
+}
+
+MasterFile::MasterFile (string fileName, double x0, double y0, double cellSize,
+        size_t iSize, size_t jSize, size_t levelCount, string coordinateSystem)
+    : NcFile (fileName.c_str (), Replace, NULL, 0, Netcdf4),
+      _x0 (x0),
+      _y0 (y0),
+      _cellSize (cellSize),
+      _iSize (iSize),
+      _jSize (jSize),
+      _levelCount (levelCount),
+      _coordinateSystem (coordinateSystem),
+      _errorBehavior (new NcError (NcError::silent_nonfatal))
+{
+    if (!is_valid () or levelCount == 0 or cellSize <= 0.0)
+        throw WrongMasterFileException ();
+
+    add_att (x0Name, x0);
+    add_att (y0Name, y0);
+    add_att (cellSizeName, cellSize);
+    add_att (levelCountName, (int) levelCount);
+    add_att (coordinateSystemName, coordinateSystem.c_str ());
+
+    const NcDim* classDimension = add_dim (classDimensionName, corine::typeCount);
+    NcVar* codes = add_var (codeName, ncInt, classDimension);
+    if (!codes)
+        throw wrf::VariableNotExistException ();
+
+    for (size_t level = 0; level < levelCount; ++level)
+    {
+        const NcDim* dims[3];
+        dims[0] = classDimension;
+        dims[1] = add_dim (getLevelName ("y", level).c_str (), this->jSize (level));
+        dims[2] = add_dim (getLevelName ("x", level).c_str (), this->iSize (level));
+        NcVar* fractions = add_var (getLevelName ("CORINE_FRACTION", level).c_str (),
+                ncFloat, 3, dims);
+        if (!fractions)
+            throw wrf::VariableNotExistException ();
+
+#ifdef NC_NETCDF4
+        size_t chunks[3] = {1, std::min (tileSize, this->jSize (level)),
+                               std::min (tileSize, this->iSize (level))};
+        if (   nc_def_var_chunking (id (), fractions->id (), NC_CHUNKED, chunks) != NC_NOERR
+            or nc_def_var_deflate (id (), fractions->id (), 1, 1, deflateLevel) != NC_NOERR)
+            throw WrongMasterFileException ();
+#endif
+    }
+
+    int values[corine::typeCount];
+    for (size_t type = 0; type < corine::typeCount; ++type)
+        values[type] = corine::getCode (type);
+    codes->put (values, corine::typeCount);
+}
+
+MasterFile::MasterFile (string fileName)
+    : NcFile (fileName.c_str (), ReadOnly),
+      _errorBehavior (new NcError (NcError::silent_nonfatal))
+{
+    if (!is_valid ())
+        throw WrongMasterFileException ();
+
+    boost::scoped_ptr<NcAtt> attribute (getAttribute (*this, x0Name));
+    _x0 = attribute->as_double (0);
+    attribute.reset (getAttribute (*this, y0Name));
+    _y0 = attribute->as_double (0);
+    attribute.reset (getAttribute (*this, cellSizeName));
+    _cellSize = attribute->as_double (0);
+    attribute.reset (getAttribute (*this, levelCountName));
+    _levelCount = attribute->as_int (0);
+    attribute.reset (getAttribute (*this, coordinateSystemName));
+    char* text = attribute->as_string (0);
+    _coordinateSystem = text;
+    delete[] text;
+
+    NcDim* iDimension = get_dim ("x_L0");
+    NcDim* jDimension = get_dim ("y_L0");
+    if (!iDimension or !jDimension or _levelCount == 0 or _cellSize <= 0.0)
+        throw WrongMasterFileException ();
+    _iSize = iDimension->size ();
+    _jSize = jDimension->size ();
+
+    // the planes must be the classes of this program, in the same order //
+    //--------------------------------------------------------------------//
+    NcVar* codes = get_var (codeName);
+    if (!codes)
+        throw WrongMasterFileException ();
+    int values[corine::typeCount];
+    if (!codes->get (values, corine::typeCount))
+        throw WrongMasterFileException ();
+    for (size_t type = 0; type < corine::typeCount; ++type)
+        if (values[type] != corine::getCode (type))
+            throw WrongMasterFileException ();
+}
+
+MasterFile::~MasterFile ()
+{
+    close ();
+}
+
+size_t MasterFile::levelCount () const
+{
+    return _levelCount;
+}
+
+size_t MasterFile::iSize (size_t level) const
+{
+    return (_iSize + (1 << level) - 1) >> level;
+}
+
+size_t MasterFile::jSize (size_t level) const
+{
+    return (_jSize + (1 << level) - 1) >> level;
+}
+
+double MasterFile::getCellSize (size_t level) const
+{
+    return _cellSize*(1 << level);
+}
+
+const string& MasterFile::getCoordinateSystem () const
+{
+    return _coordinateSystem;
+}
+
+void MasterFile::getGeoTransform (size_t level, double geoTransform[6]) const
+{
+    const double size = getCellSize (level);
+    geoTransform[0] = _x0 + size/2.0;
+    geoTransform[1] = size;
+    geoTransform[2] = 0.0;
+    geoTransform[3] = _y0 + size/2.0;
+    geoTransform[4] = 0.0;
+    geoTransform[5] = size;
+}
+
+size_t MasterFile::getLevel (double cellSize) const
+{
+    size_t level = 0;
+    while (level + 1 < _levelCount and getCellSize (level + 1)*minCellsPerEdge <= cellSize)
+        level++;
+    return level;
+}
+
+NcVar* MasterFile::getVariable (size_t level)
+{
+    NcVar* variable = get_var (getLevelName ("CORINE_FRACTION", level).c_str ());
+    if (level >= _levelCount or !variable)
+        throw wrf::VariableNotExistException ();
+    return variable;
+}
+
+void MasterFile::write (const FractionGrid& fractions)
+{
+    if (   fractions.iOffset () + fractions.iSize () > _iSize
+        or fractions.jOffset () + fractions.jSize () > _jSize
+        or fractions.typeCount () != corine::typeCount)
+        throw wrf::WrongDimensionSizeException ();
+
+    // the sparse cells are made dense one band of rows at a time //
+    //-------------------------------------------------------------//
+    NcVar* variable = getVariable (0);
+    const size_t iCount = fractions.iSize ();
+    const size_t jEnd = fractions.jOffset () + fractions.jSize ();
+    for (size_t jFirst = fractions.jOffset (); jFirst < jEnd; jFirst += tileSize)
+    {
+        const size_t jCount = std::min (tileSize, jEnd - jFirst);
+        boost::multi_array<float, 3> planes (
+                boost::extents[corine::typeCount][jCount][iCount]);
+        for (size_t j = 0; j < jCount; ++j)
+            for (size_t i = 0; i < iCount; ++i)
+            {
+                const SparseFractions& cell = fractions (fractions.iOffset () + i, jFirst + j);
+                for (size_t n = 0; n < cell.size (); ++n)
+                    planes[cell.getType (n)][j][i] = cell.getValue (n);
+            }
+
+        variable->set_cur (0, jFirst, fractions.iOffset ());
+        if (!variable->put (planes.data (), corine::typeCount, jCount, iCount))
+            throw WrongMasterFileException ();
+    }
+}
+
+void MasterFile::buildPyramid ()
+{
+    for (size_t level = 1; level < _levelCount; ++level)
+        for (size_t j0 = 0; j0 < jSize (level); j0 += tileSize)
+            for (size_t i0 = 0; i0 < iSize (level); i0 += tileSize)
+            {
+                // a tile of this level from the tile below it //
+                //----------------------------------------------//
+                Window coarse = {i0, std::min (i0 + tileSize, iSize (level)),
+                                 j0, std::min (j0 + tileSize, jSize (level))};
+                Window fine = {2*coarse.i0, std::min (2*coarse.i1, iSize (level - 1)),
+                               2*coarse.j0, std::min (2*coarse.j1, jSize (level - 1))};
+
+                boost::multi_array<float, 3> finePlanes;
+                read (level - 1, fine, finePlanes);
+
+                boost::multi_array<float, 3> planes (
+                        boost::extents[corine::typeCount][coarse.jSize ()][coarse.iSize ()]);
+                for (size_t type = 0; type < corine::typeCount; ++type)
+                    for (size_t j = 0; j < fine.jSize (); ++j)
+                        for (size_t i = 0; i < fine.iSize (); ++i)
+                            planes[type][j/2][i/2] += 0.25f*finePlanes[type][j][i];
+
+                NcVar* variable = getVariable (level);
+                variable->set_cur (0, coarse.j0, coarse.i0);
+                if (!variable->put (planes.data (), corine::typeCount,
+                            coarse.jSize (), coarse.iSize ()))
+                    throw WrongMasterFileException ();
+            }
+}
+
+void MasterFile::read (size_t level, const Window& window, boost::multi_array<float, 3>& planes)
+{
+    if (window.i1 > iSize (level) or window.j1 > jSize (level))
+        throw wrf::WrongDimensionSizeException ();
+
+    planes.resize (boost::extents[corine::typeCount][window.jSize ()][window.iSize ()]);
+
+#ifdef _OPENMP
+    wrf::File::lock ();
+#endif
+    NcVar* variable = getVariable (level);
+    variable->set_cur (0, window.j0, window.i0);
+    bool ok = variable->get (planes.data (), corine::typeCount,
+            window.jSize (), window.iSize ());
+#ifdef _OPENMP
+    wrf::File::unlock ();
+#endif
+    if (!ok)
+        throw WrongMasterFileException ();
+}
+
+void overlay::remapMaster (MasterFile& master, const GeoRaster& grid, const Window& window,
+        FractionGrid& fractions)
+{
+    if (window.empty ())
+        return;
+    double geoTransform[6];
+    master.getGeoTransform (0, geoTransform);
+    const landCover::Grid masterGrid (master.iSize (0), master.jSize (0),
+            geoTransform, master.getCoordinateSystem ());
+
+    // the corners of the cells of the window in master coordinates //
+    //---------------------------------------------------------------//
+    const CornerLattice gridCorners = grid.getCornerLattice (window);
+    const CornerLattice corners = grid.getCornerLattice (window,
+            masterGrid.getCoordinateSystem ());
+
+    // the level fits the smallest cell of the window, measured in the units
+    // of the master grid
+    // ----------------------------------------------------------------------
+    double cellSize = HUGE_VAL;
+    for (size_t j = window.j0; j < window.j1; ++j)
+        for (size_t i = window.i0; i < window.i1; ++i)
+        {
+            CellView cell (corners, i, j);
+            Ring corner;
+            for (size_t n = 0; n < 4; ++n)
+                corner.addPoint (cell.getX (n), cell.getY (n));
+            cellSize = std::min (cellSize, sqrt (getArea (corner)));
+        }
+    const size_t level = master.getLevel (cellSize);
+    master.getGeoTransform (level, geoTransform);
+    const double size = master.getCellSize (level);
+    const double x0 = geoTransform[0] - size/2.0;
+    const double y0 = geoTransform[3] - size/2.0;
+
+    Window block = {window.i0, window.i1, window.j0, window.j1};
+    vector<Window> blocks;
+    for (block.j0 = window.j0; block.j0 < window.j1; block.j0 += blockSize)
+        for (block.i0 = window.i0; block.i0 < window.i1; block.i0 += blockSize)
+        {
+            block.i1 = std::min (block.i0 + blockSize, window.i1);
+            block.j1 = std::min (block.j0 + blockSize, window.j1);
+            blocks.push_back (block);
+        }
+
+    // densify throws for edges that cannot be reprojected, which must not
+    // leave the parallel loop
+    // --------------------------------------------------------------------
+    FirstException error;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (long b = 0; b < (long) blocks.size (); ++b)
+    try
+    {
+        if (error.failed ())
+            continue;
+        const Window& cells = blocks[b];
+        OGRCoordinateTransformation* trafo = CrsRegistry::instance ().getTransformation (
+                gridCorners.getCoordinateSystem (), masterGrid.getCoordinateSystem ());
+
+        // the master cells below all cells of the block are read at once //
+        //------------------------------------------------------------------//
+        vector<Ring> rings (cells.iSize ()*cells.jSize ());
+        OGREnvelope envelope;
+        CellView (corners, cells.i0, cells.j0).getEnvelope (&envelope);
+        for (size_t j = cells.j0; j < cells.j1; ++j)
+            for (size_t i = cells.i0; i < cells.i1; ++i)
+            {
+                Ring& ring = rings[(j - cells.j0)*cells.iSize () + i - cells.i0];
+                getCellRing (trafo, gridCorners, corners, i, j, ring);
+                for (size_t n = 0; n < ring.size (); ++n)
+                    envelope.Merge (ring.x[n], ring.y[n]);
+            }
+
+        const double iMin = std::max (0.0, floor ((envelope.MinX - x0)/size));
+        const double jMin = std::max (0.0, floor ((envelope.MinY - y0)/size));
+        const double iMax = std::min ((double) master.iSize (level), floor ((envelope.MaxX - x0)/size) + 1.0);
+        const double jMax = std::min ((double) master.jSize (level), floor ((envelope.MaxY - y0)/size) + 1.0);
+        if (iMin >= iMax or jMin >= jMax)
+            continue;
+        const Window masterWindow = {(size_t) iMin, (size_t) iMax, (size_t) jMin, (size_t) jMax};
+
+        boost::multi_array<float, 3> planes;
+        master.read (level, masterWindow, planes);
+
+        // every master cell adds its fractions weighted by the covered part //
+        //--------------------------------------------------------------------//
+        Ring buffer[2];
+        double sums[corine::typeCount];
+        for (size_t j = cells.j0; j < cells.j1; ++j)
+            for (size_t i = cells.i0; i < cells.i1; ++i)
+            {
+                const Ring& ring = rings[(j - cells.j0)*cells.iSize () + i - cells.i0];
+                const double cellArea = getArea (ring);
+                if (cellArea <= 0.0)
+                    continue;
+
+                OGREnvelope cellEnvelope;
+                for (size_t n = 0; n < ring.size (); ++n)
+                    cellEnvelope.Merge (ring.x[n], ring.y[n]);
+                const size_t mi0 = (size_t) std::max (iMin, floor ((cellEnvelope.MinX - x0)/size));
+                const size_t mj0 = (size_t) std::max (jMin, floor ((cellEnvelope.MinY - y0)/size));
+                const size_t mi1 = (size_t) std::min (iMax, floor ((cellEnvelope.MaxX - x0)/size) + 1.0);
+                const size_t mj1 = (size_t) std::min (jMax, floor ((cellEnvelope.MaxY - y0)/size) + 1.0);
+
+                std::fill (sums, sums + corine::typeCount, 0.0);
+                for (size_t mj = mj0; mj < mj1; ++mj)
+                    for (size_t mi = mi0; mi < mi1; ++mi)
+                    {
+                        const double weight = getClippedArea (ring,
+                                x0 + mi*size, y0 + mj*size,
+                                x0 + (mi + 1)*size, y0 + (mj + 1)*size, buffer)/cellArea;
+                        if (weight <= 0.0)
+                            continue;
+                        for (size_t type = 0; type < corine::typeCount; ++type)
+                            sums[type] += weight*planes[type][mj - masterWindow.j0][mi - masterWindow.i0];
+                    }
+
+                for (size_t type = 0; type < corine::typeCount; ++type)
+                    if (sums[type] > 0.0)
+                        fractions.add (i, j, type, sums[type]);
+            }
+    }
+    catch (...)
+    {
+        error.capture ();
+    }
+    error.rethrow ();
+}
@@ -0,0 +1,144 @@
+#ifndef MASTERFILE_H
+#define MASTERFILE_H
+
+#include <netcdfcpp.h>
+#include <string>
+#include <boost/scoped_ptr.hpp>
+#include <boost/multi_array.hpp>
+#include "overlay.h"
+#include "window.h"
+
+namespace overlay
+{
+
+    class WrongMasterFileException {};
+
+    /**
+     * @brief The CORINE fractions on a fine equal-area master grid, with a
+     *        pyramid of coarser levels
+     *
+     * Level 0 holds the fractions of the master cells, computed once by an
+     * overlay. Every further level halves the resolution, a cell holds the
+     * mean of the 2x2 cells below it, which keeps the areas of an
+     * equal-area grid. Cells beyond the master grid count as uncovered.
+     *
+     * The cells of level L have the size cellSize*2^L, cell (i, j) has its
+     * lower left corner at x0 + i*size, y0 + j*size. Each level is one
+     * compressed variable with a plane per class in the NetCDF-4 format.
+     */
+    class MasterFile : public NcFile
+    {
+      private:
+        double      _x0;
+        double      _y0;
+        double      _cellSize;
+        size_t      _iSize;
+        size_t      _jSize;
+        size_t      _levelCount;
+        std::string _coordinateSystem;
+        boost::scoped_ptr<NcError> _errorBehavior;
+
+        NcVar* getVariable (size_t level);
+
+      public:
+
+        /**
+         * @brief Level of the deflate compression of the fractions
+         */
+        static const int deflateLevel = 4;
+
+        /**
+         * @brief Rows and columns of a chunk, and of the pieces the pyramid
+         *        is built from
+         */
+        static const size_t tileSize = 256;
+
+        /**
+         * @brief Remapping uses the coarsest level with at least this many
+         *        master cells along the edge of a target cell
+         */
+        static const size_t minCellsPerEdge = 4;
+
+        /**
+         * @brief Create a master file, replacing an existing one
+         *
+         * @param fileName         Name of the new file
+         * @param x0               The left edge of the master grid
+         * @param y0               The lower edge of the master grid
+         * @param cellSize         The size of the cells of level 0
+         * @param iSize            Number of cells of level 0 along x
+         * @param jSize            Number of cells of level 0 along y
+         * @param levelCount       Number of levels, at least 1
+         * @param coordinateSystem The equal-area coordinate system as WKT
+         */
+        MasterFile (std::string fileName, double x0, double y0, double cellSize,
+                size_t iSize, size_t jSize, size_t levelCount,
+                std::string coordinateSystem);
+
+        /**
+         * @brief Open an existing master file for reading
+         */
+        MasterFile (std::string fileName);
+        ~MasterFile ();
+
+        size_t levelCount () const;
+        size_t iSize (size_t level) const;
+        size_t jSize (size_t level) const;
+        double getCellSize (size_t level) const;
+        const std::string& getCoordinateSystem () const;
+
+        /**
+         * @brief The affine transformation of the cell centres of a level,
+         *        see landCover::Grid
+         */
+        void getGeoTransform (size_t level, double geoTransform[6]) const;
+
+        /**
+         * @brief The level to remap to cells of a size, see minCellsPerEdge
+         *
+         * @param cellSize The edge of the target cells in the units of the
+         *                 master grid
+         */
+        size_t getLevel (double cellSize) const;
+
+        /**
+         * @brief Write the fractions of cells of level 0
+         *
+         * @param fractions Fractions of corine::typeCount classes, the grid
+         *                  is indexed like level 0
+         */
+        void write (const FractionGrid& fractions);
+
+        /**
+         * @brief Compute all levels above 0 from level 0
+         */
+        void buildPyramid ();
+
+        /**
+         * @brief Read the fractions of a window of a level
+         *
+         * @param planes Resized to corine::typeCount planes of the window
+         */
+        void read (size_t level, const Window& window, boost::multi_array<float, 3>& planes);
+    };
+
+    /**
+     * @brief Fill cells of a grid by conservative remapping from a master
+     *        file
+     *
+     * The cell polygons are projected to the master grid with their edges
+     * densified, see getCellRing, and every master cell adds its fractions
+     * weighted by the part of the target cell it covers. The level is
+     * chosen by MasterFile::getLevel for the smallest cell of the window.
+     *
+     * @param master    The master file
+     * @param grid      The grid of the cells
+     * @param window    The cells to compute
+     * @param fractions The fractions of every cell
+     */
+    void remapMaster (MasterFile& master, const GeoRaster& grid, const Window& window,
+            FractionGrid& fractions);
+
+}
+
+#endif
@@ -8,35 +8,46 @@ ModisFractions::ModisFractions ()
     : NotClmFractions (typeCount)
 {}
 
-usgs::UsgsFractions ModisFractions::map2Usgs () const
+static const MappingMatrix::Entry usgsTable[] =
 {
-    usgs::UsgsFractions usgsFractions;
+    {urbanAndBuiltUp,                     usgs::urbanAndBuildUpLand,        1.0},
+    {croplands,                           usgs::croplandAndGrasslandMosaic, 1.0},
+    {croplandAndNaturalVegetationMosaic,  usgs::croplandAndWoodlandMosaic,  1.0},
+    {grasslands,                          usgs::grassland,                  1.0},
+    {closedShrublands,                    usgs::shrubland,                  1.0},
+    {openShrublands,                      usgs::mixedShrublandAndGrassland, 1.0},
+    {woodySavannas,                       usgs::savanna,                    1.0},
+    {savannas,                            usgs::savanna,                    1.0},
+    {deciduousBroadleafForest,            usgs::deciduousBroadleafForest,   1.0},
+    {deciduousNeedleleafForest,           usgs::deciduousNeedleleafForest,  1.0},
+    {evergreenBroadleafForest,            usgs::evergreenBroadleafForest,   1.0},
+    {evergreenNeedleleafForest,           usgs::evergreenNeedleleafForest,  1.0},
+    {mixedForest,                         usgs::mixedForest,                1.0},
+    {water,                               usgs::waterBodies,                1.0},
+    {permanentWetlands,                   usgs::herbaceousWetland,          1.0},
+    {barrenOrSparselyVegetated,           usgs::barrenOrSparselyVegetated,  1.0},
+    {woodedTundra,                        usgs::woodenTundra,               1.0},
+    {mixedTundra,                         usgs::mixedTundra,                1.0},
+    {barrenTundra,                        usgs::bareGroundTundra,           1.0},
+    {snowAndIce,                          usgs::snowOrIce,                  1.0},
+};
 
-    usgsFractions.add (usgs::urbanAndBuildUpLand,        operator[] (urbanAndBuiltUp));
-    usgsFractions.add (usgs::croplandAndGrasslandMosaic, operator[] (croplands));
-    usgsFractions.add (usgs::croplandAndWoodlandMosaic,  operator[] (croplandAndNaturalVegetationMosaic));
-    usgsFractions.add (usgs::grassland,                  operator[] (grasslands));
-    usgsFractions.add (usgs::shrubland,                  operator[] (closedShrublands));
-    usgsFractions.add (usgs::mixedShrublandAndGrassland, operator[] (openShrublands));
-    usgsFractions.add (usgs::savanna,                    operator[] (woodySavannas));
-    usgsFractions.add (usgs::savanna,                    operator[] (savannas));
-    usgsFractions.add (usgs::deciduousBroadleafForest,   operator[] (deciduousBroadleafForest));
-    usgsFractions.add (usgs::deciduousNeedleleafForest,  operator[] (deciduousNeedleleafForest));
-    usgsFractions.add (usgs::evergreenBroadleafForest,   operator[] (evergreenBroadleafForest));
-    usgsFractions.add (usgs::evergreenNeedleleafForest,  operator[] (evergreenNeedleleafForest));
-    usgsFractions.add (usgs::mixedForest,                operator[] (mixedForest));
-    usgsFractions.add (usgs::waterBodies,                operator[] (water));
-    usgsFractions.add (usgs::herbaceousWetland,          operator[] (permanentWetlands));
-    usgsFractions.add (usgs::barrenOrSparselyVegetated,  operator[] (barrenOrSparselyVegetated));
-    usgsFractions.add (usgs::woodenTundra,               operator[] (woodedTundra));
-    usgsFractions.add (usgs::mixedTundra,                operator[] (mixedTundra));
-    usgsFractions.add (usgs::bareGroundTundra,           operator[] (barrenTundra));
-    usgsFractions.add (usgs::snowOrIce,                  operator[] (snowAndIce));
+const MappingMatrix& modis::usgsMapping ()
+{
+    static const MappingMatrix matrix (typeCount, usgs::typeCount,
+            usgsTable, sizeof (usgsTable)/sizeof (usgsTable[0]));
+    return matrix;
+}
 
-    return usgsFractions;
+const MappingMatrix& modis::clmMapping ()
+{
+    static const MappingMatrix matrix (usgsMapping ().compose (usgs::clmMapping ()));
+    return matrix;
 }
 
 clm::ClmFractions ModisFractions::map2Clm () const
 {
-    return map2Usgs ().map2Clm ();
+    clm::ClmFractions clmFractions;
+    clmMapping ().apply (*this, clmFractions);
+    return clmFractions;
 }
@@ -4,6 +4,7 @@
 #include "notClmFractions.h"
 #include "clm.h"
 #include "usgs.h"
+#include "mappingMatrix.h"
 
 namespace modis
 {
@@ -36,12 +37,21 @@ namespace modis
 
     class ModisFractions : public NotClmFractions
     {
-        private:
-            usgs::UsgsFractions map2Usgs () const;
         public:
             ModisFractions ();
             clm::ClmFractions map2Clm () const;
     };
 
+    /**
+     * @brief The built-in mapping of the MODIS types to the USGS types
+     */
+    const MappingMatrix& usgsMapping ();
+
+    /**
+     * @brief The mapping of the MODIS types to the CLM types, composed of the
+     *        mapping to USGS and the USGS mapping to CLM
+     */
+    const MappingMatrix& clmMapping ();
+
 }
 #endif
@@ -0,0 +1,848 @@
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <boost/atomic.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <sstream>
+#include <cstdio>
+#include <sys/stat.h>
+#include "overlay.h"
+#include "rectangleClip.h"
+#include "simplifiedSource.h"
+#include "subdividedSource.h"
+#include "compressedSource.h"
+#include "crsRegistry.h"
+#include "threads.h"
+#include "stats.h"
+#include "corine.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace overlay;
+using std::string;
+
+namespace
+{
+
+    /**
+     * @brief The reprojected polygons touching one cell and their classes
+     */
+    struct CellCandidates
+    {
+        size_t                    i;
+        size_t                    j;
+        std::vector<OGRGeometry*> geometries;
+        std::vector<size_t>       types;
+    };
+
+    typedef BlockingQueue<CellCandidates*> CandidateQueue;
+
+    /**
+     * @brief Number of cells a reader claims at once
+     */
+    const size_t cellChunk = 64;
+
+    /**
+     * @brief Polygons reach beyond the cells, the fitted area is larger by
+     *        this part of its size on every side
+     */
+    const double reprojectionMargin = 0.1;
+
+    CellCandidates* read (FeatureCursor& cursor, OGRCoordinateTransformation* trafo,
+            const CornerLattice& sourceCorners, size_t i, size_t j)
+    {
+        OGREnvelope envelope;
+        CellView (sourceCorners, i, j).getEnvelope (&envelope);
+
+        double start = stats::now ();
+        double reprojectTime = 0.0;
+        cursor.setSpatialFilter (envelope);
+
+        CellCandidates* cell = NULL;
+        OGRGeometry* geometry;
+        while ((geometry = cursor.next ()))
+        {
+            double reprojectStart = stats::now ();
+            geometry->transform (trafo);
+            reprojectTime += stats::now () - reprojectStart;
+            stats::count (stats::verticesReprojected, getPointCount (geometry));
+
+            if (!cell)
+            {
+                cell = new CellCandidates;
+                cell->i = i;
+                cell->j = j;
+            }
+            cell->geometries.push_back (geometry);
+            cell->types.push_back (cursor.getClass ());
+        }
+
+        stats::add (stats::readTime, stats::now () - start - reprojectTime);
+        stats::add (stats::reprojectTime, reprojectTime);
+        stats::count (stats::cellsQueried);
+        if (cell)
+        {
+            stats::count (stats::cellsWithCandidates);
+            stats::count (stats::candidates, cell->geometries.size ());
+        }
+        return cell;
+    }
+
+    void clip (CellCandidates* cell, const CornerLattice& gridCorners,
+            OGRPolygon& cellPolygon, FractionGrid& fractions)
+    {
+        stats::ScopedTimer timer (stats::clipTime);
+        CellView view (gridCorners, cell->i, cell->j);
+        view.fillPolygon (cellPolygon);
+        double cellArea = view.getArea ();
+
+        for (size_t n = 0; n < cell->geometries.size (); ++n)
+        {
+            OGRGeometry* geometry = cell->geometries[n];
+            if (geometry->Intersects (&cellPolygon))
+            {
+                OGRGeometry* intersection = geometry->Intersection (&cellPolygon);
+                stats::count (stats::intersections);
+                if (intersection)
+                {
+                    fractions.add (cell->i, cell->j, cell->types[n],
+                            getArea (intersection)/cellArea);
+                    OGRGeometryFactory::destroyGeometry (intersection);
+                }
+            }
+            OGRGeometryFactory::destroyGeometry (geometry);
+        }
+        delete cell;
+    }
+
+    /**
+     * @brief Free the polygons of a cell that is not clipped
+     */
+    void discard (CellCandidates* cell)
+    {
+        for (size_t n = 0; n < cell->geometries.size (); ++n)
+            OGRGeometryFactory::destroyGeometry (cell->geometries[n]);
+        delete cell;
+    }
+
+    /**
+     * @brief Add the points between two corners of a cell, bisecting the
+     *        edge in grid coordinates while its projection is curved
+     */
+    template <class RingType>
+    void densify (OGRCoordinateTransformation* trafo, RingType& ring,
+            double gridX0, double gridY0, double gridX1, double gridY1,
+            double x0, double y0, double x1, double y1, size_t depth)
+    {
+        if (depth >= ReverseEngine::maxDensifyDepth)
+            return;
+
+        double x = 0.5*(gridX0 + gridX1);
+        double y = 0.5*(gridY0 + gridY1);
+        if (!trafo->Transform (1, &x, &y))
+            throw CrsTransformationException ();
+        stats::count (stats::verticesReprojected);
+
+        const double deviation = hypot (x - 0.5*(x0 + x1), y - 0.5*(y0 + y1));
+        if (deviation <= ReverseEngine::densifyTolerance*hypot (x1 - x0, y1 - y0))
+            return;
+
+        densify (trafo, ring, gridX0, gridY0, 0.5*(gridX0 + gridX1), 0.5*(gridY0 + gridY1),
+                x0, y0, x, y, depth + 1);
+        ring.addPoint (x, y);
+        densify (trafo, ring, 0.5*(gridX0 + gridX1), 0.5*(gridY0 + gridY1), gridX1, gridY1,
+                x, y, x1, y1, depth + 1);
+    }
+
+    /**
+     * @brief The polygon of a cell in the coordinate system of the source
+     *
+     * @param trafo The transformation from the grid to the source
+     */
+    void fillSourcePolygon (OGRCoordinateTransformation* trafo,
+            const CornerLattice& gridCorners, const CornerLattice& sourceCorners,
+            size_t i, size_t j, OGRPolygon& polygon)
+    {
+        CellView gridCell (gridCorners, i, j);
+        CellView sourceCell (sourceCorners, i, j);
+
+        OGRLinearRing* ring = polygon.getExteriorRing ();
+        if (!ring)
+        {
+            ring = new OGRLinearRing ();
+            polygon.addRingDirectly (ring);
+        }
+        ring->empty ();
+        for (size_t corner = 0; corner < 4; ++corner)
+        {
+            const size_t next = (corner + 1)%4;
+            ring->addPoint (sourceCell.getX (corner), sourceCell.getY (corner));
+            densify (trafo, *ring,
+                    gridCell.getX (corner), gridCell.getY (corner),
+                    gridCell.getX (next), gridCell.getY (next),
+                    sourceCell.getX (corner), sourceCell.getY (corner),
+                    sourceCell.getX (next), sourceCell.getY (next), 0);
+        }
+        ring->addPoint (sourceCell.getX (0), sourceCell.getY (0));
+    }
+
+    /**
+     * @brief Read and clip the polygons of one cell in source coordinates
+     */
+    void clipInSource (FeatureCursor& cursor, OGRCoordinateTransformation* trafo,
+            const CornerLattice& gridCorners, const CornerLattice& sourceCorners,
+            size_t i, size_t j, OGRPolygon& cellPolygon, FractionGrid& fractions)
+    {
+        double start = stats::now ();
+        fillSourcePolygon (trafo, gridCorners, sourceCorners, i, j, cellPolygon);
+        stats::add (stats::reprojectTime, stats::now () - start);
+
+        // the ratio of areas in one coordinate system, the scale factor of
+        // the projection is nearly constant within a cell
+        // ------------------------------------------------------------------
+        const double cellArea = getArea (&cellPolygon);
+        if (cellArea <= 0.0)
+            return;
+
+        OGREnvelope envelope;
+        cellPolygon.getEnvelope (&envelope);
+        cursor.setSpatialFilter (envelope);
+        stats::count (stats::cellsQueried);
+
+        size_t candidates = 0;
+        double clipTime = 0.0;
+        start = stats::now ();
+        OGRGeometry* geometry;
+        while ((geometry = cursor.next ()))
+        {
+            candidates++;
+            double clipStart = stats::now ();
+            if (geometry->Intersects (&cellPolygon))
+            {
+                OGRGeometry* intersection = geometry->Intersection (&cellPolygon);
+                stats::count (stats::intersections);
+                if (intersection)
+                {
+                    fractions.add (i, j, cursor.getClass (), getArea (intersection)/cellArea);
+                    OGRGeometryFactory::destroyGeometry (intersection);
+                }
+            }
+            OGRGeometryFactory::destroyGeometry (geometry);
+            clipTime += stats::now () - clipStart;
+        }
+        stats::add (stats::readTime, stats::now () - start - clipTime);
+        stats::add (stats::clipTime, clipTime);
+        if (candidates > 0)
+        {
+            stats::count (stats::cellsWithCandidates);
+            stats::count (stats::candidates, candidates);
+        }
+    }
+
+    /**
+     * @brief The cache of the simplified polygons of a shape file
+     */
+    string getCacheFileName (string directory, string fileName, double tolerance)
+    {
+        string name = fileName.substr (fileName.find_last_of ('/') + 1);
+        name = name.substr (0, name.find_last_of ('.'));
+        std::ostringstream stream;
+        stream << directory << "/" << name << "_" << tolerance << ".simplified";
+        return stream.str ();
+    }
+
+    bool isOlder (string fileName, string otherFileName)
+    {
+        struct stat status;
+        struct stat otherStatus;
+        return stat (fileName.c_str (), &status) == 0
+           and stat (otherFileName.c_str (), &otherStatus) == 0
+           and status.st_mtime < otherStatus.st_mtime;
+    }
+
+}
+
+ReadOptions::ReadOptions ()
+    : reader ("mapped"), simplifyFactor (0.0), splitPointCount (0), filePrefix ("clc06_c"),
+      compressResolution (0.0)
+{}
+
+double overlay::getArea (const OGRGeometry* geometry)
+{
+    switch (wkbFlatten (geometry->getGeometryType ()))
+    {
+        case wkbPolygon:
+            return ((const OGRPolygon*) geometry)->get_Area ();
+        case wkbMultiPolygon:
+        case wkbGeometryCollection:
+            return ((const OGRGeometryCollection*) geometry)->get_Area ();
+        default:
+            return 0.0;
+    }
+}
+
+size_t overlay::getPointCount (const OGRGeometry* geometry)
+{
+    switch (wkbFlatten (geometry->getGeometryType ()))
+    {
+        case wkbPolygon:
+        {
+            const OGRPolygon* polygon = (const OGRPolygon*) geometry;
+            size_t result = 0;
+            if (polygon->getExteriorRing ())
+                result += polygon->getExteriorRing ()->getNumPoints ();
+            for (int ring = 0; ring < polygon->getNumInteriorRings (); ++ring)
+                result += polygon->getInteriorRing (ring)->getNumPoints ();
+            return result;
+        }
+        case wkbMultiPolygon:
+        case wkbGeometryCollection:
+        {
+            const OGRGeometryCollection* collection = (const OGRGeometryCollection*) geometry;
+            size_t result = 0;
+            for (int n = 0; n < collection->getNumGeometries (); ++n)
+                result += getPointCount (collection->getGeometryRef (n));
+            return result;
+        }
+        default:
+            return 0;
+    }
+}
+
+Engine::Engine ()
+    : _maxReprojectionError (0.0)
+{}
+
+Engine::~Engine ()
+{}
+
+void Engine::setMaxReprojectionError (double maxError)
+{
+    _maxReprojectionError = maxError;
+}
+
+ApproximateGrid* Engine::fitReprojection (const FeatureSource& source,
+        const CornerLattice& gridCorners, const CornerLattice& sourceCorners) const
+{
+    if (_maxReprojectionError <= 0.0 or sourceCorners.iSize () == 0)
+        return NULL;
+
+    stats::ScopedTimer timer (stats::reprojectTime);
+    OGREnvelope area;
+    area.MinX = area.MaxX = sourceCorners.getX (sourceCorners.i0 (), sourceCorners.j0 ());
+    area.MinY = area.MaxY = sourceCorners.getY (sourceCorners.i0 (), sourceCorners.j0 ());
+    for (size_t i = sourceCorners.i0 (); i <= sourceCorners.i0 () + sourceCorners.iSize (); ++i)
+        for (size_t j = sourceCorners.j0 (); j <= sourceCorners.j0 () + sourceCorners.jSize (); ++j)
+        {
+            area.MinX = std::min (area.MinX, sourceCorners.getX (i, j));
+            area.MaxX = std::max (area.MaxX, sourceCorners.getX (i, j));
+            area.MinY = std::min (area.MinY, sourceCorners.getY (i, j));
+            area.MaxY = std::max (area.MaxY, sourceCorners.getY (i, j));
+        }
+    const double marginX = reprojectionMargin*(area.MaxX - area.MinX);
+    const double marginY = reprojectionMargin*(area.MaxY - area.MinY);
+    area.MinX -= marginX;
+    area.MaxX += marginX;
+    area.MinY -= marginY;
+    area.MaxY += marginY;
+
+    return new ApproximateGrid (source.getCoordinateSystem (),
+            gridCorners.getCoordinateSystem (), area, _maxReprojectionError);
+}
+
+string ReferenceEngine::getName () const
+{
+    return "reference";
+}
+
+void ReferenceEngine::addFractions (const FeatureSource& source,
+        const CornerLattice& gridCorners, const CornerLattice& sourceCorners,
+        const CellList& cells, FractionGrid& fractions) const
+{
+    boost::scoped_ptr<FeatureCursor> cursor (source.createCursor ());
+    boost::scoped_ptr<ApproximateGrid> grid (
+            fitReprojection (source, gridCorners, sourceCorners));
+    ApproximateTransformation trafo (grid.get (),
+        CrsRegistry::instance ().getTransformation (
+                source.getCoordinateSystem (), gridCorners.getCoordinateSystem ()));
+
+    OGRPolygon cellPolygon;
+    cellPolygon.assignSpatialReference (gridCorners.getCoordinateSystem ());
+
+    for (size_t n = 0; n < cells.size (); ++n)
+    {
+        CellCandidates* cell = read (*cursor, &trafo, sourceCorners, cells[n].i, cells[n].j);
+        if (cell)
+            clip (cell, gridCorners, cellPolygon, fractions);
+    }
+}
+
+PipelinedEngine::PipelinedEngine (size_t readerCount)
+    : _readerCount (readerCount)
+{}
+
+string PipelinedEngine::getName () const
+{
+    return "pipelined";
+}
+
+void PipelinedEngine::addFractions (const FeatureSource& source,
+        const CornerLattice& gridCorners, const CornerLattice& sourceCorners,
+        const CellList& cells, FractionGrid& fractions) const
+{
+#ifdef DEBUG2
+    const size_t cellCount = std::min ((size_t) 1, cells.size ());
+#else
+    const size_t cellCount = cells.size ();
+#endif
+
+    // the fit is shared, every reader has its own exact fallback //
+    //-------------------------------------------------------------//
+    boost::scoped_ptr<ApproximateGrid> grid (
+            fitReprojection (source, gridCorners, sourceCorners));
+
+    CandidateQueue queue (queueCapacity);
+    FirstException error;
+    boost::atomic<size_t> nextCell (0);
+    boost::atomic<size_t> finishedReaders (0);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        // the first threads read, the others clip //
+        //-----------------------------------------//
+        size_t thread = 0;
+        size_t threadCount = 1;
+#ifdef _OPENMP
+        thread = omp_get_thread_num ();
+        threadCount = omp_get_num_threads ();
+#endif
+        const bool pipelined = threadCount > 1;
+        const size_t readers = pipelined
+            ? std::max ((size_t) 1, std::min (_readerCount, threadCount - 1))
+            : 1;
+
+        OGRPolygon cellPolygon;
+        cellPolygon.assignSpatialReference (gridCorners.getCoordinateSystem ());
+
+        if (thread < readers)
+        {
+            try
+            {
+                boost::scoped_ptr<FeatureCursor> cursor (source.createCursor ());
+                ApproximateTransformation trafo (grid.get (),
+                    CrsRegistry::instance ().getTransformation (
+                            source.getCoordinateSystem (), gridCorners.getCoordinateSystem ()));
+
+                size_t first;
+                while (!error.failed ()
+                        and (first = nextCell.fetch_add (cellChunk)) < cellCount)
+                    for (size_t n = first; n < std::min (first + cellChunk, cellCount); ++n)
+                    {
+                        CellCandidates* cell = read (*cursor, &trafo, sourceCorners,
+                                cells[n].i, cells[n].j);
+                        if (!cell)
+                            continue;
+                        if (!pipelined)
+                            clip (cell, gridCorners, cellPolygon, fractions);
+                        else if (!queue.tryPush (cell))
+                        {
+                            stats::ScopedTimer timer (stats::queueFullTime);
+                            if (!queue.push (cell))
+                            {
+                                // the queue is only closed early when a clipper failed //
+                                //-------------------------------------------------------//
+                                discard (cell);
+                                break;
+                            }
+                        }
+                    }
+            }
+            catch (...)
+            {
+                error.capture ();
+            }
+
+            // the last reader tells the clippers that the queue is complete //
+            //----------------------------------------------------------------//
+            if (finishedReaders.fetch_add (1) + 1 == readers)
+                queue.close ();
+        }
+        else
+        {
+            try
+            {
+                CellCandidates* cell;
+                while (true)
+                {
+                    if (!queue.tryPop (cell))
+                    {
+                        stats::ScopedTimer timer (stats::queueEmptyTime);
+                        if (!queue.pop (cell))
+                            break;
+                    }
+                    if (error.failed ())
+                        discard (cell);
+                    else
+                        clip (cell, gridCorners, cellPolygon, fractions);
+                }
+            }
+            catch (...)
+            {
+                error.capture ();
+                queue.close ();
+            }
+        }
+    }
+
+    // the cells left behind when every clipper failed //
+    //--------------------------------------------------//
+    CellCandidates* cell;
+    while (queue.tryPop (cell))
+        discard (cell);
+    error.rethrow ();
+}
+
+const double ReverseEngine::densifyTolerance = 1.0e-6;
+const size_t ReverseEngine::maxDensifyDepth;
+
+string ReverseEngine::getName () const
+{
+    return "reverse";
+}
+
+void ReverseEngine::addFractions (const FeatureSource& source,
+        const CornerLattice& gridCorners, const CornerLattice& sourceCorners,
+        const CellList& cells, FractionGrid& fractions) const
+{
+    boost::atomic<size_t> nextCell (0);
+    FirstException error;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        // the polygons are never reprojected, so no thread waits for another //
+        //---------------------------------------------------------------------//
+        try
+        {
+            boost::scoped_ptr<FeatureCursor> cursor (source.createCursor ());
+            OGRCoordinateTransformation* trafo =
+                CrsRegistry::instance ().getTransformation (
+                        gridCorners.getCoordinateSystem (), source.getCoordinateSystem ());
+
+            OGRPolygon cellPolygon;
+            cellPolygon.assignSpatialReference (source.getCoordinateSystem ());
+
+            size_t first;
+            while (!error.failed ()
+                    and (first = nextCell.fetch_add (cellChunk)) < cells.size ())
+                for (size_t n = first; n < std::min (first + cellChunk, cells.size ()); ++n)
+                    clipInSource (*cursor, trafo, gridCorners, sourceCorners,
+                            cells[n].i, cells[n].j, cellPolygon, fractions);
+        }
+        catch (...)
+        {
+            // densify throws for edges that cannot be reprojected //
+            //------------------------------------------------------//
+            error.capture ();
+        }
+    }
+    error.rethrow ();
+}
+
+void overlay::getCellRing (OGRCoordinateTransformation* trafo,
+        const CornerLattice& gridCorners, const CornerLattice& corners,
+        size_t i, size_t j, Ring& ring)
+{
+    CellView gridCell (gridCorners, i, j);
+    CellView cell (corners, i, j);
+
+    ring.x.clear ();
+    ring.y.clear ();
+    for (size_t corner = 0; corner < 4; ++corner)
+    {
+        const size_t next = (corner + 1)%4;
+        ring.addPoint (cell.getX (corner), cell.getY (corner));
+        densify (trafo, ring,
+                gridCell.getX (corner), gridCell.getY (corner),
+                gridCell.getX (next), gridCell.getY (next),
+                cell.getX (corner), cell.getY (corner),
+                cell.getX (next), cell.getY (next), 0);
+    }
+}
+
+Engine* overlay::createEngine (string name, size_t readerCount)
+{
+    if (name == "reverse")
+        return new ReverseEngine;
+    if (name == "reference")
+        return new ReferenceEngine;
+    if (name == "pipelined")
+        return new PipelinedEngine (readerCount);
+    throw UnknownEngineException ();
+}
+
+CellList overlay::getAllCells (size_t iSize, size_t jSize)
+{
+    CellList cells (iSize*jSize);
+    for (size_t i = 0; i < iSize; ++i)
+        for (size_t j = 0; j < jSize; ++j)
+        {
+            cells[i*jSize + j].i = i;
+            cells[i*jSize + j].j = j;
+        }
+    return cells;
+}
+
+CellList overlay::getWindowCells (const Window& window)
+{
+    CellList cells;
+    cells.reserve (window.iSize ()*window.jSize ());
+    for (size_t i = window.i0; i < window.i1; ++i)
+        for (size_t j = window.j0; j < window.j1; ++j)
+        {
+            Cell cell;
+            cell.i = i;
+            cell.j = j;
+            cells.push_back (cell);
+        }
+    return cells;
+}
+
+Window overlay::getCornerWindow (const CellList& cells, size_t iSize, size_t jSize)
+{
+    Window window = {0, 0, 0, 0};
+    if (cells.empty ())
+        return window;
+
+    window.i0 = window.i1 = cells[0].i;
+    window.j0 = window.j1 = cells[0].j;
+    for (size_t n = 1; n < cells.size (); ++n)
+    {
+        window.i0 = std::min (window.i0, cells[n].i);
+        window.i1 = std::max (window.i1, cells[n].i);
+        window.j0 = std::min (window.j0, cells[n].j);
+        window.j1 = std::max (window.j1, cells[n].j);
+    }
+    window.i0 = window.i0 > cornerBorder ? window.i0 - cornerBorder : 0;
+    window.j0 = window.j0 > cornerBorder ? window.j0 - cornerBorder : 0;
+    window.i1 = std::min (window.i1 + 1 + cornerBorder, iSize);
+    window.j1 = std::min (window.j1 + 1 + cornerBorder, jSize);
+    return window;
+}
+
+CellList overlay::getSampleCells (size_t iSize, size_t jSize, size_t count, unsigned int seed)
+{
+    if (count >= iSize*jSize)
+        return getAllCells (iSize, jSize);
+
+    // partial Fisher-Yates shuffle of the cell numbers //
+    //--------------------------------------------------//
+    std::vector<size_t> numbers (iSize*jSize);
+    for (size_t n = 0; n < numbers.size (); ++n)
+        numbers[n] = n;
+    unsigned long state = seed;
+    for (size_t n = 0; n < count; ++n)
+    {
+        state = state*6364136223846793005ul + 1442695040888963407ul;
+        size_t k = n + (state >> 17)%(numbers.size () - n);
+        std::swap (numbers[n], numbers[k]);
+    }
+    std::sort (numbers.begin (), numbers.begin () + count);
+
+    CellList cells (count);
+    for (size_t n = 0; n < count; ++n)
+    {
+        cells[n].i = numbers[n]/jSize;
+        cells[n].j = numbers[n]%jSize;
+    }
+    return cells;
+}
+
+namespace
+{
+
+    /**
+     * @brief Simplify and split the polygons of a source as requested
+     *
+     * @param source   The source, owned by the function
+     * @param fileName The file of the source, names its cache
+     *
+     * @return The source to read from, owned by the caller; the decorated
+     *         sources keep their polygons in memory, so the original source
+     *         is deleted
+     */
+    FeatureSource* prepare (FeatureSource* source, string fileName, double cellSize,
+            const ReadOptions& options, bool verbose)
+    {
+        // the cell size and the rounding are given in metres //
+        //----------------------------------------------------//
+        const double metresPerUnit = getMetresPerUnit (source->getCoordinateSystem ());
+        if (cellSize > 0.0)
+            cellSize /= metresPerUnit;
+        const double resolution = options.compressResolution > 0.0
+            ? options.compressResolution/metresPerUnit : 0.0;
+
+        // the polygons are kept packed, e.g. to hold all of Europe; the
+        // stages below pack them batch by batch, so they are never all
+        // unpacked in memory
+        // -----------------------------------------------------------------
+        const MemoryFeatureSource* packed = NULL;
+
+        // detail below the resolution of the grid is removed //
+        //----------------------------------------------------//
+        const double tolerance = options.simplifyFactor*cellSize;
+        if (tolerance > 0.0)
+        {
+            string cacheFile;
+            if (!options.cacheDirectory.empty ())
+            {
+                cacheFile = getCacheFileName (options.cacheDirectory, fileName, tolerance);
+                if (isOlder (cacheFile, fileName))
+                    std::remove (cacheFile.c_str ());
+            }
+
+            SimplifiedFeatureSource* simplified =
+                new SimplifiedFeatureSource (*source, tolerance, cacheFile, resolution);
+            if (verbose)
+                std::cout << "simplified " << simplified->getOriginalPointCount ()
+                          << " to " << simplified->getPointCount () << " points" << std::endl;
+            delete source;
+            source = simplified;
+            packed = simplified->isPacked () ? simplified : NULL;
+        }
+
+        // huge polygons are split into pieces along multiples of the cell size //
+        //-----------------------------------------------------------------------//
+        if (options.splitPointCount > 0)
+        {
+            SubdividedFeatureSource* subdivided = new SubdividedFeatureSource (
+                    *source, options.splitPointCount, cellSize, resolution);
+            if (verbose)
+                std::cout << "split " << subdivided->getSplitCount ()
+                          << " polygons into pieces" << std::endl;
+            delete source;
+            source = subdivided;
+            packed = subdivided->isPacked () ? subdivided : NULL;
+        }
+
+        if (resolution > 0.0 and !packed)
+        {
+            CompressedFeatureSource* compressed =
+                new CompressedFeatureSource (*source, resolution);
+            delete source;
+            source = compressed;
+            packed = compressed;
+        }
+        if (verbose and packed)
+            std::cout << "packed " << packed->getPointCount () << " points into "
+                      << packed->getByteCount () << " bytes" << std::endl;
+
+        return source;
+    }
+
+}
+
+SourceList overlay::openCorineSources (string directory, double cellSize,
+        const ReadOptions& options, bool verbose)
+{
+    // the classes are read together, in one pass per coordinate system //
+    //-------------------------------------------------------------------//
+    SourceList passes;
+    if (!options.classAttribute.empty ())
+    {
+        // a single layer of all classes, the directory names its file //
+        //--------------------------------------------------------------//
+        if (verbose) std::cout << "working on corine file " << directory << std::endl;
+        std::vector<int> codes (corine::typeCount);
+        for (size_t type = 0; type < corine::typeCount; ++type)
+            codes[type] = corine::getCode (type);
+        passes.push_back (boost::shared_ptr<FeatureSource> (prepare (
+                        new OgrClassFeatureSource (directory, options.classAttribute, codes),
+                        directory, cellSize, options, verbose)));
+    }
+    else
+    {
+        std::map<OGRSpatialReference*, MultiClassFeatureSource*> classSources;
+#ifdef DEBUG
+        for (size_t type = 0; type < 1; ++type)
+#else
+        for (size_t type = 0; type < corine::typeCount; ++type)
+#endif
+        {
+            string fileName = corine::getFileName (directory, type, options.filePrefix);
+            if (verbose) std::cout << "working on corine file " << fileName << std::endl;
+
+            FeatureSource* source = createFeatureSource (options.reader, fileName);
+            if (source->empty ())
+            {
+                delete source;
+                continue;
+            }
+            source = prepare (source, fileName, cellSize, options, verbose);
+
+            MultiClassFeatureSource*& classSource =
+                classSources[source->getCoordinateSystem ()];
+            if (!classSource)
+            {
+                classSource = new MultiClassFeatureSource;
+                passes.push_back (boost::shared_ptr<FeatureSource> (classSource));
+            }
+            classSource->add (source, type);
+        }
+    }
+    return passes;
+}
+
+void overlay::addFractions (const Engine& engine, const SourceList& sources,
+        const GeoRaster& grid, const CellList& cells, FractionGrid& fractions)
+{
+    // the corners of the cells only, in grid and in CORINE coordinates //
+    //------------------------------------------------------------------//
+    if (cells.empty ())
+        return;
+    const Window window = getCornerWindow (cells, grid.iSize (), grid.jSize ());
+    const CornerLattice gridCorners = grid.getCornerLattice (window);
+    bool scaled = false;
+    for (size_t n = 0; n < sources.size (); ++n)
+    {
+        if (sources[n]->empty ()) continue;
+        engine.addFractions (*sources[n], gridCorners,
+                grid.getCornerLattice (window, sources[n]->getCoordinateSystem ()),
+                cells, fractions);
+
+        // the area a class lost or gained by simplification is corrected //
+        //-----------------------------------------------------------------//
+        for (size_t type = 0; type < fractions.typeCount (); ++type)
+        {
+            const double factor = sources[n]->getAreaFactor (type);
+            if (factor != 1.0)
+            {
+                for (size_t k = 0; k < cells.size (); ++k)
+                    fractions.scale (cells[k].i, cells[k].j, type, factor);
+                scaled = true;
+            }
+        }
+    }
+
+    // the factors hold for the whole domain, not for every cell, so a cell
+    // whose simplified polygons grew can get more than all of its area
+    // --------------------------------------------------------------------
+    if (scaled)
+        for (size_t k = 0; k < cells.size (); ++k)
+            if (fractions.limit (cells[k].i, cells[k].j, 1.0))
+                stats::count (stats::limitedCells);
+}
+
+void overlay::addCorineFractions (const Engine& engine, string directory,
+        const GeoRaster& grid, const CellList& cells, FractionGrid& fractions,
+        const ReadOptions& options, bool verbose)
+{
+    addFractions (engine, openCorineSources (directory, grid.getCellSizeInMetres (), options,
+                verbose), grid, cells, fractions);
+}
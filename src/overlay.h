@@ -0,0 +1,324 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <string>
+#include <vector>
+#include <ogr_geometry.h>
+#include <boost/shared_ptr.hpp>
+#include "sparseFractions.h"
+#include "geoRaster.h"
+#include "featureSource.h"
+#include "window.h"
+#include "approximateTransformation.h"
+
+struct Ring;
+
+namespace overlay
+{
+
+    typedef SparseFractionGrid FractionGrid;
+
+    /**
+     * @brief Maximum number of cells waiting between readers and workers
+     */
+    const size_t queueCapacity = 4096;
+
+    /**
+     * @brief Number of cells around the cells of a run whose corners are
+     *        reprojected as well, see getCornerWindow
+     */
+    const size_t cornerBorder = 2;
+
+    /**
+     * @brief Bytes of the corner of a cell in grid and in source
+     *        coordinates, to size windows for a memory budget
+     */
+    const size_t cornerSize = 4*sizeof (double);
+
+    struct Cell
+    {
+        size_t i;
+        size_t j;
+    };
+
+    typedef std::vector<Cell> CellList;
+
+    class UnknownEngineException {};
+
+    /**
+     * @brief How the polygons of the CORINE classes are read
+     */
+    struct ReadOptions
+    {
+        // the reader of the shape files, see createFeatureSource
+        std::string reader;
+
+        // the tolerance of the simplification relative to the cell size of
+        // the grid, 0.0 for the original polygons
+        double simplifyFactor;
+
+        // the directory of the simplified polygons, empty for no cache
+        std::string cacheDirectory;
+
+        // polygons with more points are split into pieces, 0 for none
+        size_t splitPointCount;
+
+        // the attribute holding the CORINE code if all classes are in a
+        // single layer, the directory then names that dataset; empty for one
+        // shape file per class
+        std::string classAttribute;
+
+        // the prefix of the shape files of the classes, see
+        // corine::getFileName
+        std::string filePrefix;
+
+        // the rounding in metres of the coordinates of polygons kept packed
+        // in memory, see MemoryFeatureSource; 0.0 to keep them as they are
+        double compressResolution;
+
+        ReadOptions ();
+    };
+
+    /**
+     * @brief All cells of a grid, row by row along j
+     */
+    CellList getAllCells (size_t iSize, size_t jSize);
+
+    /**
+     * @brief All cells of a window, in the order of getAllCells
+     */
+    CellList getWindowCells (const Window& window);
+
+    /**
+     * @brief The window of the corners needed for some cells
+     *
+     * The smallest window holding all cells, with a border of cornerBorder
+     * cells within the grid. The approximate reprojection is fitted on the
+     * corners of the window, so the border keeps the fitted area of a thin
+     * band of rows from ending right at its cells.
+     */
+    Window getCornerWindow (const CellList& cells, size_t iSize, size_t jSize);
+
+    /**
+     * @brief A random subset of the cells of a grid, in the order of
+     *        getAllCells
+     *
+     * @param count Number of cells, all cells if larger than the grid
+     * @param seed  Seed of the random selection
+     */
+    CellList getSampleCells (size_t iSize, size_t jSize, size_t count, unsigned int seed);
+
+    /**
+     * @brief The area of a polygon or of a collection of polygons
+     *
+     * @param geometry Any geometry, e.g. the result of an intersection
+     *
+     * @return The area, 0.0 for geometries without area
+     */
+    double getArea (const OGRGeometry* geometry);
+
+    /**
+     * @brief The number of points of all rings of a polygon or of a
+     *        collection of polygons
+     */
+    size_t getPointCount (const OGRGeometry* geometry);
+
+    /**
+     * @brief A way to compute the area fractions of the polygons of all
+     *        classes in grid cells
+     */
+    class Engine
+    {
+      protected:
+        double _maxReprojectionError;
+
+        /**
+         * @brief Fit the reprojection from a source to the grid on the
+         *        area of the cells
+         *
+         * @return The fit, owned by the caller; NULL for exact reprojection
+         */
+        ApproximateGrid* fitReprojection (const FeatureSource& source,
+                const CornerLattice& gridCorners,
+                const CornerLattice& sourceCorners) const;
+
+      public:
+        Engine ();
+        virtual ~Engine ();
+        virtual std::string getName () const = 0;
+
+        /**
+         * @brief Reproject the polygons with an ApproximateGrid
+         *
+         * @param maxError The largest position error in grid coordinates,
+         *                 e.g. metres; 0.0 for exact reprojection
+         */
+        void setMaxReprojectionError (double maxError);
+
+        /**
+         * @brief Add the area fractions of the polygons to cells of a grid
+         *
+         * Every polygon is added to the fractions of its class, see
+         * FeatureCursor::getClass, so all classes are done in one pass.
+         *
+         * @param source        The polygons of the classes
+         * @param gridCorners   The cell corners in grid coordinates
+         * @param sourceCorners The cell corners in the coordinates of the source
+         * @param cells         The cells to compute
+         * @param fractions     The fractions of every cell
+         */
+        virtual void addFractions (const FeatureSource& source,
+                const CornerLattice& gridCorners, const CornerLattice& sourceCorners,
+                const CellList& cells, FractionGrid& fractions) const = 0;
+    };
+
+    /**
+     * @brief Reads and clips one cell after the other in the calling thread
+     *
+     * Other engines are checked against this one.
+     */
+    class ReferenceEngine : public Engine
+    {
+      public:
+        std::string getName () const;
+        void addFractions (const FeatureSource&,
+                const CornerLattice&, const CornerLattice&,
+                const CellList&, FractionGrid&) const;
+    };
+
+    /**
+     * @brief Pipelines reading and clipping
+     *
+     * Reader threads query, decode and reproject the polygons of each cell
+     * and pass them through a bounded BlockingQueue to worker threads,
+     * which only clip them with the cell and accumulate the fractions.
+     * Readers of a full and workers of an empty queue sleep on its condition
+     * variables, see stats::queueFullTime and stats::queueEmptyTime. With
+     * a single thread, reading and clipping alternate.
+     */
+    class PipelinedEngine : public Engine
+    {
+      private:
+        size_t _readerCount;
+      public:
+        /**
+         * @param readerCount The number of reader threads
+         */
+        PipelinedEngine (size_t readerCount);
+        std::string getName () const;
+        void addFractions (const FeatureSource&,
+                const CornerLattice&, const CornerLattice&,
+                const CellList&, FractionGrid&) const;
+    };
+
+    /**
+     * @brief Clips in the coordinate system of the polygons
+     *
+     * Only the cells are reprojected: their edges are densified until they
+     * follow the curvature of the projection. The polygons are clipped
+     * unchanged, and the fraction is the ratio of the areas in the
+     * coordinate system of the polygons, so the local scale factor of the
+     * projection cancels out. Every thread reads and clips its own cells.
+     * An edge that cannot be reprojected stops all threads, and the
+     * CrsTransformationException is thrown by addFractions.
+     */
+    class ReverseEngine : public Engine
+    {
+      public:
+
+        /**
+         * @brief The largest distance of a densified cell edge from the
+         *        projected edge, relative to the length of the edge
+         */
+        static const double densifyTolerance;
+
+        /**
+         * @brief Maximum depth of the recursive bisection of an edge
+         */
+        static const size_t maxDensifyDepth = 6;
+
+        std::string getName () const;
+        void addFractions (const FeatureSource&,
+                const CornerLattice&, const CornerLattice&,
+                const CellList&, FractionGrid&) const;
+    };
+
+    /**
+     * @brief The outline of a cell in another coordinate system, its edges
+     *        densified like the cells of the ReverseEngine
+     *
+     * @param trafo       The transformation from the grid to the other
+     *                    coordinate system
+     * @param gridCorners The corners in the coordinate system of the grid
+     * @param corners     The same corners in the other coordinate system
+     * @param ring        Replaced by the outline, not closed
+     *
+     * @throws CrsTransformationException for an edge that cannot be
+     *         reprojected
+     */
+    void getCellRing (OGRCoordinateTransformation* trafo,
+            const CornerLattice& gridCorners, const CornerLattice& corners,
+            size_t i, size_t j, Ring& ring);
+
+    /**
+     * @brief Create an engine by name
+     *
+     * @param name        "reference", "pipelined" or "reverse"
+     * @param readerCount The number of reader threads of pipelined engines
+     *
+     * @return A new engine owned by the caller
+     */
+    Engine* createEngine (std::string name, size_t readerCount);
+
+    /**
+     * @brief The sources of the CORINE classes, one per pass of an engine
+     */
+    typedef std::vector<boost::shared_ptr<FeatureSource> > SourceList;
+
+    /**
+     * @brief Open the polygons of all CORINE classes
+     *
+     * The classes are read together, in a single source, or in one source
+     * per coordinate system if the shape files differ. Simplified or split
+     * polygons are prepared here once, the sources can be used for any
+     * number of calls of addFractions.
+     *
+     * @param directory The directory of the CORINE shape files, or the
+     *                  dataset of all classes, see ReadOptions::classAttribute
+     * @param cellSize  The cell size in metres of the grids the polygons
+     *                  are simplified and split for, converted to the units
+     *                  of the polygons, see GeoRaster::getCellSizeInMetres
+     * @param options   How the polygons are read
+     * @param verbose   Print the name of every file
+     */
+    SourceList openCorineSources (std::string directory, double cellSize,
+            const ReadOptions& options, bool verbose);
+
+    /**
+     * @brief Add the fractions of the polygons of all sources
+     *
+     * The fractions of a class are multiplied by the area factor of its
+     * source, see FeatureSource::getAreaFactor. If any factor is applied,
+     * the fractions of a cell summing up to more than 1 are scaled down to
+     * 1, counted as stats::limitedCells.
+     *
+     * @param engine    The engine computing the fractions
+     * @param sources   The sources, see openCorineSources
+     * @param grid      The grid of the cells
+     * @param cells     The cells to compute
+     * @param fractions The fractions of every cell
+     */
+    void addFractions (const Engine& engine, const SourceList& sources,
+            const GeoRaster& grid, const CellList& cells, FractionGrid& fractions);
+
+    /**
+     * @brief Add the fractions of all CORINE classes, see openCorineSources
+     *        and addFractions
+     */
+    void addCorineFractions (const Engine& engine, std::string directory,
+            const GeoRaster& grid, const CellList& cells, FractionGrid& fractions,
+            const ReadOptions& options, bool verbose);
+
+}
+
+#endif
@@ -0,0 +1,200 @@
+#include "partialFile.h"
+#include "clm.h"
+
+using std::string;
+
+using namespace wrf;
+
+namespace
+{
+    const char* windowI0Name = "WINDOW_I0";
+    const char* windowJ0Name = "WINDOW_J0";
+    const char* parentISizeName = "PARENT_WEST_EAST";
+    const char* parentJSizeName = "PARENT_SOUTH_NORTH";
+
+    size_t getSizeAttribute (NcFile& file, const char* name)
+    {
+        boost::scoped_ptr<NcAtt> attribute (file.get_att (name));
+        if (!attribute)
+            throw WrongPartialFileException ();
+        return attribute->as_int (0);
+    }
+}
+
+PartialFile::PartialFile (string fileName, const Window& window,
+        size_t parentISize, size_t parentJSize)
+    : NcFile (fileName.c_str (), Replace),
+      _window (window),
+      _parentISize (parentISize),
+      _parentJSize (parentJSize),
+      _errorBehavior (new NcError (NcError::silent_nonfatal))
+{
+    if (!is_valid ())
+        throw WrongPartialFileException ();
+
+    add_dim ("Time", 1);
+    add_dim ("south_north", window.jSize ());
+    add_dim ("west_east", window.iSize ());
+
+    add_att (windowI0Name, (int) window.i0);
+    add_att (windowJ0Name, (int) window.j0);
+    add_att (parentISizeName, (int) parentISize);
+    add_att (parentJSizeName, (int) parentJSize);
+
+    for (size_t type = 0; type < clm::typeCount - 1; type++)
+        getVariable (pftVariableName (clmPFTtypeFractionName, type));
+    getVariable ("waterFraction");
+    getVariable ("urbanFraction");
+    getVariable ("glacierFraction");
+    getVariable ("wetlandFraction");
+}
+
+PartialFile::PartialFile (string fileName)
+    : NcFile (fileName.c_str (), ReadOnly),
+      _errorBehavior (new NcError (NcError::silent_nonfatal))
+{
+    if (!is_valid ())
+        throw WrongPartialFileException ();
+
+    NcDim* iDimension = get_dim ("west_east");
+    NcDim* jDimension = get_dim ("south_north");
+    if (iDimension == NULL or jDimension == NULL)
+        throw WrongPartialFileException ();
+
+    _window.i0 = getSizeAttribute (*this, windowI0Name);
+    _window.j0 = getSizeAttribute (*this, windowJ0Name);
+    _window.i1 = _window.i0 + iDimension->size ();
+    _window.j1 = _window.j0 + jDimension->size ();
+    _parentISize = getSizeAttribute (*this, parentISizeName);
+    _parentJSize = getSizeAttribute (*this, parentJSizeName);
+
+    if (_window.i1 > _parentISize or _window.j1 > _parentJSize)
+        throw WrongPartialFileException ();
+}
+
+PartialFile::~PartialFile ()
+{
+    close ();
+}
+
+const Window& PartialFile::getWindow () const
+{
+    return _window;
+}
+
+size_t PartialFile::parentISize () const
+{
+    return _parentISize;
+}
+
+size_t PartialFile::parentJSize () const
+{
+    return _parentJSize;
+}
+
+NcVar* PartialFile::getVariable (string varName)
+{
+    NcVar* variable = get_var (varName.c_str ());
+    if (!variable)
+    {
+        const NcDim* dims[3];
+        dims[0] = get_dim ("Time");
+        dims[1] = get_dim ("south_north");
+        dims[2] = get_dim ("west_east");
+
+        variable = add_var (varName.c_str (), ncFloat, 3, dims);
+        if (!variable)
+            throw VariableNotExistException ();
+    }
+    return variable;
+}
+
+void PartialFile::write (string varName, size_t iOffset, size_t jOffset,
+        const float* data, size_t iCount, size_t jCount)
+{
+    if (   iOffset < _window.i0 or iOffset + iCount > _window.i1
+        or jOffset < _window.j0 or jOffset + jCount > _window.j1)
+        throw WrongDimensionSizeException ();
+
+    long offset[3] = {0, (long) (jOffset - _window.j0), (long) (iOffset - _window.i0)};
+    long counts[3] = {1, (long) jCount, (long) iCount};
+
+#ifdef _OPENMP
+    File::lock ();
+#endif
+    NcVar* variable = getVariable (varName);
+    variable->set_cur (offset);
+    variable->put (data, counts);
+#ifdef _OPENMP
+    File::unlock ();
+#endif
+}
+
+void PartialFile::read (string varName, float* data)
+{
+    NcVar* variable = get_var (varName.c_str ());
+    if (!variable)
+        throw VariableNotExistException ();
+
+    long counts[3] = {1, (long) _window.jSize (), (long) _window.iSize ()};
+
+#ifdef _OPENMP
+    File::lock ();
+#endif
+    variable->get (data, counts);
+#ifdef _OPENMP
+    File::unlock ();
+#endif
+}
+
+void PartialFile::writeBand (const OutputBand& band)
+{
+    if (band.clmPftTypeFractions.shape ()[0] < clm::typeCount - 1)
+        throw WrongDimensionSizeException ();
+
+    const size_t iCount = band.waterFraction.shape ()[1];
+    const size_t jCount = band.waterFraction.shape ()[0];
+
+    for (size_t type = 0; type < clm::typeCount - 1; type++)
+        write (pftVariableName (clmPFTtypeFractionName, type),
+                band.iOffset, band.jOffset,
+                &band.clmPftTypeFractions[type][0][0], iCount, jCount);
+    write ("waterFraction", band.iOffset, band.jOffset,
+            band.waterFraction.data (), iCount, jCount);
+    write ("urbanFraction", band.iOffset, band.jOffset,
+            band.urbanFraction.data (), iCount, jCount);
+    write ("glacierFraction", band.iOffset, band.jOffset,
+            band.glacierFraction.data (), iCount, jCount);
+    write ("wetlandFraction", band.iOffset, band.jOffset,
+            band.wetlandFraction.data (), iCount, jCount);
+}
+
+void PartialFile::mergeInto (File& wrf)
+{
+    if (wrf.iSize () != _parentISize or wrf.jSize () != _parentJSize)
+        throw WrongPartialFileException ();
+
+    // the whole window is copied with one read and one write per variable //
+    //----------------------------------------------------------------------//
+    const size_t iCount = _window.iSize ();
+    const size_t jCount = _window.jSize ();
+
+    OutputBand band;
+    band.iOffset = _window.i0;
+    band.jOffset = _window.j0;
+    band.clmPftTypeFractions.resize (boost::extents[clm::typeCount - 1][jCount][iCount]);
+    band.waterFraction.resize (boost::extents[jCount][iCount]);
+    band.urbanFraction.resize (boost::extents[jCount][iCount]);
+    band.glacierFraction.resize (boost::extents[jCount][iCount]);
+    band.wetlandFraction.resize (boost::extents[jCount][iCount]);
+
+    for (size_t type = 0; type < clm::typeCount - 1; type++)
+        read (pftVariableName (clmPFTtypeFractionName, type),
+                &band.clmPftTypeFractions[type][0][0]);
+    read ("waterFraction", band.waterFraction.data ());
+    read ("urbanFraction", band.urbanFraction.data ());
+    read ("glacierFraction", band.glacierFraction.data ());
+    read ("wetlandFraction", band.wetlandFraction.data ());
+
+    wrf.writeBand (band);
+}
@@ -0,0 +1,73 @@
+#ifndef PARTIALFILE_H
+#define PARTIALFILE_H
+
+#include <netcdfcpp.h>
+#include <string>
+#include <boost/scoped_ptr.hpp>
+#include <boost/multi_array.hpp>
+#include "wrf.h"
+#include "window.h"
+
+namespace wrf
+{
+
+    class WrongPartialFileException {};
+
+    /**
+     * @brief The output of a window of a WRF grid
+     *
+     * Holds the same variables as the output in the WRF file, but only for
+     * the cells of the window. The window and the size of the whole grid
+     * are stored as global attributes, so partial files of different
+     * windows can be merged into the WRF file later.
+     */
+    class PartialFile : public NcFile, public BandWriter
+    {
+      private:
+        Window _window;
+        size_t _parentISize;
+        size_t _parentJSize;
+        boost::scoped_ptr<NcError> _errorBehavior;
+
+        NcVar* getVariable (std::string);
+        void write (std::string, size_t, size_t, const float*, size_t, size_t);
+        void read (std::string, float*);
+
+      public:
+        /**
+         * @brief Create a partial file, replacing an existing one
+         *
+         * @param fileName    Name of the new file
+         * @param window      The window of the output
+         * @param parentISize Size of the whole grid along i
+         * @param parentJSize Size of the whole grid along j
+         */
+        PartialFile (std::string fileName, const Window& window,
+                size_t parentISize, size_t parentJSize);
+
+        /**
+         * @brief Open an existing partial file for reading
+         */
+        PartialFile (std::string fileName);
+        ~PartialFile ();
+
+        const Window& getWindow () const;
+        size_t parentISize () const;
+        size_t parentJSize () const;
+
+        /**
+         * @brief Write a band, its offsets refer to the whole grid
+         */
+        void writeBand (const OutputBand&);
+
+        /**
+         * @brief Copy the window into the output of a WRF file
+         *
+         * The WRF file must have the grid the partial file was made for.
+         */
+        void mergeInto (File& wrf);
+    };
+
+}
+
+#endif
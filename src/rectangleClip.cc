@@ -0,0 +1,69 @@
+#include <cmath>
+#include "rectangleClip.h"
+
+size_t Ring::size () const
+{
+    return x.size ();
+}
+
+void Ring::addPoint (double pointX, double pointY)
+{
+    x.push_back (pointX);
+    y.push_back (pointY);
+}
+
+namespace
+{
+
+    /**
+     * @brief Keep the part of a ring where sign*(coordinate - limit) >= 0
+     *
+     * @param alongX Clip at a vertical line x = limit, else at y = limit
+     */
+    void clip (const Ring& input, Ring& output, bool alongX, double limit, double sign)
+    {
+        output.x.clear ();
+        output.y.clear ();
+        const size_t count = input.size ();
+        for (size_t n = 0; n < count; ++n)
+        {
+            const size_t previous = (n + count - 1)%count;
+            const double currentValue = alongX ? input.x[n] : input.y[n];
+            const double previousValue = alongX ? input.x[previous] : input.y[previous];
+            const bool currentInside = sign*(currentValue - limit) >= 0.0;
+            const bool previousInside = sign*(previousValue - limit) >= 0.0;
+
+            if (currentInside != previousInside)
+            {
+                const double t = (limit - previousValue)/(currentValue - previousValue);
+                output.addPoint (input.x[previous] + t*(input.x[n] - input.x[previous]),
+                                 input.y[previous] + t*(input.y[n] - input.y[previous]));
+            }
+            if (currentInside)
+                output.addPoint (input.x[n], input.y[n]);
+        }
+    }
+
+}
+
+double getArea (const Ring& ring)
+{
+    double area = 0.0;
+    const size_t count = ring.size ();
+    for (size_t n = 0; n < count; ++n)
+    {
+        const size_t next = (n + 1)%count;
+        area += ring.x[n]*ring.y[next] - ring.x[next]*ring.y[n];
+    }
+    return fabs (area)/2.0;
+}
+
+double getClippedArea (const Ring& ring, double minX, double minY, double maxX, double maxY,
+        Ring buffer[2])
+{
+    clip (ring, buffer[0], true, minX, 1.0);
+    clip (buffer[0], buffer[1], true, maxX, -1.0);
+    clip (buffer[1], buffer[0], false, minY, 1.0);
+    clip (buffer[0], buffer[1], false, maxY, -1.0);
+    return buffer[1].size () < 3 ? 0.0 : getArea (buffer[1]);
+}
@@ -0,0 +1,38 @@
+#ifndef RECTANGLECLIP_H
+#define RECTANGLECLIP_H
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief A polygon ring as arrays of coordinates, without the closing point
+ */
+struct Ring
+{
+    std::vector<double> x;
+    std::vector<double> y;
+
+    size_t size () const;
+    void addPoint (double x, double y);
+};
+
+/**
+ * @brief The area enclosed by a ring, positive for either orientation
+ */
+double getArea (const Ring& ring);
+
+/**
+ * @brief The area of the part of a polygon inside an axis-parallel
+ *        rectangle
+ *
+ * The ring is clipped at the four sides of the rectangle one after the
+ * other. The result may contain degenerate edges along the sides, which
+ * do not change its area, so the polygon need not be convex.
+ *
+ * @param ring    The polygon
+ * @param buffer  Memory for the intermediate rings, reused between calls
+ */
+double getClippedArea (const Ring& ring, double minX, double minY, double maxX, double maxY,
+        Ring buffer[2]);
+
+#endif
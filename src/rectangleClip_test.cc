@@ -0,0 +1,49 @@
+#define BOOST_TEST_MODULE RectangleClip
+#include <boost/test/unit_test.hpp>
+#include "rectangleClip.h"
+
+BOOST_AUTO_TEST_CASE( rectangleClip_test )
+{
+    Ring buffer[2];
+
+    // a square covering a quarter of the rectangle
+    Ring square;
+    square.addPoint (1.0, 1.0);
+    square.addPoint (3.0, 1.0);
+    square.addPoint (3.0, 3.0);
+    square.addPoint (1.0, 3.0);
+    BOOST_CHECK_CLOSE (getArea (square), 4.0, 1.0e-10);
+    BOOST_CHECK_CLOSE (getClippedArea (square, 0.0, 0.0, 2.0, 2.0, buffer), 1.0, 1.0e-10);
+    BOOST_CHECK_CLOSE (getClippedArea (square, 0.0, 0.0, 5.0, 5.0, buffer), 4.0, 1.0e-10);
+    BOOST_CHECK_EQUAL (getClippedArea (square, 4.0, 4.0, 5.0, 5.0, buffer), 0.0);
+
+    // the orientation does not matter
+    Ring reversed;
+    for (size_t n = square.size (); n > 0; --n)
+        reversed.addPoint (square.x[n - 1], square.y[n - 1]);
+    BOOST_CHECK_CLOSE (getClippedArea (reversed, 0.0, 0.0, 2.0, 2.0, buffer), 1.0, 1.0e-10);
+
+    // a concave polygon, a U open to the top
+    Ring u;
+    u.addPoint (0.0, 0.0);
+    u.addPoint (3.0, 0.0);
+    u.addPoint (3.0, 3.0);
+    u.addPoint (2.0, 3.0);
+    u.addPoint (2.0, 1.0);
+    u.addPoint (1.0, 1.0);
+    u.addPoint (1.0, 3.0);
+    u.addPoint (0.0, 3.0);
+    BOOST_CHECK_CLOSE (getArea (u), 7.0, 1.0e-10);
+    BOOST_CHECK_CLOSE (getClippedArea (u, 0.0, 2.0, 3.0, 3.0, buffer), 2.0, 1.0e-10);
+
+    // the areas clipped by a tiling of the plane add up to the whole area
+    Ring triangle;
+    triangle.addPoint (0.3, 0.2);
+    triangle.addPoint (4.7, 1.1);
+    triangle.addPoint (2.2, 3.9);
+    double sum = 0.0;
+    for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < 4; ++j)
+            sum += getClippedArea (triangle, i, j, i + 1.0, j + 1.0, buffer);
+    BOOST_CHECK_CLOSE (sum, getArea (triangle), 1.0e-10);
+}
@@ -0,0 +1,728 @@
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <boost/multi_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/atomic.hpp>
+#include <ogrsf_frmts.h>
+#include <cpl_conv.h>
+#include "runs.h"
+#include "corine.h"
+#include "clm.h"
+#include "wrf.h"
+#include "asyncWriter.h"
+#include "partialFile.h"
+#include "fractionFile.h"
+#include "masterFile.h"
+#include "epochs.h"
+#include "jobServer.h"
+#include "window.h"
+#include "crsRegistry.h"
+#include "geoRaster.h"
+#include "featureSource.h"
+#include "threads.h"
+#include "stats.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::cerr;
+using std::endl;
+
+using namespace overlay;
+
+/**
+ * @brief Cell sizes closer than this part of them are the same
+ */
+static const double cellSizeTolerance = 1.0e-6;
+
+static void getPlane (const boost::multi_array<double, 3>& planes, size_t type,
+        boost::multi_array<float, 2>& result)
+{
+    result.resize (boost::extents[planes.shape ()[1]][planes.shape ()[2]]);
+    for (size_t j = 0; j < planes.shape ()[1]; ++j)
+        for (size_t i = 0; i < planes.shape ()[2]; ++i)
+            result[j][i] = planes[type][j][i];
+}
+
+static wrf::BandWriter& openClmOutput (wrf::File& wrf, const Window& window,
+        const string partialFileName, boost::scoped_ptr<wrf::PartialFile>& partialFile)
+{
+    if (partialFileName.empty ())
+    {
+        wrf.defineClmOutput ();
+        return wrf;
+    }
+    partialFile.reset (new wrf::PartialFile (partialFileName, window,
+                wrf.iSize (), wrf.jSize ()));
+    return *partialFile;
+}
+
+static void writeClmOutput (wrf::File& wrf, const string wrfFileName,
+        const FractionGrid& fractions, const Window& window,
+        const MappingMatrix& clmMapping, wrf::BandWriter& output, int verbosity)
+{
+#ifdef _OPENMP
+    boost::scoped_ptr<omp_lock_t> lock (new omp_lock_t);
+    omp_init_lock (lock.get ());
+#endif
+
+#ifndef NOOUTPUT
+    // the CLM types and the derived fractions are computed by one mapping //
+    //---------------------------------------------------------------------//
+    const MappingMatrix mapping = clmMapping.stack (corine::derivedMapping ());
+    const MappingMatrix& landUseMapping = wrf.getLandUseMapping ();
+
+    // one thread writes, the original land use is read through its own handle //
+    //---------------------------------------------------------------------------//
+    wrf::File landUseFile (wrfFileName, wrf::File::ReadOnly);
+    wrf::AsyncWriter writer (output);
+
+    // the planes of LANDUSEF are the sources of the mapping //
+    //--------------------------------------------------------//
+    NcDim* landCatDim = landUseFile.get_dim ("land_cat_stag");
+    if (landCatDim == NULL) throw wrf::UnknownLUTypeException ();
+    if ((size_t) landCatDim->size () != landUseMapping.sourceCount ())
+        throw wrf::WrongDimensionSizeException ();
+
+    const size_t bandSize = 16;
+    const size_t iCount = window.iSize ();
+#ifdef DEBUG3
+    const size_t bandCount = 1;
+#else
+    const size_t bandCount = (window.jSize () + bandSize - 1)/bandSize;
+#endif
+    boost::atomic<size_t> nextBand (0);
+    boost::atomic<size_t> finishedComputers (0);
+    FirstException error;
+
+    double outputStart = stats::now ();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+        size_t thread = 0;
+        size_t threadCount = 1;
+#ifdef _OPENMP
+        thread = omp_get_thread_num ();
+        threadCount = omp_get_num_threads ();
+#endif
+        const bool pipelined = threadCount > 1;
+
+        if (pipelined and thread == 0)
+        {
+            // a failed writer is closed, so the compute threads stop //
+            //---------------------------------------------------------//
+            try
+            {
+                writer.run ();
+            }
+            catch (...)
+            {
+                error.capture ();
+                writer.close ();
+            }
+        }
+        else
+        {
+            try
+            {
+                size_t band;
+                while (!error.failed () and (band = nextBand.fetch_add (1)) < bandCount)
+                {
+                    const size_t jOffset = window.j0 + band*bandSize;
+                    const size_t jCount = std::min (bandSize, window.j1 - jOffset);
+                    const size_t planeSize = jCount*iCount;
+                    double mapStart = stats::now ();
+
+                    // map the corine fractions to CLM and derived fractions, the
+                    // sparse fractions of the band are only made dense here
+                    // -----------------------------------------------------------
+                    boost::multi_array<double, 3> corinePlanes (
+                            boost::extents[corine::typeCount][jCount][iCount]);
+                    for (size_t j = 0; j < jCount; ++j)
+                        for (size_t i = 0; i < iCount; ++i)
+                        {
+                            const SparseFractions& cell = fractions (window.i0 + i, jOffset + j);
+                            for (size_t n = 0; n < cell.size (); ++n)
+                                corinePlanes[cell.getType (n)][j][i] = cell.getValue (n);
+                        }
+
+                    boost::multi_array<double, 3> planes (
+                            boost::extents[mapping.targetCount ()][jCount][iCount]);
+                    mapping.apply (corinePlanes.data (), planeSize, planes.data ());
+
+                    // if missing is too large, fill with default values from the
+                    // original WRF file mapped to CLM types
+                    // ----------------------------------------------------------
+                    boost::multi_array<double, 3> originalPlanes;
+                    for (size_t j = 0; j < jCount; ++j)
+                        for (size_t i = 0; i < iCount; ++i)
+                        {
+                            double missing = 1.0;
+                            for (size_t type = 0; type < clm::typeCount; ++type)
+                                missing -= planes[type][j][i];
+
+                            if (missing > 1.0e-5)
+                            {
+                                stats::count (stats::fallbackCells);
+
+                                if (verbosity > 1)
+                                {
+#ifdef _OPENMP
+                                    omp_set_lock (lock.get ());
+#endif
+                                    cerr << "WARNING: using partly original land use in grid cell "
+                                         << window.i0 + i << " " << jOffset + j << " with missing fraction of " <<
+                                         missing << endl;
+#ifdef _OPENMP
+                                    omp_unset_lock (lock.get ());
+#endif
+                                }
+
+                                if (originalPlanes.num_elements () == 0)
+                                {
+                                    boost::multi_array<float, 3> landUse =
+                                        landUseFile.getLandUseFractions (window.i0, iCount,
+                                                jOffset, jCount);
+                                    originalPlanes.resize (
+                                            boost::extents[clm::typeCount][jCount][iCount]);
+                                    landUseMapping.apply (landUse.data (), planeSize,
+                                            originalPlanes.data ());
+                                }
+
+                                for (size_t type = 0; type < clm::typeCount; ++type)
+                                    planes[type][j][i] = originalPlanes[type][j][i]*missing;
+                            }
+
+#ifdef CHECK
+                            clm::ClmFractions clmFractions;
+                            for (size_t type = 0; type < clm::typeCount; ++type)
+                                clmFractions.set (type, planes[type][j][i]);
+                            try
+                            {
+                                clmFractions.check ();
+                            }
+                            catch (std::exception& e)
+                            {
+                                cout << clmFractions << endl;
+                                throw e;
+                            }
+#endif
+                        }
+
+                    // hand the band to the writer
+                    // ---------------------------
+                    wrf::OutputBand* output = new wrf::OutputBand;
+                    output->iOffset = window.i0;
+                    output->jOffset = jOffset;
+                    output->clmPftTypeFractions.resize (
+                            boost::extents[clm::typeCount][jCount][iCount]);
+                    for (size_t type = 0; type < clm::typeCount; ++type)
+                        for (size_t j = 0; j < jCount; ++j)
+                            for (size_t i = 0; i < iCount; ++i)
+                                output->clmPftTypeFractions[type][j][i] = planes[type][j][i];
+
+                    const size_t derived = clm::typeCount;
+                    getPlane (planes, derived + corine::waterFraction, output->waterFraction);
+                    getPlane (planes, derived + corine::artificialFraction, output->urbanFraction);
+                    getPlane (planes, derived + corine::glacierFraction, output->glacierFraction);
+                    getPlane (planes, derived + corine::wetlandFraction, output->wetlandFraction);
+                    stats::add (stats::mapTime, stats::now () - mapStart);
+
+                    if (!pipelined)
+                        writer.write (output);
+                    else if (!writer.submit (output))
+                        break;
+                }
+            }
+            catch (...)
+            {
+                error.capture ();
+            }
+
+            // the last compute thread lets the writer finish //
+            //--------------------------------------------------//
+            if (pipelined and finishedComputers.fetch_add (1) + 1 == threadCount - 1)
+                writer.close ();
+        }
+    }
+    stats::add (stats::outputPhase, stats::now () - outputStart);
+#endif
+
+#ifdef _OPENMP
+    omp_destroy_lock (lock.get ());
+#endif
+
+#ifndef NOOUTPUT
+    // the bands a failed writer left in the queue go with it //
+    //---------------------------------------------------------//
+    error.rethrow ();
+#endif
+}
+
+RunOptions::RunOptions ()
+    : maxMemory (0), verbosity (0)
+{}
+
+void overlay::mergePartialFiles (string wrfFileName, const vector<string>& partialFileNames,
+        bool verbose)
+{
+    wrf::File wrf (wrfFileName, wrf::File::Write);
+    wrf.defineClmOutput ();
+
+    for (size_t n = 0; n < partialFileNames.size (); ++n)
+    {
+        wrf::PartialFile partial (partialFileNames[n]);
+        if (verbose)
+        {
+            const Window& window = partial.getWindow ();
+            cout << "merging " << partialFileNames[n] << " with window "
+                 << window.i0 << ":" << window.i1 << ","
+                 << window.j0 << ":" << window.j1 << endl;
+        }
+        partial.mergeInto (wrf);
+    }
+}
+
+/**
+ * @brief Bytes of a cell on its way to the CLM output, see writeClmOutput
+ *
+ * A band is mapped in dense planes of doubles, filled from the original land
+ * use if needed and copied into an OutputBand. The writer of a tile only
+ * holds bands of that tile, so all of them together need at most this much
+ * per cell of the tile, however many bands are queued.
+ */
+static const size_t outputCellSize =
+    (corine::typeCount + clm::typeCount + corine::derivedTypeCount)*sizeof (double)
+    + (2*clm::typeCount + corine::derivedTypeCount)*sizeof (float);
+
+/**
+ * @brief The windows computed one after the other
+ *
+ * @param maxMemory The budget of a tile in bytes, 0 for the whole window
+ *                  at once
+ * @param cellSize  The bytes of a cell of a tile in all stages of the run
+ * @param verbose   Warn if a single cell exceeds the budget
+ */
+static vector<Window> getTiles (const Window& window, size_t maxMemory, size_t cellSize,
+        bool verbose)
+{
+    if (maxMemory == 0)
+        return vector<Window> (1, window);
+    if (maxMemory < cellSize and verbose)
+        cerr << "WARNING: a cell needs " << cellSize << " bytes, more than the "
+             << maxMemory << " bytes of --max-memory" << endl;
+    return splitWindow (window, maxMemory/cellSize);
+}
+
+/**
+ * @brief The cells to compute, the window or tile of the options
+ */
+static Window getWindow (const RunOptions& options, size_t iSize, size_t jSize)
+{
+    if (!options.window.empty ())
+        return parseWindow (options.window, iSize, jSize);
+    if (!options.tile.empty ())
+        return parseTile (options.tile, iSize, jSize);
+    return getFullWindow (iSize, jSize);
+}
+
+void overlay::runOverlay (string corineDirectory, string wrfFileName,
+        const MappingMatrix& clmMapping, const Engine& engine,
+        const ReadOptions& readOptions, const RunOptions& options,
+        const landCover::Source* preparedSource)
+{
+    // Open WRF file, it is only read if the output goes to a partial file or
+    // if only the overlay is done
+    // ----------------------------------------------------------------------
+    const bool readOnly = !options.partialFile.empty () or !options.fractionFile.empty ();
+    wrf::File wrf (wrfFileName, readOnly ? wrf::File::ReadOnly : wrf::File::Write);
+    if (!(wrf.isUsgsLUType () or wrf.isModisLUType ()))
+        throw wrf::UnknownLUTypeException ();
+
+    const Window window = getWindow (options, wrf.iSize (), wrf.jSize ());
+    const size_t cellSize = FractionGrid::expectedCellSize () + cornerSize
+        + (options.fractionFile.empty () ? outputCellSize : 0);
+    const vector<Window> tiles = getTiles (window, options.maxMemory, cellSize,
+            options.verbosity > 0);
+    if (options.verbosity > 0)
+        cout << "window = " << window.i0 << ":" << window.i1 << ","
+             << window.j0 << ":" << window.j1 << " in " << tiles.size () << " tiles" << endl;
+
+    OGRRegisterAll();
+
+    // the polygons are opened once for all tiles, unless the fractions are
+    // remapped from a master file or the polygons are prepared already
+    // --------------------------------------------------------------------
+    double overlayStart = stats::now ();
+    boost::scoped_ptr<const landCover::Source> openedSource;
+    boost::scoped_ptr<MasterFile> master;
+    const landCover::Source* source = preparedSource;
+    if (!options.masterFile.empty ())
+        master.reset (new MasterFile (options.masterFile));
+    else if (!source)
+    {
+        openedSource.reset (new landCover::Source (corineDirectory, readOptions,
+                    wrf.getCellSizeInMetres (), options.verbosity > 0));
+        source = openedSource.get ();
+    }
+    stats::add (stats::overlayPhase, stats::now () - overlayStart);
+
+    // the overlay stage ends with the CORINE fractions, see remapFractionFile //
+    //--------------------------------------------------------------------------//
+    boost::scoped_ptr<FractionFile> fractionFile;
+    boost::scoped_ptr<wrf::PartialFile> partialFile;
+    wrf::BandWriter* output = NULL;
+    if (!options.fractionFile.empty ())
+        fractionFile.reset (new FractionFile (options.fractionFile, window,
+                    wrf.iSize (), wrf.jSize ()));
+    else
+        output = &openClmOutput (wrf, window, options.partialFile, partialFile);
+
+    // only the fractions of one tile are kept, each is written before the
+    // next one is computed
+    // -------------------------------------------------------------------
+    for (size_t n = 0; n < tiles.size (); ++n)
+    {
+        const Window& tile = tiles[n];
+        FractionGrid fractions (tile.iSize (), tile.jSize (), corine::typeCount,
+                tile.i0, tile.j0);
+
+        overlayStart = stats::now ();
+        if (master)
+            remapMaster (*master, wrf, tile, fractions);
+        else
+            addFractions (engine, source->getSources (), wrf,
+                    getWindowCells (tile), fractions);
+        stats::add (stats::overlayPhase, stats::now () - overlayStart);
+
+        if (options.verbosity > 0)
+            cout << "fraction storage of tile " << n << ": "
+                 << fractions.memoryUsage () << " bytes" << endl;
+
+        if (fractionFile)
+        {
+            double fractionFileStart = stats::now ();
+            fractionFile->write (fractions);
+            stats::add (stats::fractionFilePhase, stats::now () - fractionFileStart);
+        }
+        else
+            writeClmOutput (wrf, wrfFileName, fractions, tile, clmMapping, *output,
+                    options.verbosity);
+    }
+}
+
+/**
+ * @brief Runs the jobs of the server with the polygons loaded once, see
+ *        serveJobs
+ *
+ * Polygons simplified or split by the server only fit grids of its cell
+ * size, other jobs are rejected.
+ */
+class OverlayJobRunner : public jobServer::JobRunner
+{
+  private:
+    const landCover::Source&    _source;
+    const double                _cellSize;
+    const ReadOptions&          _readOptions;
+    const string                _mappingTableFileName;
+    const string                _engineName;
+    const size_t                _readerCount;
+    const double                _reprojectionError;
+    const RunOptions&           _options;
+    const int                   _threadCount;
+
+  public:
+    /**
+     * @param cellSize The cell size in metres the source is prepared for,
+     *                 0.0 if it fits all grids
+     */
+    OverlayJobRunner (const landCover::Source& source, double cellSize,
+            const ReadOptions& readOptions,
+            const string mappingTableFileName, const string engineName, size_t readerCount,
+            double reprojectionError, const RunOptions& options, int threadCount)
+        : _source (source),
+          _cellSize (cellSize),
+          _readOptions (readOptions),
+          _mappingTableFileName (mappingTableFileName),
+          _engineName (engineName),
+          _readerCount (readerCount),
+          _reprojectionError (reprojectionError),
+          _options (options),
+          _threadCount (threadCount)
+    {}
+
+    void run (const jobServer::Job& job)
+    {
+        if (!job.has ("wrfFile"))
+            throw jobServer::JobFormatException ();
+        if (    _cellSize > 0.0
+            and fabs (wrf::File (job.get ("wrfFile")).getCellSizeInMetres () - _cellSize)
+                    > cellSizeTolerance*_cellSize)
+            throw jobServer::WrongGridException ();
+
+        // the server itself runs single threaded, see serveJobs //
+        //--------------------------------------------------------//
+#ifdef _OPENMP
+        omp_set_num_threads (_threadCount);
+#endif
+
+        boost::scoped_ptr<MappingMatrix> mappingTable;
+        const string mappingTableFileName = job.get ("mappingTable", _mappingTableFileName);
+        if (!mappingTableFileName.empty ())
+            mappingTable.reset (new MappingMatrix (corine::typeCount, clm::typeCount,
+                        mappingTableFileName));
+
+        boost::scoped_ptr<Engine> engine (createEngine (
+                    job.get ("engine", _engineName),
+                    job.has ("readerThreads") ? atoi (job.get ("readerThreads").c_str ())
+                                              : _readerCount));
+        engine->setMaxReprojectionError (job.has ("reprojectionError")
+                ? atof (job.get ("reprojectionError").c_str ()) : _reprojectionError);
+
+        RunOptions options;
+        options.window = job.get ("window");
+        options.tile = job.get ("tile");
+        options.partialFile = job.get ("partial");
+        options.fractionFile = job.get ("fractionFile");
+        options.maxMemory = job.has ("maxMemory")
+            ? (size_t) (atof (job.get ("maxMemory").c_str ())*1024*1024) : _options.maxMemory;
+        options.verbosity = _options.verbosity;
+
+        runOverlay ("", job.get ("wrfFile"),
+                mappingTable ? *mappingTable : corine::clmMapping (), *engine,
+                _readOptions, options, &_source);
+    }
+};
+
+void overlay::serveJobs (string socketName, size_t jobCount, string corineDirectory,
+        string wrfFileName, const ReadOptions& readOptions,
+        string mappingTableFileName, string engineName, size_t readerCount,
+        double reprojectionError, const RunOptions& options)
+{
+    // the server loads with a single thread, so that no OpenMP threads
+    // exist when the jobs are forked; the jobs use all threads again
+    // -----------------------------------------------------------------
+    int threadCount = 1;
+#ifdef _OPENMP
+    threadCount = omp_get_max_threads ();
+    omp_set_num_threads (1);
+#endif
+
+    OGRRegisterAll();
+
+    // simplified and split polygons are prepared for the grid of the WRF
+    // file and only serve jobs of its cell size, other polygons do not
+    // depend on a grid
+    // -------------------------------------------------------------------
+    double cellSize = 0.0;
+    if (readOptions.simplifyFactor > 0.0 or readOptions.splitPointCount > 0)
+        cellSize = wrf::File (wrfFileName).getCellSizeInMetres ();
+    const landCover::Source source (corineDirectory, readOptions, cellSize,
+            options.verbosity > 0);
+
+    OverlayJobRunner runner (source, cellSize, readOptions, mappingTableFileName, engineName,
+            readerCount, reprojectionError, options, threadCount);
+    jobServer::serve (socketName, jobCount, runner, options.verbosity > 0);
+}
+
+void overlay::runEpochs (const vector<string>& epochTexts, string wrfFileName,
+        const Engine& engine, const ReadOptions& readOptions, const RunOptions& options)
+{
+    // the epochs after the first are updated by their change layers //
+    //----------------------------------------------------------------//
+    vector<Epoch> epochs;
+    for (size_t n = 0; n < epochTexts.size (); ++n)
+    {
+        epochs.push_back (parseEpoch (epochTexts[n]));
+        if (n > 0 and epochs.back ().changeLayer.empty ())
+            throw EpochFormatException ();
+    }
+    if (options.fractionFile.empty ())
+        throw NoFractionFileException ();
+
+    wrf::File wrf (wrfFileName, wrf::File::ReadOnly);
+    const Window window = getWindow (options, wrf.iSize (), wrf.jSize ());
+
+    // the fractions of a tile of two epochs are kept at once //
+    //--------------------------------------------------------//
+    const vector<Window> tiles = getTiles (window, options.maxMemory,
+            2*FractionGrid::expectedCellSize () + cornerSize, options.verbosity > 0);
+    if (options.verbosity > 0)
+        cout << "window = " << window.i0 << ":" << window.i1 << ","
+             << window.j0 << ":" << window.j1 << " in " << tiles.size () << " tiles, "
+             << epochs.size () << " epochs" << endl;
+
+    OGRRegisterAll();
+
+    // the epochs are computed one after the other, so only the polygons of
+    // one epoch are in memory; the fractions of the previous epoch are read
+    // back from its fraction file
+    // ---------------------------------------------------------------------
+    for (size_t n = 0; n < epochs.size (); ++n)
+    {
+        double overlayStart = stats::now ();
+        const string fractionFileName = getEpochFileName (options.fractionFile, epochs[n]);
+        boost::scoped_ptr<FeatureSource> changes (epochs[n].changeLayer.empty ()
+                ? NULL : createFeatureSource (readOptions.reader, epochs[n].changeLayer));
+        boost::scoped_ptr<FractionFile> previousFile (n == 0 ? NULL
+                : new FractionFile (getEpochFileName (options.fractionFile, epochs[n - 1])));
+        boost::scoped_ptr<FractionFile> fractionFile (new FractionFile (fractionFileName,
+                    window, wrf.iSize (), wrf.jSize ()));
+        stats::add (stats::overlayPhase, stats::now () - overlayStart);
+
+        // the polygons are only read once a tile has changed cells //
+        //-----------------------------------------------------------//
+        boost::scoped_ptr<landCover::Source> source;
+        ReadOptions epochOptions (readOptions);
+        epochOptions.filePrefix = epochs[n].filePrefix;
+
+        for (size_t t = 0; t < tiles.size (); ++t)
+        {
+            const Window& tile = tiles[t];
+            FractionGrid fractions (tile.iSize (), tile.jSize (), corine::typeCount,
+                    tile.i0, tile.j0);
+
+            // the first epoch is a full overlay, the others only redo the
+            // cells of their changes
+            // -------------------------------------------------------------
+            overlayStart = stats::now ();
+            CellList cells = getWindowCells (tile);
+            if (previousFile)
+            {
+                FractionGrid previous (tile.iSize (), tile.jSize (), corine::typeCount,
+                        tile.i0, tile.j0);
+                double fractionFileStart = stats::now ();
+                previousFile->read (previous);
+                stats::add (stats::fractionFilePhase, stats::now () - fractionFileStart);
+
+                cells = getChangedCells (engine, *changes, wrf, tile);
+                copyUnchangedFractions (previous, cells, fractions);
+                stats::count (stats::changedCells, cells.size ());
+            }
+            if (!cells.empty ())
+            {
+                if (!source)
+                    source.reset (new landCover::Source (epochs[n].directory, epochOptions,
+                                wrf.getCellSizeInMetres (), options.verbosity > 0));
+                addFractions (engine, source->getSources (), wrf, cells, fractions);
+            }
+            stats::add (stats::overlayPhase, stats::now () - overlayStart);
+
+            if (options.verbosity > 0)
+                cout << "epoch " << epochs[n].label << ", tile " << t << ": "
+                     << cells.size () << " cells computed" << endl;
+
+            double fractionFileStart = stats::now ();
+            fractionFile->write (fractions);
+            stats::add (stats::fractionFilePhase, stats::now () - fractionFileStart);
+        }
+    }
+}
+
+void overlay::buildMasterFile (string corineDirectory, string masterFileName,
+        const Engine& engine, const ReadOptions& readOptions, const double extent[4],
+        double cellSize, size_t levelCount, const RunOptions& options)
+{
+    OGRRegisterAll();
+
+    double overlayStart = stats::now ();
+    const landCover::Source source (corineDirectory, readOptions, cellSize,
+            options.verbosity > 0);
+    stats::add (stats::overlayPhase, stats::now () - overlayStart);
+    if (source.getSources ().empty ())
+        throw WrongMasterFileException ();
+
+    // the master grid is in the coordinate system of the polygons, CORINE
+    // is given in an equal-area one
+    // ---------------------------------------------------------------------
+    char* wkt = NULL;
+    source.getSources ()[0]->getCoordinateSystem ()->exportToWkt (&wkt);
+    const string coordinateSystem (wkt);
+    CPLFree (wkt);
+
+    if (extent[2] <= extent[0] or extent[3] <= extent[1])
+        throw WrongMasterFileException ();
+    const double sourceCellSize =
+        cellSize/getMetresPerUnit (source.getSources ()[0]->getCoordinateSystem ());
+    const size_t iSize = (size_t) ceil ((extent[2] - extent[0])/sourceCellSize);
+    const size_t jSize = (size_t) ceil ((extent[3] - extent[1])/sourceCellSize);
+
+    MasterFile master (masterFileName, extent[0], extent[1], sourceCellSize,
+            iSize, jSize, levelCount, coordinateSystem);
+    double geoTransform[6];
+    master.getGeoTransform (0, geoTransform);
+    const landCover::Grid grid (iSize, jSize, geoTransform, coordinateSystem);
+
+    const Window window = getFullWindow (iSize, jSize);
+    const vector<Window> tiles = getTiles (window, options.maxMemory,
+            FractionGrid::expectedCellSize () + cornerSize, options.verbosity > 0);
+    if (options.verbosity > 0)
+        cout << "master grid " << iSize << "x" << jSize << " in "
+             << tiles.size () << " tiles" << endl;
+
+    for (size_t n = 0; n < tiles.size (); ++n)
+    {
+        const Window& tile = tiles[n];
+        FractionGrid fractions (tile.iSize (), tile.jSize (), corine::typeCount,
+                tile.i0, tile.j0);
+
+        overlayStart = stats::now ();
+        addFractions (engine, source.getSources (), grid,
+                getWindowCells (tile), fractions);
+        stats::add (stats::overlayPhase, stats::now () - overlayStart);
+
+        double fractionFileStart = stats::now ();
+        master.write (fractions);
+        stats::add (stats::fractionFilePhase, stats::now () - fractionFileStart);
+    }
+
+    double fractionFileStart = stats::now ();
+    master.buildPyramid ();
+    stats::add (stats::fractionFilePhase, stats::now () - fractionFileStart);
+}
+
+void overlay::remapFractionFile (string fractionFileName, string wrfFileName,
+        const MappingMatrix& clmMapping, const RunOptions& options)
+{
+    const bool partial = !options.partialFile.empty ();
+    wrf::File wrf (wrfFileName, partial ? wrf::File::ReadOnly : wrf::File::Write);
+    if (!(wrf.isUsgsLUType () or wrf.isModisLUType ()))
+        throw wrf::UnknownLUTypeException ();
+
+    // the window is the one of the overlay //
+    //--------------------------------------//
+    FractionFile fractionFile (fractionFileName);
+    if (   fractionFile.parentISize () != wrf.iSize ()
+        or fractionFile.parentJSize () != wrf.jSize ())
+        throw WrongFractionFileException ();
+    const Window window = fractionFile.getWindow ();
+    const vector<Window> tiles = getTiles (window, options.maxMemory,
+            FractionGrid::expectedCellSize () + outputCellSize, options.verbosity > 0);
+
+    if (options.verbosity > 0)
+        cout << "remapping " << fractionFileName << " with window "
+             << window.i0 << ":" << window.i1 << ","
+             << window.j0 << ":" << window.j1 << " in " << tiles.size () << " tiles" << endl;
+
+    boost::scoped_ptr<wrf::PartialFile> partialFile;
+    wrf::BandWriter& output = openClmOutput (wrf, window, options.partialFile, partialFile);
+
+    for (size_t n = 0; n < tiles.size (); ++n)
+    {
+        const Window& tile = tiles[n];
+        double fractionFileStart = stats::now ();
+        FractionGrid fractions (tile.iSize (), tile.jSize (), corine::typeCount,
+                tile.i0, tile.j0);
+        fractionFile.read (fractions);
+        stats::add (stats::fractionFilePhase, stats::now () - fractionFileStart);
+
+        writeClmOutput (wrf, wrfFileName, fractions, tile, clmMapping, output,
+                options.verbosity);
+    }
+}
@@ -0,0 +1,144 @@
+#ifndef RUNS_H
+#define RUNS_H
+
+#include <string>
+#include <vector>
+#include "overlay.h"
+#include "landCover.h"
+#include "mappingMatrix.h"
+
+/**
+ * The runs of corine2wrfClm on WRF files, fraction files and master files;
+ * the program only parses its options and calls one of them.
+ */
+namespace overlay
+{
+
+    class NoFractionFileException {};
+
+    /**
+     * @brief The cells of a run and where their fractions go
+     */
+    struct RunOptions
+    {
+        // the cells computed as "i0:i1,j0:j1", see parseWindow; empty for
+        // the whole grid
+        std::string window;
+
+        // the cells computed as "k/N", see parseTile; only used if window
+        // is empty
+        std::string tile;
+
+        // the CLM output goes to this file instead of the WRF file, see
+        // wrf::PartialFile
+        std::string partialFile;
+
+        // the CORINE fractions go to this file and are not mapped to CLM,
+        // see FractionFile
+        std::string fractionFile;
+
+        // the fractions are remapped from this master file instead of an
+        // overlay, see remapMaster
+        std::string masterFile;
+
+        // the memory of the fractions, the cell corners and the output bands
+        // of the cells computed at once in bytes, 0 for the whole window at
+        // once; the window is split along j and, for wide rows, along i
+        size_t maxMemory;
+
+        // 0 for no output, 1 for the progress, 2 for a warning per cell
+        // filled from the original land use
+        int verbosity;
+
+        RunOptions ();
+    };
+
+    /**
+     * @brief Compute the CLM fractions of a WRF file
+     *
+     * The CORINE fractions are written to a fraction file instead if one is
+     * given, the WRF file is only read then.
+     *
+     * @param corineDirectory The CORINE polygons, see landCover::Source
+     * @param wrfFileName     The WRF file, its grid and its original land
+     *                        use
+     * @param clmMapping      The mapping of the CORINE classes to CLM
+     * @param engine          The engine computing the fractions
+     * @param readOptions     How the polygons are read
+     * @param options         The cells and the output
+     * @param source          Polygons opened already, NULL to open them
+     *                        from corineDirectory
+     */
+    void runOverlay (std::string corineDirectory, std::string wrfFileName,
+            const MappingMatrix& clmMapping, const Engine& engine,
+            const ReadOptions& readOptions, const RunOptions& options,
+            const landCover::Source* source = NULL);
+
+    /**
+     * @brief Compute the CORINE fractions of several epochs, see Epoch
+     *
+     * Every epoch goes to its own fraction file, see getEpochFileName. The
+     * epochs are computed one after the other: the polygons of an epoch are
+     * only read if it changes a cell of the window, and the fractions of the
+     * previous epoch are read back from its fraction file.
+     *
+     * @param epochs The epochs as "label:directory:prefix[:changes]", see
+     *               parseEpoch
+     *
+     * @throws EpochFormatException    if an epoch after the first has no
+     *                                 change layer
+     * @throws NoFractionFileException if options.fractionFile is empty
+     */
+    void runEpochs (const std::vector<std::string>& epochs, std::string wrfFileName,
+            const Engine& engine, const ReadOptions& readOptions, const RunOptions& options);
+
+    /**
+     * @brief Compute the fractions of a master grid and its pyramid, see
+     *        MasterFile
+     *
+     * @param extent   The area of the grid as x0, y0, x1, y1 in the
+     *                 coordinate system of the polygons
+     * @param cellSize The cell size of level 0 in metres
+     *
+     * @throws WrongMasterFileException for an empty extent or if there are
+     *         no polygons
+     */
+    void buildMasterFile (std::string corineDirectory, std::string masterFileName,
+            const Engine& engine, const ReadOptions& readOptions, const double extent[4],
+            double cellSize, size_t levelCount, const RunOptions& options);
+
+    /**
+     * @brief Map the CORINE fractions of a fraction file to CLM and write
+     *        them to the WRF file or to a partial file
+     */
+    void remapFractionFile (std::string fractionFileName, std::string wrfFileName,
+            const MappingMatrix& clmMapping, const RunOptions& options);
+
+    /**
+     * @brief Write the partial outputs of windows to their WRF file
+     */
+    void mergePartialFiles (std::string wrfFileName,
+            const std::vector<std::string>& partialFileNames, bool verbose = false);
+
+    /**
+     * @brief Load the polygons once and run the jobs sent to a socket, see
+     *        jobServer::serve
+     *
+     * A job names its WRF file as wrfFile and may set window, tile,
+     * partial, fractionFile, mappingTable, engine, readerThreads,
+     * reprojectionError and maxMemory like the options of the same names,
+     * the arguments are the defaults.
+     *
+     * @param jobCount    The number of jobs run at once
+     * @param wrfFileName The WRF file whose cell size the polygons are
+     *                    simplified and split for, jobs of other cell
+     *                    sizes are rejected then
+     */
+    void serveJobs (std::string socketName, size_t jobCount, std::string corineDirectory,
+            std::string wrfFileName, const ReadOptions& readOptions,
+            std::string mappingTableFileName, std::string engineName, size_t readerCount,
+            double reprojectionError, const RunOptions& options);
+
+}
+
+#endif
@@ -1,8 +1,13 @@
 
 #include "shapeFile.h"
+#include "envelopeIndex.h"
+#include "crsRegistry.h"
+#include "overlay.h"
 #include <iostream>
+#include <algorithm>
 
 using std::string;
+using std::vector;
 
 ShapeFile::ShapeFile (string fileName)
 {
@@ -41,37 +46,190 @@ OGRFeature* ShapeFile::getNextFeature ()
     return _layer->GetNextFeature ();
 }
 
+/**
+ * @brief A set of target polygons of an area ratio computation
+ */
+class AreaRatioTargets
+{
+  public:
+    virtual ~AreaRatioTargets () {}
+    virtual size_t size () const = 0;
+    virtual void getEnvelope (size_t, OGREnvelope*) const = 0;
+    virtual double getArea (size_t) const = 0;
+
+    /**
+     * @brief The polygon of a target, possibly filled into scratch
+     */
+    virtual const OGRGeometry* getGeometry (size_t, OGRPolygon& scratch) const = 0;
+};
+
+namespace
+{
+
+    class GeometryTargets : public AreaRatioTargets
+    {
+      private:
+        const vector<OGRGeometry*>& _geometries;
+      public:
+        GeometryTargets (const vector<OGRGeometry*>& geometries)
+            : _geometries (geometries)
+        {}
+        size_t size () const
+        {
+            return _geometries.size ();
+        }
+        void getEnvelope (size_t n, OGREnvelope* envelope) const
+        {
+            _geometries[n]->getEnvelope (envelope);
+        }
+        double getArea (size_t n) const
+        {
+            return overlay::getArea (_geometries[n]);
+        }
+        const OGRGeometry* getGeometry (size_t n, OGRPolygon&) const
+        {
+            return _geometries[n];
+        }
+    };
+
+    class RasterTargets : public AreaRatioTargets
+    {
+      private:
+        const CornerLattice& _corners;
+      public:
+        RasterTargets (const CornerLattice& corners)
+            : _corners (corners)
+        {}
+        size_t size () const
+        {
+            return _corners.iSize ()*_corners.jSize ();
+        }
+        void getEnvelope (size_t n, OGREnvelope* envelope) const
+        {
+            CellView (_corners, n/_corners.jSize (), n%_corners.jSize ()).getEnvelope (envelope);
+        }
+        double getArea (size_t n) const
+        {
+            return CellView (_corners, n/_corners.jSize (), n%_corners.jSize ()).getArea ();
+        }
+        const OGRGeometry* getGeometry (size_t n, OGRPolygon& scratch) const
+        {
+            CellView (_corners, n/_corners.jSize (), n%_corners.jSize ()).fillPolygon (scratch);
+            return &scratch;
+        }
+    };
+
+    /**
+     * @brief Reads the whole layer, the spatial filter of the caller is
+     *        restored afterwards
+     */
+    class ScopedFilterRemoval
+    {
+      private:
+        OGRLayer*    _layer;
+        OGRGeometry* _filter;
+
+        ScopedFilterRemoval (const ScopedFilterRemoval&);
+        ScopedFilterRemoval& operator= (const ScopedFilterRemoval&);
+
+      public:
+        ScopedFilterRemoval (OGRLayer* layer)
+            : _layer (layer), _filter (layer->GetSpatialFilter ())
+        {
+            if (_filter)
+                _filter = _filter->clone ();
+            _layer->SetSpatialFilter (NULL);
+        }
+        ~ScopedFilterRemoval ()
+        {
+            _layer->SetSpatialFilter (_filter);
+            if (_filter)
+                OGRGeometryFactory::destroyGeometry (_filter);
+            _layer->ResetReading ();
+        }
+    };
+
+}
+
 const double ShapeFile::getAreaRatio (OGRGeometry* targetGeometry,
         OGRSpatialReference* targetCoordSys)
 {
-    resetFeatures ();
-    OGRSpatialReference* shapeCoordSys =
-        getNextFeature ()->GetGeometryRef ()->getSpatialReference ();
-//    OGRSpatialReference* targetCoordSys = targetGeometry->getSpatialReference ();
+    vector<OGRGeometry*> targets (1, targetGeometry);
+    return getAreaRatios (targets, targetCoordSys)[0];
+}
+
+vector<double> ShapeFile::getAreaRatios (const vector<OGRGeometry*>& targetGeometries,
+        OGRSpatialReference* targetCoordSys)
+{
+    return getAreaRatios (GeometryTargets (targetGeometries), targetCoordSys);
+}
+
+boost::multi_array<double, 2> ShapeFile::getAreaRatios (const GeoRaster& raster)
+{
+    CornerLattice corners = raster.getCornerLattice ();
+    vector<double> ratios = getAreaRatios (RasterTargets (corners),
+            raster.getCoordinateSystem ());
+
+    boost::multi_array<double, 2> result (boost::extents[raster.iSize ()][raster.jSize ()]);
+    std::copy (ratios.begin (), ratios.end (), result.data ());
+    return result;
+}
+
+vector<double> ShapeFile::getAreaRatios (const AreaRatioTargets& targets,
+        OGRSpatialReference* targetCoordSys)
+{
+    // index the envelopes of all targets //
+    //------------------------------------//
+    vector<OGREnvelope> envelopes (targets.size ());
+    for (size_t n = 0; n < targets.size (); ++n)
+        targets.getEnvelope (n, &envelopes[n]);
+    EnvelopeIndex index (envelopes);
+
     OGRCoordinateTransformation* transformation =
-        OGRCreateCoordinateTransformation (shapeCoordSys, targetCoordSys);
+        CrsRegistry::instance ().getTransformation (_coordinateSystem, targetCoordSys);
 
-    double targetArea = ((OGRPolygon*)targetGeometry)->get_Area ();
-    double shapeArea = 0.0;
+    // read and reproject every feature once //
+    //---------------------------------------//
+    vector<double> shapeArea (targets.size (), 0.0);
+    vector<size_t> candidates;
+    OGRPolygon scratch;
 
+    ScopedFilterRemoval filterRemoval (_layer);
     resetFeatures ();
     OGRFeature* feature;
     while ((feature = getNextFeature ()))
     {
-        OGRGeometry* geometry = feature->GetGeometryRef ();
+        OGRGeometry* geometry = feature->StealGeometry ();
+        OGRFeature::DestroyFeature (feature);
+        if (!geometry)
+            continue;
+
         geometry->transform (transformation);
-        if (geometry->Intersects (targetGeometry))
+        OGREnvelope envelope;
+        geometry->getEnvelope (&envelope);
+
+        candidates.clear ();
+        index.query (envelope, candidates);
+        for (size_t k = 0; k < candidates.size (); ++k)
         {
-            OGRGeometry* intersection = geometry->Intersection (targetGeometry);
-            shapeArea += ((OGRPolygon*)intersection)->get_Area ();
-            OGRGeometryFactory::destroyGeometry (intersection);
+            const OGRGeometry* target = targets.getGeometry (candidates[k], scratch);
+            if (geometry->Intersects (target))
+            {
+                OGRGeometry* intersection = geometry->Intersection (target);
+                if (intersection)
+                {
+                    shapeArea[candidates[k]] += overlay::getArea (intersection);
+                    OGRGeometryFactory::destroyGeometry (intersection);
+                }
+            }
         }
 
-        OGRFeature::DestroyFeature (feature);
+        OGRGeometryFactory::destroyGeometry (geometry);
     }
-    
-    OGRCoordinateTransformation::DestroyCT (transformation);
-    return shapeArea/targetArea;
+
+    for (size_t n = 0; n < targets.size (); ++n)
+        shapeArea[n] /= targets.getArea (n);
+    return shapeArea;
 }
 
 void ShapeFile::setSpatialFilter (OGRGeometry* filter)
@@ -3,6 +3,11 @@
 
 #include <ogrsf_frmts.h>
 #include <string>
+#include <vector>
+#include <boost/multi_array.hpp>
+#include "geoRaster.h"
+
+class AreaRatioTargets;
 
 class ShapeFile
 {
@@ -10,6 +15,7 @@ class ShapeFile
     OGRDataSource* _poDS;
     OGRLayer* _layer;
     OGRSpatialReference* _coordinateSystem;
+    std::vector<double> getAreaRatios (const AreaRatioTargets&, OGRSpatialReference*);
   public:
     ShapeFile (std::string);
     ~ShapeFile ();
@@ -18,6 +24,27 @@ class ShapeFile
     void resetFeatures ();
     OGRFeature* getNextFeature ();
     const double getAreaRatio (OGRGeometry*, OGRSpatialReference*);
+
+    /**
+     * @brief The fractions of many target geometries covered by the shapes
+     *
+     * Every feature is read and reprojected only once. The spatial filter
+     * set by setSpatialFilter does not apply and is kept for later reads.
+     *
+     * @param targets        Polygons in the target coordinate system
+     * @param targetCoordSys The target coordinate system
+     *
+     * @return One ratio of covered area per target
+     */
+    std::vector<double> getAreaRatios (const std::vector<OGRGeometry*>&, OGRSpatialReference*);
+
+    /**
+     * @brief The fractions of all cells of a raster covered by the shapes
+     *
+     * @return The ratios, indexed by [i][j] like GeoRaster::getPolygon
+     */
+    boost::multi_array<double, 2> getAreaRatios (const GeoRaster&);
+
     void setSpatialFilter (OGRGeometry*);
 };
 
@@ -0,0 +1,101 @@
+#define BOOST_TEST_MODULE ShapeFile
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+#include <ogrsf_frmts.h>
+#include "shapeFile.h"
+
+static const char* utm = "+proj=utm +zone=32 +datum=WGS84 +units=m +no_defs";
+
+static OGRPolygon* rectangle (double x0, double y0, double x1, double y1)
+{
+    OGRLinearRing* ring = new OGRLinearRing;
+    ring->addPoint (x0, y0);
+    ring->addPoint (x0, y1);
+    ring->addPoint (x1, y1);
+    ring->addPoint (x1, y0);
+    ring->closeRings ();
+    OGRPolygon* polygon = new OGRPolygon;
+    polygon->addRingDirectly (ring);
+    return polygon;
+}
+
+/**
+ * Two unit squares at x = 0 and x = 2
+ */
+static void writeSquares (std::string fileName)
+{
+    OGRRegisterAll ();
+    OGRSFDriver* driver =
+        OGRSFDriverRegistrar::GetRegistrar ()->GetDriverByName ("ESRI Shapefile");
+    BOOST_REQUIRE (driver);
+    driver->DeleteDataSource (fileName.c_str ());
+    OGRDataSource* source = driver->CreateDataSource (fileName.c_str ());
+    BOOST_REQUIRE (source);
+
+    OGRSpatialReference coordinateSystem;
+    coordinateSystem.importFromProj4 (utm);
+    OGRLayer* layer = source->CreateLayer ("squares", &coordinateSystem, wkbPolygon);
+    BOOST_REQUIRE (layer);
+    for (int square = 0; square < 2; ++square)
+    {
+        OGRFeature* feature = OGRFeature::CreateFeature (layer->GetLayerDefn ());
+        feature->SetGeometryDirectly (rectangle (2.0*square, 0.0, 2.0*square + 1.0, 1.0));
+        BOOST_REQUIRE (layer->CreateFeature (feature) == OGRERR_NONE);
+        OGRFeature::DestroyFeature (feature);
+    }
+    OGRDataSource::DestroyDataSource (source);
+}
+
+static size_t countFeatures (ShapeFile& file)
+{
+    size_t count = 0;
+    file.resetFeatures ();
+    OGRFeature* feature;
+    while ((feature = file.getNextFeature ()))
+    {
+        OGRFeature::DestroyFeature (feature);
+        ++count;
+    }
+    file.resetFeatures ();
+    return count;
+}
+
+BOOST_AUTO_TEST_CASE( spatialFilter_test )
+{
+    const std::string fileName = "shapeFile_test.shp";
+    writeSquares (fileName);
+    ShapeFile file (fileName);
+
+    OGRSpatialReference* coordinateSystem = new OGRSpatialReference;
+    coordinateSystem->importFromProj4 (utm);
+    std::vector<OGRGeometry*> targets;
+    targets.push_back (rectangle (0.0, 0.0, 2.0, 1.0));
+    targets.push_back (rectangle (2.0, 0.0, 4.0, 1.0));
+
+    // the filter of the caller selects the first square only
+    OGRPolygon* filter = rectangle (-0.5, -0.5, 1.5, 1.5);
+    file.setSpatialFilter (filter);
+    BOOST_CHECK_EQUAL (countFeatures (file), 1u);
+
+    // the ratios are computed from all squares
+    std::vector<double> ratios = file.getAreaRatios (targets, coordinateSystem);
+    BOOST_REQUIRE_EQUAL (ratios.size (), 2u);
+    BOOST_CHECK_CLOSE (ratios[0], 0.5, 1e-6);
+    BOOST_CHECK_CLOSE (ratios[1], 0.5, 1e-6);
+
+    // and the filter is still set
+    BOOST_CHECK_EQUAL (countFeatures (file), 1u);
+    BOOST_CHECK_CLOSE (file.getAreaRatio (targets[1], coordinateSystem), 0.5, 1e-6);
+    BOOST_CHECK_EQUAL (countFeatures (file), 1u);
+
+    file.setSpatialFilter (NULL);
+    BOOST_CHECK_EQUAL (countFeatures (file), 2u);
+    file.getAreaRatios (targets, coordinateSystem);
+    BOOST_CHECK_EQUAL (countFeatures (file), 2u);
+
+    OGRGeometryFactory::destroyGeometry (filter);
+    for (size_t n = 0; n < targets.size (); ++n)
+        OGRGeometryFactory::destroyGeometry (targets[n]);
+    coordinateSystem->Release ();
+}
@@ -0,0 +1,239 @@
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <boost/scoped_ptr.hpp>
+#include "simplifiedSource.h"
+#include "overlay.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using std::string;
+using std::vector;
+
+namespace
+{
+
+    /**
+     * @brief Number of polygons read before they are simplified in parallel
+     */
+    const size_t batchSize = 4096;
+
+    const char cacheMagic[8] = {'C', '2', 'W', 'S', 'I', 'M', 'P', '4'};
+
+    template<typename T>
+    void writeValue (std::ostream& stream, T value)
+    {
+        stream.write ((const char*) &value, sizeof (value));
+    }
+
+    template<typename T>
+    bool readValue (std::istream& stream, T& value)
+    {
+        return bool (stream.read ((char*) &value, sizeof (value)));
+    }
+
+}
+
+OGRGeometry* simplifyGeometry (const OGRGeometry* geometry, double tolerance)
+{
+    OGRGeometry* simplified = geometry->SimplifyPreserveTopology (tolerance);
+    if (!simplified or simplified->IsEmpty ())
+    {
+        if (simplified) OGRGeometryFactory::destroyGeometry (simplified);
+        return geometry->clone ();
+    }
+    return simplified;
+}
+
+SimplifiedFeatureSource::SimplifiedFeatureSource (const FeatureSource& source,
+        double tolerance, string cacheFile, double resolution)
+    : MemoryFeatureSource (source.getCoordinateSystem (), resolution),
+      _tolerance (tolerance),
+      _originalPointCount (0)
+{
+    if (cacheFile.empty () or !readCache (cacheFile))
+        simplify (source, cacheFile);
+    buildIndex ();
+}
+
+void SimplifiedFeatureSource::simplify (const FeatureSource& source, string cacheFile)
+{
+    // the cache is written along, under another name first, so a cache is
+    // never read half written
+    // --------------------------------------------------------------------
+    const string temporaryName = cacheFile + ".tmp";
+    boost::scoped_ptr<std::ofstream> cache;
+    if (!cacheFile.empty ())
+    {
+        cache.reset (new std::ofstream (temporaryName.c_str (), std::ios::binary));
+        cache->write (cacheMagic, sizeof (cacheMagic));
+        writeValue (*cache, _tolerance);
+        writeValue (*cache, (unsigned long long) 0);
+        writeValue (*cache, (unsigned long long) 0);
+    }
+
+    unsigned long long count = 0;
+    boost::scoped_ptr<FeatureCursor> cursor (source.empty () ? NULL : source.createCursor ());
+    vector<OGRGeometry*> batch;
+    vector<size_t> classes;
+    batch.reserve (batchSize);
+    bool finished = !cursor;
+    while (!finished)
+    {
+        // read serially, simplify in parallel //
+        //--------------------------------------//
+        batch.clear ();
+        classes.clear ();
+        OGRGeometry* geometry;
+        while (batch.size () < batchSize and (geometry = cursor->next ()))
+        {
+            _originalPointCount += overlay::getPointCount (geometry);
+            batch.push_back (geometry);
+            classes.push_back (cursor->getClass ());
+        }
+        finished = batch.size () < batchSize;
+
+        vector<OGRGeometry*> simplified (batch.size ());
+        vector<double> originalAreas (batch.size ());
+        vector<double> simplifiedAreas (batch.size ());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+        for (long n = 0; n < (long) batch.size (); ++n)
+        {
+            simplified[n] = simplifyGeometry (batch[n], _tolerance);
+            originalAreas[n] = overlay::getArea (batch[n]);
+            simplifiedAreas[n] = overlay::getArea (simplified[n]);
+            OGRGeometryFactory::destroyGeometry (batch[n]);
+        }
+
+        // the batch is cached as it is and kept, packed if requested //
+        //-------------------------------------------------------------//
+        for (size_t n = 0; n < batch.size (); ++n)
+        {
+            addArea (classes[n], originalAreas[n], simplifiedAreas[n]);
+            if (cache)
+                writeRecord (*cache, simplified[n], classes[n]);
+            add (simplified[n], classes[n]);
+        }
+        count += batch.size ();
+    }
+
+    if (!cache)
+        return;
+    writeValue (*cache, (unsigned long long) _originalAreas.size ());
+    for (size_t type = 0; type < _originalAreas.size (); ++type)
+    {
+        writeValue (*cache, _originalAreas[type]);
+        writeValue (*cache, _simplifiedAreas[type]);
+    }
+    cache->seekp (sizeof (cacheMagic) + sizeof (_tolerance));
+    writeValue (*cache, count);
+    writeValue (*cache, (unsigned long long) _originalPointCount);
+    cache->close ();
+    if (!cache->fail ())
+        std::rename (temporaryName.c_str (), cacheFile.c_str ());
+    else
+        std::remove (temporaryName.c_str ());
+}
+
+void SimplifiedFeatureSource::addArea (size_t type, double originalArea,
+        double simplifiedArea)
+{
+    if (type >= _originalAreas.size ())
+    {
+        _originalAreas.resize (type + 1, 0.0);
+        _simplifiedAreas.resize (type + 1, 0.0);
+    }
+    _originalAreas[type] += originalArea;
+    _simplifiedAreas[type] += simplifiedArea;
+}
+
+bool SimplifiedFeatureSource::readCache (string fileName)
+{
+    std::ifstream stream (fileName.c_str (), std::ios::binary);
+    if (!stream)
+        return false;
+
+    char magic[sizeof (cacheMagic)];
+    double tolerance;
+    unsigned long long count;
+    unsigned long long originalPointCount;
+    if (   !stream.read (magic, sizeof (magic))
+        or std::memcmp (magic, cacheMagic, sizeof (magic)) != 0
+        or !readValue (stream, tolerance) or tolerance != _tolerance
+        or !readValue (stream, count)
+        or !readValue (stream, originalPointCount))
+        return false;
+
+    // the geometries are kept as they are read, all are dropped again if
+    // the cache turns out to be broken
+    // --------------------------------------------------------------------
+    vector<unsigned char> wkb;
+    for (unsigned long long n = 0; n < count; ++n)
+    {
+        unsigned int type;
+        unsigned int size;
+        OGRGeometry* geometry = NULL;
+        if (readValue (stream, type) and readValue (stream, size))
+        {
+            wkb.resize (size);
+            if (   !stream.read ((char*) &wkb[0], size)
+                or OGRGeometryFactory::createFromWkb (&wkb[0], NULL, &geometry, size)
+                       != OGRERR_NONE)
+                geometry = NULL;
+        }
+
+        if (!geometry)
+        {
+            clear ();
+            return false;
+        }
+        add (geometry, type);
+    }
+
+    unsigned long long typeCount;
+    if (!readValue (stream, typeCount))
+    {
+        clear ();
+        return false;
+    }
+    vector<double> originalAreas (typeCount);
+    vector<double> simplifiedAreas (typeCount);
+    for (unsigned long long type = 0; type < typeCount; ++type)
+        if (   !readValue (stream, originalAreas[type])
+            or !readValue (stream, simplifiedAreas[type]))
+        {
+            clear ();
+            return false;
+        }
+
+    _originalAreas.swap (originalAreas);
+    _simplifiedAreas.swap (simplifiedAreas);
+    _originalPointCount = originalPointCount;
+    return true;
+}
+
+void SimplifiedFeatureSource::writeRecord (std::ostream& stream, const OGRGeometry* geometry,
+        size_t type)
+{
+    vector<unsigned char> wkb (geometry->WkbSize ());
+    geometry->exportToWkb (wkbNDR, &wkb[0]);
+    writeValue (stream, (unsigned int) type);
+    writeValue (stream, (unsigned int) wkb.size ());
+    stream.write ((const char*) &wkb[0], wkb.size ());
+}
+
+size_t SimplifiedFeatureSource::getOriginalPointCount () const
+{
+    return _originalPointCount;
+}
+
+double SimplifiedFeatureSource::getAreaFactor (size_t type) const
+{
+    if (type >= _originalAreas.size () or _simplifiedAreas[type] <= 0.0)
+        return 1.0;
+    return _originalAreas[type]/_simplifiedAreas[type];
+}
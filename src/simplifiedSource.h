@@ -0,0 +1,78 @@
+#ifndef SIMPLIFIEDSOURCE_H
+#define SIMPLIFIEDSOURCE_H
+
+#include <string>
+#include <ostream>
+#include <vector>
+#include <ogr_geometry.h>
+#include "featureSource.h"
+
+/**
+ * @brief Simplify a polygon or a collection of polygons
+ *
+ * The geometry is simplified keeping its own topology valid, each polygon
+ * on its own. The vertices kept are not moved, but two neighbouring
+ * polygons may keep different vertices of the boundary they share, which
+ * opens thin gaps and overlaps between them of up to the tolerance. The
+ * area changes as well, see SimplifiedFeatureSource. corine2wrfClm_compare
+ * reports the gaps and overlaps against the original polygons.
+ *
+ * @param geometry  The geometry to simplify
+ * @param tolerance The largest distance of removed vertices
+ *
+ * @return A new geometry owned by the caller
+ */
+OGRGeometry* simplifyGeometry (const OGRGeometry* geometry, double tolerance);
+
+/**
+ * @brief The polygons of another source, simplified for a grid resolution
+ *
+ * All polygons are read and simplified once and kept in memory, packed if
+ * a resolution is given, see MemoryFeatureSource. They are simplified
+ * batch by batch, so only one batch is unpacked at a time. They can be
+ * stored in a cache file, which is reused by later runs with the same
+ * tolerance. The cache holds the simplified polygons before packing.
+ *
+ * The area each class loses or gains by the simplification is corrected
+ * in the fractions, by the ratio of its original to its simplified area
+ * returned by getAreaFactor. The ratio holds for the whole source, not for
+ * every cell: a cell where a polygon grew gets even more of its class.
+ * Cells whose fractions then sum up to more than 1 are scaled back, see
+ * overlay::addFractions.
+ */
+class SimplifiedFeatureSource : public MemoryFeatureSource
+{
+  private:
+    double              _tolerance;
+    size_t              _originalPointCount;
+    std::vector<double> _originalAreas;
+    std::vector<double> _simplifiedAreas;
+
+    void addArea (size_t type, double originalArea, double simplifiedArea);
+
+    void simplify (const FeatureSource&, std::string cacheFile);
+    bool readCache (std::string);
+    static void writeRecord (std::ostream&, const OGRGeometry*, size_t type);
+
+  public:
+
+    /**
+     * @brief Constructor
+     *
+     * @param source    The original polygons
+     * @param tolerance The tolerance of the simplification in the
+     *                  coordinates of the source
+     * @param cacheFile  The cache file, read if it exists and was made
+     *                   with the same tolerance and written otherwise;
+     *                   empty for no cache
+     * @param resolution The rounding of packed polygons, 0.0 to keep them
+     *                   unpacked
+     */
+    SimplifiedFeatureSource (const FeatureSource& source, double tolerance,
+            std::string cacheFile = "", double resolution = 0.0);
+
+    size_t getOriginalPointCount () const;
+    double getAreaFactor (size_t) const;
+};
+
+#endif
@@ -0,0 +1,137 @@
+#define BOOST_TEST_MODULE SimplifiedSource
+#include <boost/test/unit_test.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <cstdio>
+#include <set>
+#include <utility>
+#include <ogr_geometry.h>
+#include "simplifiedSource.h"
+#include "overlay.h"
+
+typedef std::set<std::pair<double, double> > PointSet;
+
+/**
+ * Polygons given by the test
+ */
+class TestSource : public MemoryFeatureSource
+{
+  public:
+    TestSource () : MemoryFeatureSource (NULL) {}
+
+    void add (OGRGeometry* geometry, size_t type)
+    {
+        MemoryFeatureSource::add (geometry, type);
+        buildIndex ();
+    }
+};
+
+/**
+ * The square [0, 10] x [y0, y0 + 10] whose top or bottom edge is the
+ * teeth of a saw of height 0.2 above y = 10
+ */
+static OGRPolygon* sawSquare (double y0, bool sawOnTop)
+{
+    OGRLinearRing* ring = new OGRLinearRing;
+    if (sawOnTop)
+    {
+        ring->addPoint (0.0, y0);
+        ring->addPoint (10.0, y0);
+        for (int k = 40; k >= 0; --k)
+            ring->addPoint (0.25*k, 10.0 + (k%2 ? 0.2 : 0.0));
+    }
+    else
+    {
+        for (int k = 0; k <= 40; ++k)
+            ring->addPoint (0.25*k, 10.0 + (k%2 ? 0.2 : 0.0));
+        ring->addPoint (10.0, y0 + 10.0);
+        ring->addPoint (0.0, y0 + 10.0);
+    }
+    ring->closeRings ();
+    OGRPolygon* polygon = new OGRPolygon;
+    polygon->addRingDirectly (ring);
+    return polygon;
+}
+
+static void addPoints (const OGRGeometry* geometry, PointSet& points)
+{
+    const OGRLinearRing* ring = ((const OGRPolygon*) geometry)->getExteriorRing ();
+    for (int n = 0; n < ring->getNumPoints (); ++n)
+        points.insert (std::make_pair (ring->getX (n), ring->getY (n)));
+}
+
+BOOST_AUTO_TEST_CASE( areaFactor_test )
+{
+    // two classes sharing the saw edge, the teeth belong to class 0
+    TestSource source;
+    source.add (sawSquare (0.0, true), 0);
+    source.add (sawSquare (10.0, false), 1);
+
+    double originalAreas[2];
+    PointSet originalPoints;
+    for (size_t n = 0; n < 2; ++n)
+    {
+        OGRGeometry* geometry = source.createGeometry (n);
+        originalAreas[n] = overlay::getArea (geometry);
+        addPoints (geometry, originalPoints);
+        OGRGeometryFactory::destroyGeometry (geometry);
+    }
+
+    const std::string cacheFile = "simplifiedSource_test.cache";
+    std::remove (cacheFile.c_str ());
+    for (size_t run = 0; run < 2; ++run)
+    {
+        // the second run reads the cache
+        SimplifiedFeatureSource simplified (source, 0.5, cacheFile);
+        BOOST_CHECK (simplified.getPointCount () < simplified.getOriginalPointCount ());
+
+        // the teeth are gone, but no point is moved
+        double areas[2] = {0.0, 0.0};
+        boost::scoped_ptr<FeatureCursor> cursor (simplified.createCursor ());
+        OGRGeometry* geometry;
+        while ((geometry = cursor->next ()))
+        {
+            areas[cursor->getClass ()] += overlay::getArea (geometry);
+            PointSet points;
+            addPoints (geometry, points);
+            for (PointSet::const_iterator point = points.begin (); point != points.end (); ++point)
+                BOOST_CHECK (originalPoints.count (*point));
+            OGRGeometryFactory::destroyGeometry (geometry);
+        }
+        BOOST_CHECK (areas[0] != originalAreas[0]);
+
+        // the factors restore the area of every class
+        for (size_t n = 0; n < 2; ++n)
+            BOOST_CHECK_CLOSE (simplified.getAreaFactor (n)*areas[n], originalAreas[n], 1e-9);
+        BOOST_CHECK_EQUAL (simplified.getAreaFactor (2), 1.0);
+    }
+    std::remove (cacheFile.c_str ());
+}
+
+BOOST_AUTO_TEST_CASE( packed_test )
+{
+    TestSource source;
+    source.add (sawSquare (0.0, true), 0);
+    source.add (sawSquare (10.0, false), 1);
+
+    // the same polygons, packed on multiples of the resolution //
+    //-----------------------------------------------------------//
+    SimplifiedFeatureSource simplified (source, 0.5);
+    SimplifiedFeatureSource packed (source, 0.5, "", 0.05);
+    BOOST_CHECK (!simplified.isPacked ());
+    BOOST_CHECK (packed.isPacked ());
+    BOOST_CHECK_EQUAL (simplified.getByteCount (), 0u);
+    BOOST_CHECK (packed.getByteCount () > 0);
+    BOOST_REQUIRE_EQUAL (packed.size (), simplified.size ());
+    BOOST_CHECK_EQUAL (packed.getPointCount (), simplified.getPointCount ());
+
+    for (size_t n = 0; n < packed.size (); ++n)
+    {
+        BOOST_CHECK_EQUAL (packed.getClass (n), simplified.getClass (n));
+        BOOST_CHECK_EQUAL (packed.getAreaFactor (n), simplified.getAreaFactor (n));
+        OGRGeometry* geometry = packed.createGeometry (n);
+        OGRGeometry* original = simplified.createGeometry (n);
+        BOOST_CHECK_CLOSE (overlay::getArea (geometry), overlay::getArea (original), 1e-9);
+        OGRGeometryFactory::destroyGeometry (original);
+        OGRGeometryFactory::destroyGeometry (geometry);
+    }
+}
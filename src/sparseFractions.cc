@@ -0,0 +1,259 @@
+#include "sparseFractions.h"
+
+const size_t Arena::defaultChunkSize;
+const size_t SparseFractions::inlineCapacity;
+const size_t SparseFractions::maxTypeCount;
+
+Arena::Arena (size_t chunkSize)
+    : _chunkSize (chunkSize), _used (chunkSize), _allocated (0)
+{}
+
+Arena::~Arena ()
+{
+    for (size_t n = 0; n < _chunks.size (); ++n)
+        delete[] _chunks[n];
+}
+
+void* Arena::allocate (size_t bytes)
+{
+    bytes = (bytes + sizeof (double) - 1)/sizeof (double)*sizeof (double);
+
+    if (bytes > _chunkSize)
+    {
+        // too large for a chunk, gets a chunk of its own //
+        //-------------------------------------------------//
+        char* chunk = new char[bytes];
+        _chunks.insert (_chunks.begin (), chunk);
+        _allocated += bytes;
+        return chunk;
+    }
+
+    if (_used + bytes > _chunkSize)
+    {
+        _chunks.push_back (new char[_chunkSize]);
+        _used = 0;
+    }
+
+    void* result = _chunks.back () + _used;
+    _used += bytes;
+    _allocated += bytes;
+    return result;
+}
+
+size_t Arena::allocated () const
+{
+    return _allocated;
+}
+
+ArenaPool::ArenaPool ()
+{
+    pthread_key_create (&_localArena, NULL);
+    pthread_mutex_init (&_lock, NULL);
+}
+
+ArenaPool::~ArenaPool ()
+{
+    pthread_key_delete (_localArena);
+    pthread_mutex_destroy (&_lock);
+    for (size_t n = 0; n < _arenas.size (); ++n)
+        delete _arenas[n];
+}
+
+Arena& ArenaPool::local ()
+{
+    Arena* arena = (Arena*) pthread_getspecific (_localArena);
+    if (!arena)
+    {
+        arena = new Arena;
+        pthread_mutex_lock (&_lock);
+        _arenas.push_back (arena);
+        pthread_mutex_unlock (&_lock);
+        pthread_setspecific (_localArena, arena);
+    }
+    return *arena;
+}
+
+size_t ArenaPool::allocated () const
+{
+    pthread_mutex_lock (&_lock);
+    size_t result = 0;
+    for (size_t n = 0; n < _arenas.size (); ++n)
+        result += _arenas[n]->allocated ();
+    pthread_mutex_unlock (&_lock);
+    return result;
+}
+
+SparseFractions::SparseFractions ()
+    : _count (0), _capacity (inlineCapacity), _overflow (NULL)
+{}
+
+void SparseFractions::add (size_t type, double value, Arena& arena)
+{
+    if (type >= maxTypeCount) throw FractionOutOfRange ();
+
+    for (size_t n = 0; n < _count; ++n)
+        if (getType (n) == type)
+        {
+            if (_overflow) _overflow[n].value += value;
+            else           _values[n] += value;
+            return;
+        }
+
+    if (_count == _capacity)
+    {
+        // move all entries to a larger block //
+        //------------------------------------//
+        size_t capacity = 2*_capacity;
+        if (capacity > maxTypeCount) capacity = maxTypeCount;
+        Entry* overflow = (Entry*) arena.allocate (capacity*sizeof (Entry));
+        for (size_t n = 0; n < _count; ++n)
+        {
+            overflow[n].type = getType (n);
+            overflow[n].value = getValue (n);
+        }
+        _overflow = overflow;
+        _capacity = capacity;
+    }
+
+    if (_overflow)
+    {
+        _overflow[_count].type = type;
+        _overflow[_count].value = value;
+    }
+    else
+    {
+        _types[_count] = type;
+        _values[_count] = value;
+    }
+    ++_count;
+}
+
+void SparseFractions::scale (size_t type, double factor)
+{
+    for (size_t n = 0; n < _count; ++n)
+        if (getType (n) == type)
+        {
+            if (_overflow) _overflow[n].value *= factor;
+            else           _values[n] *= factor;
+            return;
+        }
+}
+
+bool SparseFractions::limit (double maximum)
+{
+    const double total = sum ();
+    if (total <= maximum)
+        return false;
+
+    const double factor = maximum/total;
+    for (size_t n = 0; n < _count; ++n)
+    {
+        if (_overflow) _overflow[n].value *= factor;
+        else           _values[n] *= factor;
+    }
+    return true;
+}
+
+double SparseFractions::operator[] (size_t type) const
+{
+    for (size_t n = 0; n < _count; ++n)
+        if (getType (n) == type)
+            return getValue (n);
+    return 0.0;
+}
+
+double SparseFractions::sum () const
+{
+    double total = 0.0;
+    for (size_t n = 0; n < _count; ++n)
+        total += getValue (n);
+    return total;
+}
+
+size_t SparseFractions::size () const
+{
+    return _count;
+}
+
+size_t SparseFractions::getType (size_t n) const
+{
+    return _overflow ? _overflow[n].type : _types[n];
+}
+
+double SparseFractions::getValue (size_t n) const
+{
+    return _overflow ? _overflow[n].value : _values[n];
+}
+
+void SparseFractions::addTo (Fractions& fractions) const
+{
+    for (size_t n = 0; n < _count; ++n)
+        fractions.add (getType (n), getValue (n));
+}
+
+SparseFractionGrid::SparseFractionGrid (size_t iSize, size_t jSize, size_t typeCount,
+        size_t iOffset, size_t jOffset)
+    : _cells (boost::extents[iSize][jSize]),
+      _typeCount (typeCount),
+      _iOffset (iOffset),
+      _jOffset (jOffset)
+{
+    if (typeCount > SparseFractions::maxTypeCount)
+        throw FractionOutOfRange ();
+}
+
+size_t SparseFractionGrid::iSize () const
+{
+    return _cells.shape ()[0];
+}
+
+size_t SparseFractionGrid::jSize () const
+{
+    return _cells.shape ()[1];
+}
+
+size_t SparseFractionGrid::iOffset () const
+{
+    return _iOffset;
+}
+
+size_t SparseFractionGrid::jOffset () const
+{
+    return _jOffset;
+}
+
+size_t SparseFractionGrid::typeCount () const
+{
+    return _typeCount;
+}
+
+void SparseFractionGrid::add (size_t i, size_t j, size_t type, double value)
+{
+    if (type >= _typeCount) throw FractionOutOfRange ();
+    _cells[i - _iOffset][j - _jOffset].add (type, value, _arenas.local ());
+}
+
+void SparseFractionGrid::scale (size_t i, size_t j, size_t type, double factor)
+{
+    _cells[i - _iOffset][j - _jOffset].scale (type, factor);
+}
+
+bool SparseFractionGrid::limit (size_t i, size_t j, double maximum)
+{
+    return _cells[i - _iOffset][j - _jOffset].limit (maximum);
+}
+
+const SparseFractions& SparseFractionGrid::operator() (size_t i, size_t j) const
+{
+    return _cells[i - _iOffset][j - _jOffset];
+}
+
+size_t SparseFractionGrid::memoryUsage () const
+{
+    return _cells.num_elements ()*sizeof (SparseFractions) + _arenas.allocated ();
+}
+
+size_t SparseFractionGrid::expectedCellSize ()
+{
+    return sizeof (SparseFractions) + SparseFractions::inlineCapacity*sizeof (double);
+}
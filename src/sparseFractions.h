@@ -0,0 +1,216 @@
+#ifndef SPARSEFRACTIONS_H
+#define SPARSEFRACTIONS_H
+
+#include <vector>
+#include <pthread.h>
+#include <boost/multi_array.hpp>
+#include "fractions.h"
+
+/**
+ * @brief Memory for the overflow lists of SparseFractions
+ *
+ * Blocks are cut from large chunks and are only freed all at once, when the
+ * arena is destroyed. An arena must be used by one thread at a time.
+ */
+class Arena
+{
+    private:
+        std::vector<char*> _chunks;
+        size_t             _chunkSize;
+        size_t             _used;
+        size_t             _allocated;
+
+        Arena (const Arena&);
+        Arena& operator= (const Arena&);
+
+    public:
+        static const size_t defaultChunkSize = 1 << 20;
+
+        Arena (size_t chunkSize = defaultChunkSize);
+        ~Arena ();
+
+        /**
+         * @brief Get a block of memory aligned for doubles
+         *
+         * @param bytes Size of the block
+         */
+        void* allocate (size_t bytes);
+
+        /**
+         * @brief Total size of all blocks handed out so far
+         */
+        size_t allocated () const;
+};
+
+/**
+ * @brief One arena for every thread that uses the pool
+ *
+ * A thread gets its arena on first use and keeps it as thread-specific
+ * data of the pool, so any number of threads may use the pool, OpenMP
+ * or not and nested or not. The arenas live as long as the pool.
+ */
+class ArenaPool
+{
+    private:
+        std::vector<Arena*>     _arenas;
+        pthread_key_t           _localArena;
+        mutable pthread_mutex_t _lock;
+
+        ArenaPool (const ArenaPool&);
+        ArenaPool& operator= (const ArenaPool&);
+
+    public:
+        ArenaPool ();
+        ~ArenaPool ();
+
+        /**
+         * @brief The arena of the calling thread
+         */
+        Arena& local ();
+
+        size_t allocated () const;
+};
+
+/**
+ * @brief The non-zero fractions of one cell
+ *
+ * The first inlineCapacity (type, fraction) pairs are stored in the object
+ * itself, which fills one cache line. Cells with more types keep all pairs
+ * in a block taken from an Arena.
+ */
+class SparseFractions
+{
+    public:
+        static const size_t inlineCapacity = 6;
+        static const size_t maxTypeCount   = 255;
+
+    private:
+        struct Entry
+        {
+            double        value;
+            unsigned char type;
+        };
+
+        unsigned char _count;
+        unsigned char _capacity;
+        unsigned char _types[inlineCapacity];
+        double        _values[inlineCapacity];
+        Entry*        _overflow;
+
+    public:
+        SparseFractions ();
+
+        /**
+         * @brief Add to the fraction of one type
+         *
+         * @param type  The type, must be below maxTypeCount
+         * @param value The value to add
+         * @param arena Memory used if the cell grows beyond inlineCapacity
+         */
+        void add (size_t type, double value, Arena& arena);
+
+        /**
+         * @brief Multiply the fraction of one type, if it is stored
+         */
+        void scale (size_t type, double factor);
+
+        /**
+         * @brief Scale all fractions down if their sum exceeds a maximum,
+         *        so that they sum up to the maximum
+         *
+         * @return true if the fractions were scaled
+         */
+        bool limit (double maximum);
+
+        /**
+         * @brief The fraction of one type, 0.0 for types not stored
+         */
+        double operator[] (size_t type) const;
+
+        /**
+         * @brief The sum of all stored fractions
+         */
+        double sum () const;
+
+        /**
+         * @brief Number of stored types
+         */
+        size_t size () const;
+        size_t getType (size_t n) const;
+        double getValue (size_t n) const;
+
+        /**
+         * @brief Add all stored fractions to dense fractions
+         */
+        void addTo (Fractions&) const;
+};
+
+/**
+ * @brief A grid of SparseFractions together with the memory they use
+ *
+ * The grid may cover only a window of a larger grid, it is indexed with the
+ * cell indices of the larger grid.
+ */
+class SparseFractionGrid
+{
+    private:
+        boost::multi_array<SparseFractions, 2> _cells;
+        size_t                                 _typeCount;
+        size_t                                 _iOffset;
+        size_t                                 _jOffset;
+        ArenaPool                              _arenas;
+
+    public:
+        /**
+         * @brief Constructor
+         *
+         * @param iSize     Number of cells along i
+         * @param jSize     Number of cells along j
+         * @param typeCount Number of types
+         * @param iOffset   Index of the first cell along i
+         * @param jOffset   Index of the first cell along j
+         */
+        SparseFractionGrid (size_t iSize, size_t jSize, size_t typeCount,
+                size_t iOffset = 0, size_t jOffset = 0);
+
+        size_t iSize () const;
+        size_t jSize () const;
+        size_t iOffset () const;
+        size_t jOffset () const;
+        size_t typeCount () const;
+
+        /**
+         * @brief Add to one fraction of one cell
+         *
+         * Different threads may add to different cells at the same time.
+         */
+        void add (size_t i, size_t j, size_t type, double value);
+
+        /**
+         * @brief Multiply one fraction of one cell, see SparseFractions::scale
+         */
+        void scale (size_t i, size_t j, size_t type, double factor);
+
+        /**
+         * @brief Limit the sum of the fractions of one cell, see
+         *        SparseFractions::limit
+         */
+        bool limit (size_t i, size_t j, double maximum);
+
+        const SparseFractions& operator() (size_t i, size_t j) const;
+
+        /**
+         * @brief Bytes used by the cells and their overflow blocks
+         */
+        size_t memoryUsage () const;
+
+        /**
+         * @brief Bytes a cell is expected to use, allowing for a share of
+         *        cells with overflow blocks
+         *
+         * Used to size windows for a memory budget.
+         */
+        static size_t expectedCellSize ();
+};
+
+#endif
@@ -0,0 +1,145 @@
+#define BOOST_TEST_MODULE SparseFractions
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include "sparseFractions.h"
+
+namespace
+{
+
+    const size_t threadCount = 12;
+    const size_t typeCount = 44;
+
+    struct ThreadCells
+    {
+        SparseFractionGrid* grid;
+        size_t              i;
+    };
+
+    /**
+     * Fill a row of cells with every type, so all of them overflow
+     */
+    void* fillRow (void* data)
+    {
+        ThreadCells* cells = (ThreadCells*) data;
+        for (size_t j = 0; j < cells->grid->jSize (); ++j)
+            for (size_t type = 0; type < typeCount; ++type)
+                cells->grid->add (cells->i, j, type, 1.0/typeCount);
+        return NULL;
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE( sparseFractions_test )
+{
+    double tolerance = 1.0e-10;
+
+    // empty cells return 0.0
+    Arena arena (64);
+    SparseFractions empty;
+    BOOST_CHECK_EQUAL (empty.size (), 0u);
+    BOOST_CHECK_EQUAL (empty[3], 0.0);
+
+    // adding to the same type does not create a new entry
+    SparseFractions f0;
+    f0.add (3, 0.25, arena);
+    f0.add (3, 0.25, arena);
+    BOOST_CHECK_EQUAL (f0.size (), 1u);
+    BOOST_CHECK_CLOSE (f0[3], 0.5, tolerance);
+    BOOST_CHECK_EQUAL (arena.allocated (), 0u);
+    BOOST_CHECK_THROW (f0.add (SparseFractions::maxTypeCount, 0.1, arena), FractionOutOfRange);
+
+    // a cell with every type spills into the arena and keeps all values
+    SparseFractions f1;
+    Fractions dense (typeCount);
+    for (size_t n = 0; n < 3*typeCount; ++n)
+    {
+        size_t type = (7*n)%typeCount;
+        double value = 1.0/(3*typeCount);
+        f1.add (type, value, arena);
+        dense.add (type, value);
+    }
+    BOOST_CHECK_EQUAL (f1.size (), typeCount);
+    BOOST_CHECK (arena.allocated () > 0);
+    for (size_t type = 0; type < typeCount; ++type)
+        BOOST_CHECK_CLOSE (f1[type], dense[type], tolerance);
+
+    Fractions converted (typeCount);
+    f1.addTo (converted);
+    for (size_t type = 0; type < typeCount; ++type)
+        BOOST_CHECK_CLOSE (converted[type], dense[type], tolerance);
+
+    // a grid checks its type count and keeps the cells apart
+    SparseFractionGrid grid (3, 2, typeCount);
+    BOOST_CHECK_EQUAL (grid.iSize (), 3u);
+    BOOST_CHECK_EQUAL (grid.jSize (), 2u);
+    BOOST_CHECK_THROW (grid.add (0, 0, typeCount, 0.1), FractionOutOfRange);
+    BOOST_CHECK_THROW (SparseFractionGrid (1, 1, SparseFractions::maxTypeCount + 1),
+            FractionOutOfRange);
+
+    srand (42);
+    for (size_t n = 0; n < 1000; ++n)
+        grid.add (n%3, (n/3)%2, rand ()%typeCount, 1.0e-3);
+    double sum = 0.0;
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t j = 0; j < 2; ++j)
+        {
+            const SparseFractions& cell = grid (i, j);
+            for (size_t n = 0; n < cell.size (); ++n)
+                sum += cell.getValue (n);
+        }
+    BOOST_CHECK_CLOSE (sum, 1.0, tolerance);
+    BOOST_CHECK (grid.memoryUsage () >= 6*sizeof (SparseFractions));
+
+    // a window of a larger grid is indexed like the larger grid
+    SparseFractionGrid window (2, 3, typeCount, 10, 20);
+    window.add (11, 22, 5, 0.5);
+    BOOST_CHECK_EQUAL (window.iOffset (), 10u);
+    BOOST_CHECK_EQUAL (window.jOffset (), 20u);
+    BOOST_CHECK_CLOSE (window (11, 22)[5], 0.5, tolerance);
+    BOOST_CHECK_EQUAL (window (10, 20).size (), 0u);
+
+    // scaling changes only stored types, inline and in the arena
+    window.scale (11, 22, 5, 0.5);
+    window.scale (11, 22, 6, 0.5);
+    BOOST_CHECK_CLOSE (window (11, 22)[5], 0.25, tolerance);
+    BOOST_CHECK_EQUAL (window (11, 22).size (), 1u);
+    // limiting scales all fractions of a cell by the same factor
+    BOOST_CHECK (!window.limit (11, 22, 1.0));
+    window.add (11, 22, 6, 1.0);
+    BOOST_CHECK (window.limit (11, 22, 1.0));
+    BOOST_CHECK_CLOSE (window (11, 22).sum (), 1.0, tolerance);
+    BOOST_CHECK_CLOSE (window (11, 22)[5], 0.2, tolerance);
+    BOOST_CHECK_CLOSE (window (11, 22)[6], 0.8, tolerance);
+    f1.scale (7, 2.0);
+    BOOST_CHECK_CLOSE (f1[7], 2.0*dense[7], tolerance);
+    BOOST_CHECK_CLOSE (f1[8], dense[8], tolerance);
+    const double total = f1.sum ();
+    BOOST_CHECK (f1.limit (0.5*total));
+    BOOST_CHECK_CLOSE (f1.sum (), 0.5*total, tolerance);
+    BOOST_CHECK_CLOSE (f1[8], 0.5*dense[8], tolerance);
+}
+
+BOOST_AUTO_TEST_CASE( threads_test )
+{
+    // threads not known when the grid was made get arenas of their own
+    SparseFractionGrid grid (threadCount, 50, typeCount);
+    pthread_t threads[threadCount];
+    ThreadCells cells[threadCount];
+    for (size_t n = 0; n < threadCount; ++n)
+    {
+        cells[n].grid = &grid;
+        cells[n].i = n;
+        pthread_create (&threads[n], NULL, fillRow, &cells[n]);
+    }
+    for (size_t n = 0; n < threadCount; ++n)
+        pthread_join (threads[n], NULL);
+
+    for (size_t i = 0; i < threadCount; ++i)
+        for (size_t j = 0; j < grid.jSize (); ++j)
+        {
+            BOOST_REQUIRE_EQUAL (grid (i, j).size (), typeCount);
+            for (size_t type = 0; type < typeCount; ++type)
+                BOOST_CHECK_CLOSE (grid (i, j)[type], 1.0/typeCount, 1.0e-10);
+        }
+    BOOST_CHECK (grid.memoryUsage () > grid.iSize ()*grid.jSize ()*sizeof (SparseFractions));
+}
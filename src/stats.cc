@@ -0,0 +1,247 @@
+#include <vector>
+#include <iomanip>
+#include <sys/time.h>
+#include "stats.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace stats;
+using std::endl;
+using std::setw;
+
+namespace
+{
+
+    const char* counterNames[counterCount] =
+    {
+        "featuresRead",
+        "cellsQueried",
+        "cellsWithCandidates",
+        "candidates",
+        "intersections",
+        "verticesReprojected",
+        "lockAcquisitions",
+        "fallbackCells",
+        "changedCells",
+        "limitedCells"
+    };
+
+    const char* counterLabels[counterCount] =
+    {
+        "features read",
+        "cells queried",
+        "cells with candidates",
+        "candidate polygons",
+        "intersections computed",
+        "vertices reprojected",
+        "WRF file lock acquisitions",
+        "cells using original land use",
+        "cells recomputed for a new epoch",
+        "cells limited to a sum of 1"
+    };
+
+    const char* timerNames[timerCount] =
+    {
+        "overlayPhase",
+        "outputPhase",
+        "fractionFilePhase",
+        "read",
+        "reproject",
+        "clip",
+        "queueFull",
+        "queueEmpty",
+        "lockWait",
+        "map",
+        "write",
+        "writeQueueFull"
+    };
+
+    const char* timerLabels[timerCount] =
+    {
+        "overlay phase (wall clock)",
+        "output phase (wall clock)",
+        "fraction file phase (wall clock)",
+        "reading features",
+        "reprojecting features",
+        "clipping with cells",
+        "readers waiting on full queue",
+        "workers waiting on empty queue",
+        "waiting on WRF file lock",
+        "mapping to CLM types",
+        "writing to WRF file",
+        "waiting on full write queue"
+    };
+
+    /**
+     * @brief The counters of one thread, padded to keep other slots off its
+     *        cache lines
+     */
+    struct Slot
+    {
+        size_t counters[counterCount];
+        double timers[timerCount];
+        char   padding[64];
+    };
+
+    /**
+     * @brief All slots ever handed out
+     */
+    class SlotRegistry
+    {
+        private:
+            std::vector<Slot*> _slots;
+#ifdef _OPENMP
+            omp_lock_t         _lock;
+#endif
+        public:
+            SlotRegistry ()
+            {
+#ifdef _OPENMP
+                omp_init_lock (&_lock);
+#endif
+            }
+
+            ~SlotRegistry ()
+            {
+                for (size_t n = 0; n < _slots.size (); ++n)
+                    delete _slots[n];
+#ifdef _OPENMP
+                omp_destroy_lock (&_lock);
+#endif
+            }
+
+            Slot* create ()
+            {
+                Slot* slot = new Slot ();
+#ifdef _OPENMP
+                omp_set_lock (&_lock);
+#endif
+                _slots.push_back (slot);
+#ifdef _OPENMP
+                omp_unset_lock (&_lock);
+#endif
+                return slot;
+            }
+
+            const std::vector<Slot*>& slots () const
+            {
+                return _slots;
+            }
+    };
+
+    SlotRegistry registry;
+
+    // the slot of the calling thread, allocated on first use
+    Slot* threadSlot = NULL;
+#ifdef _OPENMP
+#pragma omp threadprivate(threadSlot)
+#endif
+
+    inline Slot& getSlot ()
+    {
+        if (!threadSlot)
+            threadSlot = registry.create ();
+        return *threadSlot;
+    }
+
+}
+
+double stats::now ()
+{
+#ifdef _OPENMP
+    return omp_get_wtime ();
+#else
+    timeval time;
+    gettimeofday (&time, NULL);
+    return time.tv_sec + 1.0e-6*time.tv_usec;
+#endif
+}
+
+void stats::count (Counter counter, size_t value)
+{
+    getSlot ().counters[counter] += value;
+}
+
+void stats::add (Timer timer, double seconds)
+{
+    getSlot ().timers[timer] += seconds;
+}
+
+ScopedTimer::ScopedTimer (Timer timer)
+    : _timer (timer), _start (now ())
+{}
+
+ScopedTimer::~ScopedTimer ()
+{
+    add (_timer, now () - _start);
+}
+
+Totals stats::getTotals ()
+{
+    Totals totals;
+    totals.threadCount = registry.slots ().size ();
+    for (size_t counter = 0; counter < counterCount; ++counter)
+        totals.counters[counter] = 0;
+    for (size_t timer = 0; timer < timerCount; ++timer)
+        totals.timers[timer] = 0.0;
+
+    for (size_t n = 0; n < registry.slots ().size (); ++n)
+    {
+        const Slot& slot = *registry.slots ()[n];
+        for (size_t counter = 0; counter < counterCount; ++counter)
+            totals.counters[counter] += slot.counters[counter];
+        for (size_t timer = 0; timer < timerCount; ++timer)
+            totals.timers[timer] += slot.timers[timer];
+    }
+    return totals;
+}
+
+void stats::writeSummary (std::ostream& out)
+{
+    Totals totals = getTotals ();
+    std::ios::fmtflags flags = out.flags ();
+    std::streamsize precision = out.precision ();
+
+    out << "statistics of " << totals.threadCount << " threads" << endl;
+    for (size_t counter = 0; counter < counterCount; ++counter)
+        out << "  " << std::left << setw (36) << counterLabels[counter]
+            << std::right << setw (16) << totals.counters[counter] << endl;
+    if (totals.counters[cellsWithCandidates] > 0)
+        out << "  " << std::left << setw (36) << "candidates per cell"
+            << std::right << setw (16) << std::fixed << std::setprecision (2)
+            << (double) totals.counters[candidates]/totals.counters[cellsWithCandidates]
+            << endl;
+
+    out << "seconds per stage, summed over threads" << endl;
+    for (size_t timer = 0; timer < timerCount; ++timer)
+        out << "  " << std::left << setw (36) << timerLabels[timer]
+            << std::right << setw (16) << std::fixed << std::setprecision (3)
+            << totals.timers[timer] << endl;
+
+    out.flags (flags);
+    out.precision (precision);
+}
+
+void stats::writeJson (std::ostream& out)
+{
+    Totals totals = getTotals ();
+    std::streamsize precision = out.precision ();
+
+    out << "{" << endl
+        << "  \"threads\": " << totals.threadCount << "," << endl
+        << "  \"counters\": {" << endl;
+    for (size_t counter = 0; counter < counterCount; ++counter)
+        out << "    \"" << counterNames[counter] << "\": " << totals.counters[counter]
+            << (counter + 1 < counterCount ? "," : "") << endl;
+    out << "  }," << endl
+        << "  \"seconds\": {" << endl;
+    out << std::setprecision (6);
+    for (size_t timer = 0; timer < timerCount; ++timer)
+        out << "    \"" << timerNames[timer] << "\": " << totals.timers[timer]
+            << (timer + 1 < timerCount ? "," : "") << endl;
+    out << "  }" << endl
+        << "}" << endl;
+    out.precision (precision);
+}
@@ -0,0 +1,96 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <ostream>
+#include <cstddef>
+
+/**
+ * @brief Counters and timers of the processing stages
+ *
+ * Every thread counts into its own slot, so counting needs no
+ * synchronisation. The slots are summed up when the totals are requested,
+ * which must not happen while other threads are still counting.
+ */
+namespace stats
+{
+
+    enum Counter
+    {
+        featuresRead = 0,
+        cellsQueried,
+        cellsWithCandidates,
+        candidates,
+        intersections,
+        verticesReprojected,
+        lockAcquisitions,
+        fallbackCells,
+        changedCells,
+        limitedCells,
+        counterCount
+    };
+
+    /**
+     * @brief Time spent in a stage, summed over all threads
+     *
+     * The phases are wall clock times measured by the master thread.
+     */
+    enum Timer
+    {
+        overlayPhase = 0,
+        outputPhase,
+        fractionFilePhase,
+        readTime,
+        reprojectTime,
+        clipTime,
+        queueFullTime,
+        queueEmptyTime,
+        lockWaitTime,
+        mapTime,
+        writeTime,
+        writeQueueFullTime,
+        timerCount
+    };
+
+    struct Totals
+    {
+        size_t threadCount;
+        size_t counters[counterCount];
+        double timers[timerCount];
+    };
+
+    /**
+     * @brief Wall clock time in seconds
+     */
+    double now ();
+
+    void count (Counter, size_t value = 1);
+    void add (Timer, double seconds);
+
+    /**
+     * @brief Adds the time of its lifetime to a timer
+     */
+    class ScopedTimer
+    {
+        private:
+            Timer  _timer;
+            double _start;
+        public:
+            ScopedTimer (Timer);
+            ~ScopedTimer ();
+    };
+
+    Totals getTotals ();
+
+    /**
+     * @brief Write the totals as a human readable table
+     */
+    void writeSummary (std::ostream&);
+
+    /**
+     * @brief Write the totals as a JSON object
+     */
+    void writeJson (std::ostream&);
+
+}
+
+#endif
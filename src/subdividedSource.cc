@@ -0,0 +1,189 @@
+#include <cmath>
+#include <boost/scoped_ptr.hpp>
+#include "subdividedSource.h"
+#include "overlay.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using std::vector;
+
+const size_t SubdividedFeatureSource::maxDepth;
+
+namespace
+{
+
+    /**
+     * @brief Number of polygons read before they are split in parallel
+     */
+    const size_t batchSize = 4096;
+
+    void setRectangle (OGRPolygon& polygon, double minX, double minY,
+            double maxX, double maxY)
+    {
+        OGRLinearRing* ring = new OGRLinearRing;
+        ring->setNumPoints (5);
+        ring->setPoint (0, minX, minY);
+        ring->setPoint (1, minX, maxY);
+        ring->setPoint (2, maxX, maxY);
+        ring->setPoint (3, maxX, minY);
+        ring->setPoint (4, minX, minY);
+        polygon.empty ();
+        polygon.addRingDirectly (ring);
+    }
+
+    /**
+     * @brief Only the polygons of an intersection, lines and points where
+     *        the polygon touches the split lines are dropped
+     *
+     * @return The polygons, NULL if there are none; the geometry is owned
+     *         by the function
+     */
+    OGRGeometry* getPolygons (OGRGeometry* geometry)
+    {
+        switch (wkbFlatten (geometry->getGeometryType ()))
+        {
+            case wkbPolygon:
+            case wkbMultiPolygon:
+                if (!geometry->IsEmpty ())
+                    return geometry;
+                break;
+            case wkbGeometryCollection:
+            {
+                OGRGeometryCollection* collection = (OGRGeometryCollection*) geometry;
+                OGRMultiPolygon* polygons = new OGRMultiPolygon;
+                for (int n = 0; n < collection->getNumGeometries (); ++n)
+                {
+                    OGRGeometry* part = collection->getGeometryRef (n);
+                    if (wkbFlatten (part->getGeometryType ()) == wkbPolygon)
+                        polygons->addGeometry (part);
+                    else if (wkbFlatten (part->getGeometryType ()) == wkbMultiPolygon)
+                    {
+                        OGRMultiPolygon* multiPolygon = (OGRMultiPolygon*) part;
+                        for (int k = 0; k < multiPolygon->getNumGeometries (); ++k)
+                            polygons->addGeometry (multiPolygon->getGeometryRef (k));
+                    }
+                }
+                OGRGeometryFactory::destroyGeometry (geometry);
+                if (polygons->getNumGeometries () > 0)
+                    return polygons;
+                OGRGeometryFactory::destroyGeometry (polygons);
+                return NULL;
+            }
+            default:
+                break;
+        }
+        OGRGeometryFactory::destroyGeometry (geometry);
+        return NULL;
+    }
+
+    double getSplit (double min, double max, double alignment)
+    {
+        double middle = 0.5*(min + max);
+        if (alignment > 0.0)
+        {
+            double aligned = floor (middle/alignment + 0.5)*alignment;
+            if (aligned > min and aligned < max)
+                return aligned;
+        }
+        return middle;
+    }
+
+    void subdivide (OGRGeometry* geometry, size_t maxPointCount, double alignment,
+            vector<OGRGeometry*>& pieces, size_t depth)
+    {
+        if (   overlay::getPointCount (geometry) <= maxPointCount
+            or depth >= SubdividedFeatureSource::maxDepth)
+        {
+            pieces.push_back (geometry);
+            return;
+        }
+
+        OGREnvelope envelope;
+        geometry->getEnvelope (&envelope);
+        double x[3] = {envelope.MinX, getSplit (envelope.MinX, envelope.MaxX, alignment),
+                       envelope.MaxX};
+        double y[3] = {envelope.MinY, getSplit (envelope.MinY, envelope.MaxY, alignment),
+                       envelope.MaxY};
+
+        OGRPolygon quarter;
+        for (size_t a = 0; a < 2; ++a)
+            for (size_t b = 0; b < 2; ++b)
+            {
+                setRectangle (quarter, x[a], y[b], x[a + 1], y[b + 1]);
+                if (!geometry->Intersects (&quarter))
+                    continue;
+
+                OGRGeometry* piece = geometry->Intersection (&quarter);
+                if (piece and (piece = getPolygons (piece)))
+                    subdivide (piece, maxPointCount, alignment, pieces, depth + 1);
+            }
+        OGRGeometryFactory::destroyGeometry (geometry);
+    }
+
+}
+
+void subdivide (OGRGeometry* geometry, size_t maxPointCount, double alignment,
+        vector<OGRGeometry*>& pieces)
+{
+    subdivide (geometry, maxPointCount, alignment, pieces, 0);
+}
+
+SubdividedFeatureSource::SubdividedFeatureSource (const FeatureSource& source,
+        size_t maxPointCount, double alignment, double resolution)
+    : MemoryFeatureSource (source.getCoordinateSystem (), resolution),
+      _splitCount (0)
+{
+    if (source.empty ())
+        return;
+
+    boost::scoped_ptr<FeatureCursor> cursor (source.createCursor ());
+    vector<OGRGeometry*> batch;
+    vector<size_t> classes;
+    batch.reserve (batchSize);
+    bool finished = false;
+    while (!finished)
+    {
+        // read serially, split in parallel, keep the order of the source //
+        //-----------------------------------------------------------------//
+        batch.clear ();
+        classes.clear ();
+        OGRGeometry* geometry;
+        while (batch.size () < batchSize and (geometry = cursor->next ()))
+        {
+            batch.push_back (geometry);
+            classes.push_back (cursor->getClass ());
+        }
+        finished = batch.size () < batchSize;
+
+        vector<vector<OGRGeometry*> > pieces (batch.size ());
+        size_t splitCount = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:splitCount)
+#endif
+        for (long n = 0; n < (long) batch.size (); ++n)
+        {
+            if (overlay::getPointCount (batch[n]) > maxPointCount)
+            {
+                subdivide (batch[n], maxPointCount, alignment, pieces[n]);
+                splitCount++;
+            }
+            else
+                pieces[n].push_back (batch[n]);
+        }
+        _splitCount += splitCount;
+
+        for (size_t n = 0; n < pieces.size (); ++n)
+            for (size_t k = 0; k < pieces[n].size (); ++k)
+                add (pieces[n][k], classes[n]);
+    }
+
+    copyAreaFactors (source);
+    buildIndex ();
+}
+
+size_t SubdividedFeatureSource::getSplitCount () const
+{
+    return _splitCount;
+}
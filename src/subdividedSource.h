@@ -0,0 +1,62 @@
+#ifndef SUBDIVIDEDSOURCE_H
+#define SUBDIVIDEDSOURCE_H
+
+#include <vector>
+#include <ogr_geometry.h>
+#include "featureSource.h"
+
+/**
+ * @brief Split a polygon into pieces with few points
+ *
+ * The envelope of the polygon is split into quarters recursively until every
+ * piece has at most maxPointCount points. The pieces do not overlap, so the
+ * areas clipped from them add up to the area clipped from the polygon.
+ *
+ * @param geometry      A polygon or a collection of polygons, owned by the
+ *                      function
+ * @param maxPointCount The largest number of points of a piece
+ * @param alignment     The split lines are multiples of this, so pieces of
+ *                      neighbouring polygons line up; 0.0 to split in the
+ *                      middle
+ * @param pieces        The pieces are appended, owned by the caller
+ */
+void subdivide (OGRGeometry* geometry, size_t maxPointCount, double alignment,
+        std::vector<OGRGeometry*>& pieces);
+
+/**
+ * @brief The polygons of another source, large polygons split into pieces
+ *
+ * Huge polygons like the sea or large forests touch many cells, so a query
+ * would return and clip the whole polygon for each of them. Their pieces
+ * are indexed instead, a cell only gets the pieces near it. The pieces may
+ * be packed batch by batch, see MemoryFeatureSource.
+ */
+class SubdividedFeatureSource : public MemoryFeatureSource
+{
+  private:
+    size_t _splitCount;
+
+  public:
+
+    /**
+     * @brief Maximum depth of the recursive split
+     */
+    static const size_t maxDepth = 16;
+
+    /**
+     * @param source        The original polygons
+     * @param maxPointCount Polygons with more points are split
+     * @param alignment     See subdivide
+     * @param resolution    The rounding of packed pieces, 0.0 to keep them
+     *                      unpacked, see MemoryFeatureSource
+     */
+    SubdividedFeatureSource (const FeatureSource& source, size_t maxPointCount,
+            double alignment, double resolution = 0.0);
+
+    /**
+     * @brief The number of polygons split into pieces
+     */
+    size_t getSplitCount () const;
+};
+
+#endif
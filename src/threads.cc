@@ -0,0 +1,32 @@
+#include "threads.h"
+
+FirstException::FirstException ()
+    : _failed (false)
+{
+    pthread_mutex_init (&_lock, NULL);
+}
+
+FirstException::~FirstException ()
+{
+    pthread_mutex_destroy (&_lock);
+}
+
+void FirstException::capture ()
+{
+    pthread_mutex_lock (&_lock);
+    if (!_exception)
+        _exception = boost::current_exception ();
+    pthread_mutex_unlock (&_lock);
+    _failed.store (true);
+}
+
+bool FirstException::failed () const
+{
+    return _failed.load ();
+}
+
+void FirstException::rethrow () const
+{
+    if (_exception)
+        boost::rethrow_exception (_exception);
+}
@@ -0,0 +1,191 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+#include <cstddef>
+#include <deque>
+#include <pthread.h>
+#include <boost/atomic.hpp>
+#include <boost/exception_ptr.hpp>
+
+/**
+ * @brief The first exception thrown by the threads of a parallel region
+ *
+ * An exception must not leave an OpenMP parallel region. Every thread of
+ * the region catches everything and calls capture, the other threads see
+ * failed and stop early, and the exception is rethrown after the region.
+ * Compilers without C++11 rethrow it as a boost::unknown_exception.
+ */
+class FirstException
+{
+  private:
+    boost::exception_ptr _exception;
+    boost::atomic<bool>  _failed;
+    pthread_mutex_t      _lock;
+
+    FirstException (const FirstException&);
+    FirstException& operator= (const FirstException&);
+
+  public:
+    FirstException ();
+    ~FirstException ();
+
+    /**
+     * @brief Keep the exception being handled, if it is the first one
+     *
+     * Must be called from a catch block.
+     */
+    void capture ();
+
+    bool failed () const;
+
+    /**
+     * @brief Throw the first exception again, if there was one
+     */
+    void rethrow () const;
+};
+
+/**
+ * @brief A bounded queue whose threads sleep while they have to wait
+ *
+ * Producers wait while the queue is full and consumers while it is empty
+ * but open. After close nothing is pushed any more, and the consumers take
+ * what is left.
+ */
+template <class T>
+class BlockingQueue
+{
+  private:
+    std::deque<T>   _items;
+    size_t          _capacity;
+    bool            _closed;
+    pthread_mutex_t _lock;
+    pthread_cond_t  _notEmpty;
+    pthread_cond_t  _notFull;
+
+    BlockingQueue (const BlockingQueue&);
+    BlockingQueue& operator= (const BlockingQueue&);
+
+  public:
+    BlockingQueue (size_t capacity);
+    ~BlockingQueue ();
+
+    /**
+     * @brief Append an item if there is room, without waiting
+     */
+    bool tryPush (const T&);
+
+    /**
+     * @brief Append an item, waiting while the queue is full
+     *
+     * @return false if the queue was closed, the item is not taken
+     */
+    bool push (const T&);
+
+    /**
+     * @brief Take the oldest item if there is one, without waiting
+     */
+    bool tryPop (T&);
+
+    /**
+     * @brief Take the oldest item, waiting while the queue is empty
+     *
+     * @return false if the queue is closed and empty
+     */
+    bool pop (T&);
+
+    /**
+     * @brief No more items will be pushed, waiting threads wake up
+     */
+    void close ();
+};
+
+template <class T>
+BlockingQueue<T>::BlockingQueue (size_t capacity)
+    : _capacity (capacity), _closed (false)
+{
+    pthread_mutex_init (&_lock, NULL);
+    pthread_cond_init (&_notEmpty, NULL);
+    pthread_cond_init (&_notFull, NULL);
+}
+
+template <class T>
+BlockingQueue<T>::~BlockingQueue ()
+{
+    pthread_cond_destroy (&_notFull);
+    pthread_cond_destroy (&_notEmpty);
+    pthread_mutex_destroy (&_lock);
+}
+
+template <class T>
+bool BlockingQueue<T>::tryPush (const T& item)
+{
+    pthread_mutex_lock (&_lock);
+    const bool pushed = !_closed and _items.size () < _capacity;
+    if (pushed)
+    {
+        _items.push_back (item);
+        pthread_cond_signal (&_notEmpty);
+    }
+    pthread_mutex_unlock (&_lock);
+    return pushed;
+}
+
+template <class T>
+bool BlockingQueue<T>::push (const T& item)
+{
+    pthread_mutex_lock (&_lock);
+    while (!_closed and _items.size () >= _capacity)
+        pthread_cond_wait (&_notFull, &_lock);
+    const bool pushed = !_closed;
+    if (pushed)
+    {
+        _items.push_back (item);
+        pthread_cond_signal (&_notEmpty);
+    }
+    pthread_mutex_unlock (&_lock);
+    return pushed;
+}
+
+template <class T>
+bool BlockingQueue<T>::tryPop (T& item)
+{
+    pthread_mutex_lock (&_lock);
+    const bool popped = !_items.empty ();
+    if (popped)
+    {
+        item = _items.front ();
+        _items.pop_front ();
+        pthread_cond_signal (&_notFull);
+    }
+    pthread_mutex_unlock (&_lock);
+    return popped;
+}
+
+template <class T>
+bool BlockingQueue<T>::pop (T& item)
+{
+    pthread_mutex_lock (&_lock);
+    while (!_closed and _items.empty ())
+        pthread_cond_wait (&_notEmpty, &_lock);
+    const bool popped = !_items.empty ();
+    if (popped)
+    {
+        item = _items.front ();
+        _items.pop_front ();
+        pthread_cond_signal (&_notFull);
+    }
+    pthread_mutex_unlock (&_lock);
+    return popped;
+}
+
+template <class T>
+void BlockingQueue<T>::close ()
+{
+    pthread_mutex_lock (&_lock);
+    _closed = true;
+    pthread_cond_broadcast (&_notEmpty);
+    pthread_cond_broadcast (&_notFull);
+    pthread_mutex_unlock (&_lock);
+}
+
+#endif
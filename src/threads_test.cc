@@ -0,0 +1,112 @@
+#define BOOST_TEST_MODULE Threads
+#include <boost/test/unit_test.hpp>
+#include "threads.h"
+
+namespace
+{
+
+    class FirstError {};
+    class SecondError {};
+
+    const size_t itemCount = 10000;
+
+    void* produce (void* data)
+    {
+        BlockingQueue<size_t>* queue = (BlockingQueue<size_t>*) data;
+        for (size_t n = 1; n <= itemCount; ++n)
+            queue->push (n);
+        return NULL;
+    }
+
+    void* consume (void* data)
+    {
+        BlockingQueue<size_t>* queue = (BlockingQueue<size_t>*) data;
+        size_t* sum = new size_t (0);
+        size_t item;
+        while (queue->pop (item))
+            *sum += item;
+        return sum;
+    }
+
+}
+
+BOOST_AUTO_TEST_CASE( queue_test )
+{
+    BlockingQueue<int> queue (2);
+    int item = 0;
+    BOOST_CHECK (!queue.tryPop (item));
+
+    BOOST_CHECK (queue.tryPush (1));
+    BOOST_CHECK (queue.push (2));
+    BOOST_CHECK (!queue.tryPush (3));
+
+    BOOST_CHECK (queue.tryPop (item));
+    BOOST_CHECK_EQUAL (item, 1);
+    BOOST_CHECK (queue.tryPush (3));
+
+    // closed queues take nothing but give what is left
+    queue.close ();
+    BOOST_CHECK (!queue.push (4));
+    BOOST_CHECK (queue.pop (item));
+    BOOST_CHECK_EQUAL (item, 2);
+    BOOST_CHECK (queue.pop (item));
+    BOOST_CHECK_EQUAL (item, 3);
+    BOOST_CHECK (!queue.pop (item));
+}
+
+BOOST_AUTO_TEST_CASE( threaded_queue_test )
+{
+    // producers and consumers wait for each other on a small queue
+    BlockingQueue<size_t> queue (8);
+    pthread_t producers[2];
+    pthread_t consumers[3];
+    for (size_t n = 0; n < 2; ++n)
+        pthread_create (&producers[n], NULL, produce, &queue);
+    for (size_t n = 0; n < 3; ++n)
+        pthread_create (&consumers[n], NULL, consume, &queue);
+
+    for (size_t n = 0; n < 2; ++n)
+        pthread_join (producers[n], NULL);
+    queue.close ();
+
+    size_t total = 0;
+    for (size_t n = 0; n < 3; ++n)
+    {
+        void* sum;
+        pthread_join (consumers[n], &sum);
+        total += *(size_t*) sum;
+        delete (size_t*) sum;
+    }
+    BOOST_CHECK_EQUAL (total, 2*itemCount*(itemCount + 1)/2);
+}
+
+BOOST_AUTO_TEST_CASE( first_exception_test )
+{
+    FirstException none;
+    BOOST_CHECK (!none.failed ());
+    BOOST_CHECK_NO_THROW (none.rethrow ());
+
+    FirstException error;
+    try
+    {
+        throw FirstError ();
+    }
+    catch (...)
+    {
+        error.capture ();
+    }
+    try
+    {
+        throw SecondError ();
+    }
+    catch (...)
+    {
+        error.capture ();
+    }
+    BOOST_CHECK (error.failed ());
+#ifndef BOOST_NO_CXX11_HDR_EXCEPTION
+    BOOST_CHECK_THROW (error.rethrow (), FirstError);
+#else
+    BOOST_CHECK_THROW (error.rethrow (), boost::unknown_exception);
+#endif
+}
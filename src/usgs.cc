@@ -7,87 +7,98 @@ UsgsFractions::UsgsFractions ()
     : NotClmFractions (typeCount)
 {}
 
-clm::ClmFractions UsgsFractions::map2Clm () const
+static const MappingMatrix::Entry clmTable[] =
 {
-    clm::ClmFractions clmFractions;
+    {urbanAndBuildUpLand,               clm::noPFT,                              1.00},
+
+    {drylandCropAndPasture,             clm::noPFT,                              0.15},
+    {drylandCropAndPasture,             clm::crop,                               0.85},
+
+    {irrigatedCroplandAndPasture,       clm::noPFT,                              0.15},
+    {irrigatedCroplandAndPasture,       clm::crop,                               0.85},
+
+    {mixedDrylandAndIrrigatedCropland,  clm::noPFT,                              0.15},
+    {mixedDrylandAndIrrigatedCropland,  clm::crop,                               0.85},
 
-    clmFractions.add (clm::noPFT, operator[] (urbanAndBuildUpLand));
+    {croplandAndGrasslandMosaic,        clm::noPFT,                              0.15},
+    {croplandAndGrasslandMosaic,        clm::c4Grass,                            0.35},
+    {croplandAndGrasslandMosaic,        clm::crop,                               0.50},
 
-    clmFractions.add (clm::noPFT, 0.15*operator[] (drylandCropAndPasture));
-    clmFractions.add (clm::crop,  0.85*operator[] (drylandCropAndPasture));
-                                  
-    clmFractions.add (clm::noPFT, 0.15*operator[] (irrigatedCroplandAndPasture));
-    clmFractions.add (clm::crop,  0.85*operator[] (irrigatedCroplandAndPasture));
-                                  
-    clmFractions.add (clm::noPFT, 0.15*operator[] (mixedDrylandAndIrrigatedCropland));
-    clmFractions.add (clm::crop,  0.85*operator[] (mixedDrylandAndIrrigatedCropland));
+    {croplandAndWoodlandMosaic,         clm::noPFT,                              0.30},
+    {croplandAndWoodlandMosaic,         clm::needleleafDeciduousTreeBoreal,      0.30},
+    {croplandAndWoodlandMosaic,         clm::crop,                               0.40},
 
-    clmFractions.add (clm::noPFT,   0.15*operator[] (croplandAndGrasslandMosaic));
-    clmFractions.add (clm::c4Grass, 0.35*operator[] (croplandAndGrasslandMosaic));
-    clmFractions.add (clm::crop,    0.50*operator[] (croplandAndGrasslandMosaic));
+    {grassland,                         clm::noPFT,                              0.20},
+    {grassland,                         clm::c3Grass,                            0.20},
+    {grassland,                         clm::c4Grass,                            0.60},
 
-    clmFractions.add (clm::noPFT,                         0.30*operator[] (croplandAndWoodlandMosaic));
-    clmFractions.add (clm::needleleafDeciduousTreeBoreal, 0.30*operator[] (croplandAndWoodlandMosaic));
-    clmFractions.add (clm::crop,                          0.40*operator[] (croplandAndWoodlandMosaic));
+    {shrubland,                         clm::noPFT,                              0.20},
+    {shrubland,                         clm::broadleafEvergreenShrubTemperate,   0.80},
 
-    clmFractions.add (clm::noPFT,   0.20*operator[] (grassland));
-    clmFractions.add (clm::c3Grass, 0.20*operator[] (grassland));
-    clmFractions.add (clm::c4Grass, 0.60*operator[] (grassland));
+    {mixedShrublandAndGrassland,        clm::noPFT,                              0.20},
+    {mixedShrublandAndGrassland,        clm::broadleafEvergreenShrubTemperate,   0.40},
+    {mixedShrublandAndGrassland,        clm::c4Grass,                            0.40},
 
-    clmFractions.add (clm::noPFT,                            0.20*operator[] (shrubland));
-    clmFractions.add (clm::broadleafEvergreenShrubTemperate, 0.80*operator[] (shrubland));
+    {savanna,                           clm::broadleafDeciduousTreeTropical,     0.30},
+    {savanna,                           clm::c4Grass,                            0.70},
 
-    clmFractions.add (clm::noPFT,                            0.20*operator[] (mixedShrublandAndGrassland));
-    clmFractions.add (clm::broadleafEvergreenShrubTemperate, 0.40*operator[] (mixedShrublandAndGrassland));
-    clmFractions.add (clm::c4Grass,                          0.40*operator[] (mixedShrublandAndGrassland));
+    {deciduousBroadleafForest,          clm::noPFT,                              0.25},
+    {deciduousBroadleafForest,          clm::broadleafDeciduousTreeTemperate,    0.75},
 
-    clmFractions.add (clm::broadleafDeciduousTreeTropical, 0.30*operator[] (savanna));
-    clmFractions.add (clm::c4Grass,                        0.70*operator[] (savanna));
+    {deciduousNeedleleafForest,         clm::noPFT,                              0.50},
+    {deciduousNeedleleafForest,         clm::needleleafDeciduousTreeBoreal,      0.50},
 
-    clmFractions.add (clm::noPFT,                           0.25*operator[] (deciduousBroadleafForest));
-    clmFractions.add (clm::broadleafDeciduousTreeTemperate, 0.75*operator[] (deciduousBroadleafForest));
+    {evergreenBroadleafForest,          clm::noPFT,                              0.05},
+    {evergreenBroadleafForest,          clm::broadleafEvergreenTreeTropical,     0.95},
 
-    clmFractions.add (clm::noPFT,                         0.50*operator[] (deciduousNeedleleafForest));
-    clmFractions.add (clm::needleleafDeciduousTreeBoreal, 0.50*operator[] (deciduousNeedleleafForest));
+    {evergreenNeedleleafForest,         clm::noPFT,                              0.25},
+    {evergreenNeedleleafForest,         clm::needleleafEvergreenTreeTemperate,   0.75},
 
-    clmFractions.add (clm::noPFT,                          0.05*operator[] (evergreenBroadleafForest));
-    clmFractions.add (clm::broadleafEvergreenTreeTropical, 0.95*operator[] (evergreenBroadleafForest));
+    {mixedForest,                       clm::noPFT,                              0.26},
+    {mixedForest,                       clm::needleleafEvergreenTreeTemperate,   0.37},
+    {mixedForest,                       clm::broadleafDeciduousTreeTemperate,    0.37},
 
-    clmFractions.add (clm::noPFT,                            0.25*operator[] (evergreenNeedleleafForest));
-    clmFractions.add (clm::needleleafEvergreenTreeTemperate, 0.75*operator[] (evergreenNeedleleafForest));
+    {waterBodies,                       clm::noPFT,                              1.00},
 
-    clmFractions.add (clm::noPFT,                            0.26*operator[] (mixedForest));
-    clmFractions.add (clm::needleleafEvergreenTreeTemperate, 0.37*operator[] (mixedForest));
-    clmFractions.add (clm::broadleafDeciduousTreeTemperate,  0.37*operator[] (mixedForest));
+    {herbaceousWetland,                 clm::noPFT,                              1.00},
 
-    clmFractions.add (clm::noPFT, operator[] (waterBodies));
+    {woodedWetland,                     clm::noPFT,                              0.20},
+    {woodedWetland,                     clm::broadleafEvergreenTreeTropical,     0.80},
 
-    clmFractions.add (clm::noPFT, operator[] (herbaceousWetland));
+    {barrenOrSparselyVegetated,         clm::noPFT,                              0.90},
+    {barrenOrSparselyVegetated,         clm::broadleafDeciduousShrubBoreal,      0.10},
 
-    clmFractions.add (clm::noPFT,                          0.20*operator[] (woodedWetland));
-    clmFractions.add (clm::broadleafEvergreenTreeTropical, 0.80*operator[] (woodedWetland));
+    {herbaceousTundra,                  clm::noPFT,                              0.40},
+    {herbaceousTundra,                  clm::broadleafDeciduousShrubBoreal,      0.30},
+    {herbaceousTundra,                  clm::c3ArcticGrass,                      0.30},
 
-    clmFractions.add (clm::noPFT,                         0.90*operator[] (barrenOrSparselyVegetated));
-    clmFractions.add (clm::broadleafDeciduousShrubBoreal, 0.10*operator[] (barrenOrSparselyVegetated));
+    {woodenTundra,                      clm::noPFT,                              0.50},
+    {woodenTundra,                      clm::needleleafEvergreenTreeBoreal,      0.13},
+    {woodenTundra,                      clm::needleleafDeciduousTreeBoreal,      0.13},
+    {woodenTundra,                      clm::broadleafDeciduousShrubTemperate,   0.24},
 
-    clmFractions.add (clm::noPFT,                         0.40*operator[] (herbaceousTundra));
-    clmFractions.add (clm::broadleafDeciduousShrubBoreal, 0.30*operator[] (herbaceousTundra));
-    clmFractions.add (clm::c3ArcticGrass,                 0.30*operator[] (herbaceousTundra));
+    {mixedTundra,                       clm::noPFT,                              0.60},
+    {mixedTundra,                       clm::broadleafDeciduousShrubBoreal,      0.20},
+    {mixedTundra,                       clm::c3ArcticGrass,                      0.20},
 
-    clmFractions.add (clm::noPFT,                            0.50*operator[] (woodenTundra));
-    clmFractions.add (clm::needleleafEvergreenTreeBoreal,    0.13*operator[] (woodenTundra));
-    clmFractions.add (clm::needleleafDeciduousTreeBoreal,    0.13*operator[] (woodenTundra));
-    clmFractions.add (clm::broadleafDeciduousShrubTemperate, 0.24*operator[] (woodenTundra));
+    {bareGroundTundra,                  clm::noPFT,                              0.80},
+    {bareGroundTundra,                  clm::broadleafDeciduousShrubBoreal,      0.10},
+    {bareGroundTundra,                  clm::c3ArcticGrass,                      0.10},
 
-    clmFractions.add (clm::noPFT,                         0.60*operator[] (mixedTundra));
-    clmFractions.add (clm::broadleafDeciduousShrubBoreal, 0.20*operator[] (mixedTundra));
-    clmFractions.add (clm::c3ArcticGrass,                 0.20*operator[] (mixedTundra));
+    {snowOrIce,                         clm::noPFT,                              1.00},
+};
 
-    clmFractions.add (clm::noPFT,                         0.80*operator[] (bareGroundTundra));
-    clmFractions.add (clm::broadleafDeciduousShrubBoreal, 0.10*operator[] (bareGroundTundra));
-    clmFractions.add (clm::c3ArcticGrass,                 0.10*operator[] (bareGroundTundra));
+const MappingMatrix& usgs::clmMapping ()
+{
+    static const MappingMatrix matrix (typeCount, clm::typeCount,
+            clmTable, sizeof (clmTable)/sizeof (clmTable[0]));
+    return matrix;
+}
 
-    clmFractions.add (clm::noPFT, operator[] (snowOrIce));
+clm::ClmFractions UsgsFractions::map2Clm () const
+{
+    clm::ClmFractions clmFractions;
+    clmMapping ().apply (*this, clmFractions);
     return clmFractions;
 }
 
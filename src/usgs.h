@@ -3,6 +3,7 @@
 
 #include "notClmFractions.h"
 #include "clm.h"
+#include "mappingMatrix.h"
 
 namespace usgs
 {
@@ -43,6 +44,11 @@ namespace usgs
             UsgsFractions ();
             clm::ClmFractions map2Clm () const;
     };
+
+    /**
+     * @brief The built-in mapping of the USGS types to the CLM types
+     */
+    const MappingMatrix& clmMapping ();
 }
 
 #endif
@@ -0,0 +1,82 @@
+#include <sstream>
+#include <algorithm>
+#include "window.h"
+
+using std::string;
+
+size_t Window::iSize () const
+{
+    return i1 - i0;
+}
+
+size_t Window::jSize () const
+{
+    return j1 - j0;
+}
+
+bool Window::empty () const
+{
+    return i1 <= i0 or j1 <= j0;
+}
+
+Window getFullWindow (size_t iSize, size_t jSize)
+{
+    Window window = {0, iSize, 0, jSize};
+    return window;
+}
+
+Window parseWindow (string text, size_t iSize, size_t jSize)
+{
+    std::istringstream stream (text);
+    long i0, i1, j0, j1;
+    char colon1, comma, colon2;
+    if (!(stream >> i0 >> colon1 >> i1 >> comma >> j0 >> colon2 >> j1)
+            or colon1 != ':' or comma != ',' or colon2 != ':'
+            or !stream.eof ())
+        throw WindowFormatException ();
+
+    if (i0 < 0 or j0 < 0 or i1 <= i0 or j1 <= j0
+            or (size_t) i1 > iSize or (size_t) j1 > jSize)
+        throw WindowOutOfDomainException ();
+
+    Window window = {(size_t) i0, (size_t) i1, (size_t) j0, (size_t) j1};
+    return window;
+}
+
+Window parseTile (string text, size_t iSize, size_t jSize)
+{
+    std::istringstream stream (text);
+    long k, count;
+    char slash;
+    if (!(stream >> k >> slash >> count) or slash != '/' or !stream.eof ())
+        throw WindowFormatException ();
+
+    if (count <= 0 or k < 0 or k >= count or (size_t) count > jSize)
+        throw WindowOutOfDomainException ();
+
+    Window window = {0, iSize, k*jSize/count, (k + 1)*jSize/count};
+    return window;
+}
+
+std::vector<Window> splitWindow (const Window& window, size_t maxCells)
+{
+    // a row of more than maxCells cells is split into pieces of nearly equal
+    // width, the pieces of a band follow each other along i
+    // ---------------------------------------------------------------------
+    maxCells = std::max ((size_t) 1, maxCells);
+    const size_t maxRows = std::max ((size_t) 1, maxCells/std::max ((size_t) 1, window.iSize ()));
+    const size_t count = std::max ((size_t) 1, (window.jSize () + maxRows - 1)/maxRows);
+    const size_t pieceCount = std::max ((size_t) 1, (window.iSize () + maxCells - 1)/maxCells);
+
+    std::vector<Window> bands;
+    for (size_t k = 0; k < count; ++k)
+        for (size_t piece = 0; piece < pieceCount; ++piece)
+        {
+            Window band = {window.i0 + piece*window.iSize ()/pieceCount,
+                           window.i0 + (piece + 1)*window.iSize ()/pieceCount,
+                           window.j0 + k*window.jSize ()/count,
+                           window.j0 + (k + 1)*window.jSize ()/count};
+            bands.push_back (band);
+        }
+    return bands;
+}
@@ -0,0 +1,56 @@
+#ifndef WINDOW_H
+#define WINDOW_H
+
+#include <string>
+#include <vector>
+#include <exception>
+
+/**
+ * @brief A rectangle of grid cells, i0 <= i < i1 and j0 <= j < j1
+ */
+struct Window
+{
+    size_t i0;
+    size_t i1;
+    size_t j0;
+    size_t j1;
+
+    size_t iSize () const;
+    size_t jSize () const;
+    bool empty () const;
+};
+
+/**
+ * @brief The window of a whole grid
+ */
+Window getFullWindow (size_t iSize, size_t jSize);
+
+/**
+ * @brief Parse a window given as "i0:i1,j0:j1"
+ *
+ * @param text  The window, the upper bounds are excluded
+ * @param iSize The size of the grid along i
+ * @param jSize The size of the grid along j
+ */
+Window parseWindow (std::string text, size_t iSize, size_t jSize);
+
+/**
+ * @brief Parse a tile given as "k/N", the k-th of N bands of rows
+ *
+ * The tiles are numbered from 0 and together cover the grid.
+ */
+Window parseTile (std::string text, size_t iSize, size_t jSize);
+
+/**
+ * @brief Split a window into bands of rows with at most maxCells cells each
+ *
+ * The bands have nearly equal sizes and cover the window in order. A band
+ * has at least one row; if a row has more than maxCells cells, every band
+ * is a single row split along i into pieces of at most maxCells cells.
+ */
+std::vector<Window> splitWindow (const Window& window, size_t maxCells);
+
+class WindowFormatException : public std::exception {};
+class WindowOutOfDomainException : public std::exception {};
+
+#endif
@@ -0,0 +1,72 @@
+#define BOOST_TEST_MODULE Window
+#include <boost/test/unit_test.hpp>
+#include <sstream>
+#include "window.h"
+
+BOOST_AUTO_TEST_CASE( window_test )
+{
+    // windows exclude their upper bounds
+    Window window = parseWindow ("2:5,10:20", 100, 50);
+    BOOST_CHECK_EQUAL (window.i0, 2u);
+    BOOST_CHECK_EQUAL (window.i1, 5u);
+    BOOST_CHECK_EQUAL (window.j0, 10u);
+    BOOST_CHECK_EQUAL (window.j1, 20u);
+    BOOST_CHECK_EQUAL (window.iSize (), 3u);
+    BOOST_CHECK_EQUAL (window.jSize (), 10u);
+    BOOST_CHECK (!window.empty ());
+
+    BOOST_CHECK_THROW (parseWindow ("2:5;10:20", 100, 50), WindowFormatException);
+    BOOST_CHECK_THROW (parseWindow ("2:5,10:20x", 100, 50), WindowFormatException);
+    BOOST_CHECK_THROW (parseWindow ("2:5", 100, 50), WindowFormatException);
+    BOOST_CHECK_THROW (parseWindow ("5:2,10:20", 100, 50), WindowOutOfDomainException);
+    BOOST_CHECK_THROW (parseWindow ("2:5,10:51", 100, 50), WindowOutOfDomainException);
+
+    // the tiles cover all rows without overlap
+    size_t rows = 0;
+    size_t next = 0;
+    for (size_t k = 0; k < 7; ++k)
+    {
+        std::ostringstream text;
+        text << k << "/7";
+        Window tile = parseTile (text.str (), 100, 50);
+        BOOST_CHECK_EQUAL (tile.i0, 0u);
+        BOOST_CHECK_EQUAL (tile.i1, 100u);
+        BOOST_CHECK_EQUAL (tile.j0, next);
+        next = tile.j1;
+        rows += tile.jSize ();
+    }
+    BOOST_CHECK_EQUAL (rows, 50u);
+    BOOST_CHECK_EQUAL (next, 50u);
+
+    BOOST_CHECK_THROW (parseTile ("7/7", 100, 50), WindowOutOfDomainException);
+    BOOST_CHECK_THROW (parseTile ("1-7", 100, 50), WindowFormatException);
+
+    // the bands of a split window have at most the given number of cells
+    Window domain = parseWindow ("10:30,5:48", 100, 50);
+    std::vector<Window> bands = splitWindow (domain, 100);
+    BOOST_CHECK_EQUAL (bands.size (), 9u);
+    next = domain.j0;
+    for (size_t n = 0; n < bands.size (); ++n)
+    {
+        BOOST_CHECK_EQUAL (bands[n].i0, 10u);
+        BOOST_CHECK_EQUAL (bands[n].i1, 30u);
+        BOOST_CHECK_EQUAL (bands[n].j0, next);
+        BOOST_CHECK (bands[n].iSize ()*bands[n].jSize () <= 100u);
+        BOOST_CHECK (!bands[n].empty ());
+        next = bands[n].j1;
+    }
+    BOOST_CHECK_EQUAL (next, 48u);
+
+    // a row wider than the budget is split along i
+    bands = splitWindow (domain, 6);
+    BOOST_CHECK_EQUAL (bands.size (), 4u*43u);
+    for (size_t n = 0; n < bands.size (); ++n)
+    {
+        BOOST_CHECK_EQUAL (bands[n].jSize (), 1u);
+        BOOST_CHECK (bands[n].iSize () <= 6u);
+        BOOST_CHECK_EQUAL (bands[n].i0, n % 4 == 0 ? 10u : bands[n - 1].i1);
+        BOOST_CHECK_EQUAL (bands[n].j0, domain.j0 + n/4);
+    }
+    BOOST_CHECK_EQUAL (bands.back ().i1, 30u);
+    BOOST_CHECK_EQUAL (splitWindow (domain, 10000).size (), 1u);
+}
@@ -8,6 +8,7 @@
 #include "clm.h"
 #include "modis.h"
 #include "usgs.h"
+#include "stats.h"
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -25,12 +26,37 @@ using std::uppercase;
 
 using namespace wrf;
 
+#ifdef _OPENMP
+namespace
+{
+    // the lock of the NetCDF library, shared by all files
+    struct NetcdfLock
+    {
+        omp_lock_t lock;
+        NetcdfLock ()  { omp_init_lock (&lock); }
+        ~NetcdfLock () { omp_destroy_lock (&lock); }
+    };
+
+    NetcdfLock netcdfLock;
+}
+#endif
+
+BandWriter::~BandWriter ()
+{}
+
+string wrf::pftVariableName (string prefix, size_t type)
+{
+    stringstream stream;
+    stream << prefix;
+    stream.fill ('0');
+    stream.width (2);
+    stream << type;
+    return stream.str ();
+}
+
 File::File (string fileName, FileMode fileMode)
     : NcFile (fileName.c_str (), fileMode),
       _errorBehavior (new NcError (NcError::silent_nonfatal))
-#ifdef _OPENMP
-      , _lock (new omp_lock_t)
-#endif
 {
 
     NcDim* dimension = get_dim ("west_east");
@@ -53,6 +79,7 @@ File::File (string fileName, FileMode fileMode)
        << " +y_0="      << (((double) jSize ())/2.0 * getDy ())
        << " +ellps=WGS84 +datum=WGS84";
     _coordinateSystem->importFromProj4 (ss.str ().c_str ());
+    internCoordinateSystem ();
 
     // get parameters for affine transformation //
     //------------------------------------------//
@@ -71,17 +98,10 @@ File::File (string fileName, FileMode fileMode)
     _padfTransformInverse[3] = -_padfTransform[3]/_padfTransform[5];
     _padfTransformInverse[4] = 0.0;
     _padfTransformInverse[5] = 1.0/_padfTransform[5];
-
-#ifdef _OPENMP
-    omp_init_lock (_lock.get ());
-#endif
 }
 
 File::~File ()
 {
-#ifdef _OPENMP
-    omp_destroy_lock (_lock.get ());
-#endif
     close ();
 }
 
@@ -148,17 +168,47 @@ boost::shared_ptr<NotClmFractions> File::getLandUseFraction (size_t i, size_t j)
     return result;
 }
 
+boost::multi_array<float, 3> File::getLandUseFractions (size_t jOffset, size_t jCount)
+{
+    return getLandUseFractions (0, iSize (), jOffset, jCount);
+}
+
+boost::multi_array<float, 3> File::getLandUseFractions (size_t iOffset, size_t iCount,
+        size_t jOffset, size_t jCount)
+{
+    // check window against domain size //
+    //----------------------------------//
+    if (iOffset + iCount > iSize () or jOffset + jCount > jSize ())
+        throw OutOfDomainException ();
+
+    NcDim* landCatDim = get_dim ("land_cat_stag");
+    if (landCatDim == NULL) throw UnknownLUTypeException ();
+    size_t landCatStag = landCatDim->size ();
+
+    boost::multi_array<float, 3> result (
+            boost::extents[landCatStag][jCount][iCount]);
+
+    // read from NetCDF //
+    //------------------//
+    std::vector<size_t> start (4, 0);
+    start[2] = jOffset;
+    start[3] = iOffset;
+    read ("LANDUSEF", start, result);
+
+    return result;
+}
+
+const MappingMatrix& File::getLandUseMapping () const
+{
+    if (isModisLUType ())     return modis::clmMapping ();
+    else if (isUsgsLUType ()) return usgs::clmMapping ();
+    else throw UnknownLUTypeException ();
+}
+
 void File::writeClmPftTypeFractions (size_t i, size_t j, const clm::ClmFractions& fractions)
 {
     for (size_t type = 0; type < clm::typeCount - 1; type++)
     {
-        stringstream stream;
-        stream << clmPFTtypeFractionName;
-        stream.fill ('0');
-        stream.width (2);
-        stream << type;
-        string varName = stream.str ();
-
         long offset[3] = {0, (long) j, (long) i};
         long counts[3] = {1, 1, 1};
 
@@ -166,25 +216,9 @@ void File::writeClmPftTypeFractions (size_t i, size_t j, const clm::ClmFractions
         lock ();
 #endif
 
-        NcVar* variable = get_var (varName.c_str ());
-        if (!variable)
-        {
-            boost::scoped_array<const NcDim*> dims (
-                    new const NcDim*[3]);
-            dims[0] = get_dim ("Time");
-            dims[1] = get_dim ("south_north");
-            dims[2] = get_dim ("west_east");
-
-            variable = add_var (varName.c_str (), ncFloat, 3, dims.get ());
-
-            variable->add_att ("FieldType", 104);
-            variable->add_att ("MemoryOrder", "XY");
-            variable->add_att ("units", "category");
-            variable->add_att ("description", "CLM plant functional types fractions");
-            variable->add_att ("stagger", "M");
-            variable->add_att ("sr_x", "1");
-            variable->add_att ("sr_y", "1");
-        }
+        NcVar* variable = get2DVariable (
+                pftVariableName (clmPFTtypeFractionName, type),
+                "category", "CLM plant functional types fractions");
 
         variable->set_cur (offset);
         variable->put (&fractions[type], counts);
@@ -196,6 +230,38 @@ void File::writeClmPftTypeFractions (size_t i, size_t j, const clm::ClmFractions
     }
 }
 
+void File::writeClmPftTypeFractions (size_t jOffset,
+        const boost::multi_array<float, 3>& fractions)
+{
+    writeClmPftTypeFractions (0, jOffset, fractions);
+}
+
+void File::writeClmPftTypeFractions (size_t iOffset, size_t jOffset,
+        const boost::multi_array<float, 3>& fractions)
+{
+    if (   fractions.shape ()[0] < clm::typeCount - 1
+        or iOffset + fractions.shape ()[2] > iSize ()
+        or jOffset + fractions.shape ()[1] > jSize ())
+        throw WrongDimensionSizeException ();
+
+    for (size_t type = 0; type < clm::typeCount - 1; type++)
+    {
+#ifdef _OPENMP
+        lock ();
+#endif
+
+        NcVar* variable = get2DVariable (
+                pftVariableName (clmPFTtypeFractionName, type),
+                "category", "CLM plant functional types fractions");
+        write2DWindow (variable, iOffset, jOffset, &fractions[type][0][0],
+                fractions.shape ()[2], fractions.shape ()[1]);
+
+#ifdef _OPENMP
+        unlock ();
+#endif
+    }
+}
+
 bool File::isModisLUType () const
 {
     char* luType = get_att ("MMINLU")->as_string (0);
@@ -228,11 +294,13 @@ bool File::isUsgsLUType () const
 
 boost::multi_array<float, 2> File::getClmType (size_t type)
 {
-    boost::array<long, 4> offset = {{0, (long) type, 0, 0}};
-    boost::array<long, 4> count = {{1, 1, (long) jSize (), (long) iSize ()}};
-
-    boost::multi_array<float, 3> data = read<float, 3> ("clm_landuse_fraction", offset, count);
-    return data[boost::indices[0][boost::multi_array_types::index_range(0, jSize ())][boost::multi_array_types::index_range (0, iSize ())]];
+    // the plane of the type is read into the result //
+    //------------------------------------------------//
+    boost::multi_array<float, 2> data (boost::extents[jSize ()][iSize ()]);
+    std::vector<size_t> start (4, 0);
+    start[1] = type;
+    read ("clm_landuse_fraction", start, data);
+    return data;
 }
 
 void File::createMosaic (File& highResFile)
@@ -261,65 +329,101 @@ void File::createMosaic (File& highResFile)
     if (get_dim ("mosaic_cells")->size () != (int)mosaicCellCount)
         throw WrongMosaicGeometryException ();
 
+    // every thread reads the fields of the nested grid into one buffer, the
+    // mosaic cells are written from strided views of it
+    // ---------------------------------------------------------------------
+    const std::vector<size_t> start (3, 0);
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp parallel
 #endif
-    for (size_t type = 0; type < clm::typeCount - 1; type++)
     {
-        stringstream highResVarName;
-        highResVarName << clmPFTtypeFractionName;
-        highResVarName.fill ('0');
-        highResVarName.width (2);
-        highResVarName << type;
-
-        boost::multi_array<float, 2> highResData =
-            highResFile.read<float, 2> (highResVarName.str ());
-
-        boost::multi_array<float, 3> data =
-            mosaicArray (highResData, mosaicCellCount, dxFac, dyFac);
-
-        stringstream stream;
-        stream << "CLM_LANDUSE_FRACTION_MOSAIC_";
-        stream.fill ('0');
-        stream.width (2);
-        stream << type;
-        write (stream.str (), data);
+        boost::multi_array<float, 2> highResData (
+                boost::extents[highResFile.jSize ()][highResFile.iSize ()]);
 
+#ifdef _OPENMP
+#pragma omp for
+#endif
+        for (size_t type = 0; type < clm::typeCount - 1; type++)
+        {
+            highResFile.read (pftVariableName (clmPFTtypeFractionName, type), start,
+                    highResData);
+            writeMosaic (pftVariableName ("CLM_LANDUSE_FRACTION_MOSAIC_", type),
+                    highResData, dxFac, dyFac);
+        }
     }
 
-    boost::multi_array<float, 2> highResData;
-    boost::multi_array<float, 3> data;
+    boost::multi_array<float, 2> highResData (
+            boost::extents[highResFile.jSize ()][highResFile.iSize ()]);
 
-    highResData = highResFile.read<float, 2> ("waterFraction");
-    data = mosaicArray (highResData, mosaicCellCount, dxFac, dyFac);
-    write ("WATERFRACTION_MOSAIC", data);
+    highResFile.read ("waterFraction", start, highResData);
+    writeMosaic ("WATERFRACTION_MOSAIC", highResData, dxFac, dyFac);
 
-    highResData = highResFile.read<float, 2> ("urbanFraction");
-    data = mosaicArray (highResData, mosaicCellCount, dxFac, dyFac);
-    write ("URBANFRACTION_MOSAIC", data);
+    highResFile.read ("urbanFraction", start, highResData);
+    writeMosaic ("URBANFRACTION_MOSAIC", highResData, dxFac, dyFac);
 
-    highResData = highResFile.read<float, 2> ("glacierFraction");
-    data = mosaicArray (highResData, mosaicCellCount, dxFac, dyFac);
-    write ("GLACIERFRACTION_MOSAIC", data);
+    highResFile.read ("glacierFraction", start, highResData);
+    writeMosaic ("GLACIERFRACTION_MOSAIC", highResData, dxFac, dyFac);
 
-    highResData = highResFile.read<float, 2> ("wetlandFraction");
-    data = mosaicArray (highResData, mosaicCellCount, dxFac, dyFac);
-    write ("WETLANDFRACTION_MOSAIC", data);
+    highResFile.read ("wetlandFraction", start, highResData);
+    writeMosaic ("WETLANDFRACTION_MOSAIC", highResData, dxFac, dyFac);
 
 }
 
+void File::writeMosaic (string varName, const boost::multi_array<float, 2>& highResData,
+        size_t dxFac, size_t dyFac)
+{
+    typedef boost::multi_array_types::index_range range;
+
+    // mosaic cell im*dyFac + jm holds every dyFac-th row from jm and every
+    // dxFac-th column from im, see mosaicArray; each is gathered into one
+    // buffer and written at once
+    // --------------------------------------------------------------------
+    boost::multi_array<float, 2> cell (boost::extents[jSize ()][iSize ()]);
+    std::vector<size_t> start (4, 0);
+    for (size_t im = 0; im < dxFac; im++)
+        for (size_t jm = 0; jm < dyFac; jm++)
+        {
+            start[1] = im*dyFac + jm;
+            cell = highResData[boost::indices
+                    [range (jm, jSize ()*dyFac, dyFac)]
+                    [range (im, iSize ()*dxFac, dxFac)]];
+            write (varName, start, cell);
+        }
+}
+
 #ifdef _OPENMP
 void File::lock ()
 {
-    omp_set_lock (_lock.get ());
+    double start = stats::now ();
+    omp_set_lock (&netcdfLock.lock);
+    stats::add (stats::lockWaitTime, stats::now () - start);
+    stats::count (stats::lockAcquisitions);
 }
 
 void File::unlock ()
 {
-    omp_unset_lock (_lock.get ());
+    omp_unset_lock (&netcdfLock.lock);
 }
 #endif
 
+void File::defineClmOutput ()
+{
+#ifdef _OPENMP
+    lock ();
+#endif
+    for (size_t type = 0; type < clm::typeCount - 1; type++)
+        get2DVariable (pftVariableName (clmPFTtypeFractionName, type),
+                "category", "CLM plant functional types fractions");
+    get2DVariable ("waterFraction", "", "waterFraction");
+    get2DVariable ("urbanFraction", "", "urbanFraction");
+    get2DVariable ("glacierFraction", "", "glacierFraction");
+    get2DVariable ("wetlandFraction", "", "wetlandFraction");
+    sync ();
+#ifdef _OPENMP
+    unlock ();
+#endif
+}
+
 void File::writeWaterFraction (size_t i, size_t j, double fraction)
 {
     write0Dto2D ("waterFraction", i, j, fraction);
@@ -340,11 +444,61 @@ void File::writeWetlandFraction (size_t i, size_t j, double fraction)
     write0Dto2D ("wetlandFraction", i, j, fraction);
 }
 
-void File::write0Dto2D (string varName, size_t i, size_t j, double value)
+void File::writeWaterFraction (size_t jOffset, const boost::multi_array<float, 2>& fraction)
+{
+    write2D ("waterFraction", 0, jOffset, fraction);
+}
+
+void File::writeUrbanFraction (size_t jOffset, const boost::multi_array<float, 2>& fraction)
+{
+    write2D ("urbanFraction", 0, jOffset, fraction);
+}
+
+void File::writeGlacierFraction (size_t jOffset, const boost::multi_array<float, 2>& fraction)
+{
+    write2D ("glacierFraction", 0, jOffset, fraction);
+}
+
+void File::writeWetlandFraction (size_t jOffset, const boost::multi_array<float, 2>& fraction)
+{
+    write2D ("wetlandFraction", 0, jOffset, fraction);
+}
+
+void File::writeWaterFraction (size_t iOffset, size_t jOffset,
+        const boost::multi_array<float, 2>& fraction)
+{
+    write2D ("waterFraction", iOffset, jOffset, fraction);
+}
+
+void File::writeUrbanFraction (size_t iOffset, size_t jOffset,
+        const boost::multi_array<float, 2>& fraction)
+{
+    write2D ("urbanFraction", iOffset, jOffset, fraction);
+}
+
+void File::writeGlacierFraction (size_t iOffset, size_t jOffset,
+        const boost::multi_array<float, 2>& fraction)
+{
+    write2D ("glacierFraction", iOffset, jOffset, fraction);
+}
+
+void File::writeWetlandFraction (size_t iOffset, size_t jOffset,
+        const boost::multi_array<float, 2>& fraction)
+{
+    write2D ("wetlandFraction", iOffset, jOffset, fraction);
+}
+
+void File::writeBand (const OutputBand& band)
+{
+    writeClmPftTypeFractions (band.iOffset, band.jOffset, band.clmPftTypeFractions);
+    writeWaterFraction (band.iOffset, band.jOffset, band.waterFraction);
+    writeUrbanFraction (band.iOffset, band.jOffset, band.urbanFraction);
+    writeGlacierFraction (band.iOffset, band.jOffset, band.glacierFraction);
+    writeWetlandFraction (band.iOffset, band.jOffset, band.wetlandFraction);
+}
+
+NcVar* File::get2DVariable (string varName, string units, string description)
 {
-#ifdef _OPENMP
-        lock ();
-#endif
     NcVar* variable = get_var (varName.c_str ());
     if (!variable) {
         boost::scoped_array<const NcDim*> dims (
@@ -359,22 +513,78 @@ void File::write0Dto2D (string varName, size_t i, size_t j, double value)
 
         variable->add_att ("FieldType", 104);
         variable->add_att ("MemoryOrder", "XY");
-        variable->add_att ("units", "");
-        variable->add_att ("description", varName.c_str ());
+        variable->add_att ("units", units.c_str ());
+        variable->add_att ("description", description.c_str ());
         variable->add_att ("stagger", "M");
         variable->add_att ("sr_x", "1");
         variable->add_att ("sr_y", "1");
     }
-#ifdef _OPENMP
-        unlock ();
-#endif
+    return variable;
+}
+
+void File::write2DWindow (NcVar* variable, size_t iOffset, size_t jOffset,
+        const float* data, size_t iCount, size_t jCount)
+{
+    long offset[3] = {0, (long) jOffset, (long) iOffset};
+    long counts[3] = {1, (long) jCount, (long) iCount};
+
+    variable->set_cur (offset);
+    variable->put (data, counts);
+}
+
+bool wrf::isContiguous (size_t rank, const size_t* shape, const ptrdiff_t* strides)
+{
+    // the stride of a dimension of size 1 does not matter //
+    //-------------------------------------------------------//
+    ptrdiff_t expected = 1;
+    for (size_t k = rank; k-- > 0; )
+    {
+        if (shape[k] != 1 and strides[k] != expected)
+            return false;
+        expected *= shape[k];
+    }
+    return true;
+}
 
+NcVar* File::getHyperslab (string varName, const vector<size_t>& start, size_t rank,
+        const size_t* shape, vector<size_t>& count)
+{
+    NcVar* variable = get_var (varName.c_str ());
+    if (!variable)
+        throw VariableNotExistException ();
+
+    // the array covers the last dimensions //
+    //---------------------------------------//
+    const size_t variableRank = variable->num_dims ();
+    if (start.size () != variableRank or rank > variableRank)
+        throw WrongDimensionSizeException ();
+
+    const size_t leading = variableRank - rank;
+    count.assign (variableRank, 1);
+    for (size_t k = 0; k < rank; ++k)
+        count[leading + k] = shape[k];
+
+    // records may be appended along an unlimited dimension //
+    //-------------------------------------------------------//
+    for (size_t k = 0; k < variableRank; ++k)
+    {
+        NcDim* dimension = variable->get_dim (k);
+        if (    !dimension->is_unlimited ()
+            and start[k] + count[k] > (size_t) dimension->size ())
+            throw WrongDimensionSizeException ();
+    }
+    return variable;
+}
+
+void File::write0Dto2D (string varName, size_t i, size_t j, double value)
+{
     long offset[3] = {0, (long) j, (long) i};
     long counts[3] = {1, 1, 1};
 
 #ifdef _OPENMP
     lock ();
 #endif
+    NcVar* variable = get2DVariable (varName, "", varName);
     variable->set_cur (offset);
     variable->put (&value, counts);
 #ifdef _OPENMP
@@ -382,6 +592,23 @@ void File::write0Dto2D (string varName, size_t i, size_t j, double value)
 #endif
 }
 
+void File::write2D (string varName, size_t iOffset, size_t jOffset,
+        const boost::multi_array<float, 2>& data)
+{
+    if (iOffset + data.shape ()[1] > iSize () or jOffset + data.shape ()[0] > jSize ())
+        throw WrongDimensionSizeException ();
+
+#ifdef _OPENMP
+    lock ();
+#endif
+    NcVar* variable = get2DVariable (varName, "", varName);
+    write2DWindow (variable, iOffset, jOffset, data.data (),
+            data.shape ()[1], data.shape ()[0]);
+#ifdef _OPENMP
+    unlock ();
+#endif
+}
+
 boost::multi_array<float, 3> File::mosaicArray (
         const boost::multi_array<float, 2>& highResData,
         size_t mosaicCellCount, size_t dxFac, size_t dyFac) const
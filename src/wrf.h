@@ -3,11 +3,14 @@
 
 #include <netcdfcpp.h>
 #include <string>
+#include <vector>
+#include <cstddef>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/array.hpp>
 #include <boost/multi_array.hpp>
 #include "notClmFractions.h"
+#include "mappingMatrix.h"
 #include "geoRaster.h"
 
 #ifdef _OPENMP
@@ -25,25 +28,112 @@ namespace wrf
     class WrongDimensionSizeException {};
     class UnknownLUTypeException {};
     class WrongMosaicGeometryException {};
+    class HyperslabException {};
 
-    class File : public NcFile, public GeoRaster
+    /**
+     * @brief nc_get_vara and nc_put_vara chosen by the type of the memory
+     */
+    inline int getVara (int file, int variable, const size_t* start, const size_t* count,
+            float* data)
+    {
+        return nc_get_vara_float (file, variable, start, count, data);
+    }
+
+    inline int putVara (int file, int variable, const size_t* start, const size_t* count,
+            const float* data)
+    {
+        return nc_put_vara_float (file, variable, start, count, data);
+    }
+
+    inline int getVara (int file, int variable, const size_t* start, const size_t* count,
+            double* data)
+    {
+        return nc_get_vara_double (file, variable, start, count, data);
+    }
+
+    inline int putVara (int file, int variable, const size_t* start, const size_t* count,
+            const double* data)
+    {
+        return nc_put_vara_double (file, variable, start, count, data);
+    }
+
+    inline int getVara (int file, int variable, const size_t* start, const size_t* count,
+            int* data)
+    {
+        return nc_get_vara_int (file, variable, start, count, data);
+    }
+
+    inline int putVara (int file, int variable, const size_t* start, const size_t* count,
+            const int* data)
+    {
+        return nc_put_vara_int (file, variable, start, count, data);
+    }
+
+    inline int getVara (int file, int variable, const size_t* start, const size_t* count,
+            short* data)
+    {
+        return nc_get_vara_short (file, variable, start, count, data);
+    }
+
+    inline int putVara (int file, int variable, const size_t* start, const size_t* count,
+            const short* data)
+    {
+        return nc_put_vara_short (file, variable, start, count, data);
+    }
+
+    /**
+     * @brief Whether an array is stored in C order without gaps, so it can
+     *        be passed to nc_get_vara and nc_put_vara as it is
+     */
+    bool isContiguous (size_t rank, const size_t* shape, const ptrdiff_t* strides);
+
+    /**
+     * @brief The name of the variable of one CLM plant functional type
+     */
+    std::string pftVariableName (std::string prefix, size_t type);
+
+    /**
+     * @brief The output of a band of rows, waiting to be written
+     *
+     * The band may cover only some columns, starting at column iOffset.
+     */
+    struct OutputBand
+    {
+        size_t                       iOffset;
+        size_t                       jOffset;
+        boost::multi_array<float, 3> clmPftTypeFractions;
+        boost::multi_array<float, 2> waterFraction;
+        boost::multi_array<float, 2> urbanFraction;
+        boost::multi_array<float, 2> glacierFraction;
+        boost::multi_array<float, 2> wetlandFraction;
+    };
+
+    /**
+     * @brief Anything output bands can be written to
+     */
+    class BandWriter
+    {
+      public:
+        virtual ~BandWriter ();
+        virtual void writeBand (const OutputBand&) = 0;
+    };
+
+    class File : public NcFile, public GeoRaster, public BandWriter
     {
       private:
         size_t _iSize;
         size_t _jSize;
         boost::scoped_ptr<NcError> _errorBehavior;
 
-#ifdef _OPENMP
-        boost::scoped_ptr<omp_lock_t> _lock;
-#endif
-
         double getDx () const;
         double getDy () const;
         void write0Dto2D (std::string, size_t, size_t, double);
-
-        boost::multi_array<float, 3> mosaicArray (
-                const boost::multi_array<float, 2>&,
-                size_t, size_t, size_t) const;
+        void write2D (std::string, size_t, size_t, const boost::multi_array<float, 2>&);
+        NcVar* get2DVariable (std::string, std::string, std::string);
+        void write2DWindow (NcVar*, size_t, size_t, const float*, size_t, size_t);
+        NcVar* getHyperslab (std::string, const std::vector<size_t>&, size_t,
+                const size_t*, std::vector<size_t>&);
+        void writeMosaic (std::string, const boost::multi_array<float, 2>&, size_t, size_t);
 
       public:
         File (std::string, FileMode = ReadOnly);
@@ -51,19 +141,65 @@ namespace wrf
         size_t iSize () const;
         size_t jSize () const;
         boost::shared_ptr<NotClmFractions> getLandUseFraction (size_t, size_t);
+        boost::multi_array<float, 3> getLandUseFractions (size_t, size_t);
+        boost::multi_array<float, 3> getLandUseFractions (size_t, size_t, size_t, size_t);
+        const MappingMatrix& getLandUseMapping () const;
         void writeClmPftTypeFractions (size_t, size_t, const clm::ClmFractions&);
+        void writeClmPftTypeFractions (size_t, const boost::multi_array<float, 3>&);
+        void writeClmPftTypeFractions (size_t, size_t, const boost::multi_array<float, 3>&);
         bool isModisLUType () const;
         bool isUsgsLUType () const;
         boost::multi_array<float, 2> getClmType (size_t);
         void createMosaic (wrf::File&);
+
+        /**
+         * @brief Split a field of a nested grid into the mosaic cells of this grid
+         *
+         * @param highResData The field of the nested grid [j][i]
+         * @param mosaicCellCount dxFac*dyFac
+         * @param dxFac Number of nested cells per cell along i
+         * @param dyFac Number of nested cells per cell along j
+         *
+         * @return The field [mosaic cell][j][i]
+         */
+        boost::multi_array<float, 3> mosaicArray (
+                const boost::multi_array<float, 2>& highResData,
+                size_t mosaicCellCount, size_t dxFac, size_t dyFac) const;
 #ifdef _OPENMP
-        void lock ();
-        void unlock ();
+
+        /**
+         * @brief Serialize calls into the NetCDF library
+         *
+         * The library is not thread safe, so all files share one lock.
+         */
+        static void lock ();
+        static void unlock ();
 #endif
+
+        /**
+         * @brief Create all variables written by corine2wrfClm
+         *
+         * Adding variables may move the data of a file, so they are created
+         * before other handles to the same file are opened.
+         */
+        void defineClmOutput ();
         void writeWaterFraction (size_t, size_t, double);
         void writeUrbanFraction (size_t, size_t, double);
         void writeGlacierFraction (size_t, size_t, double);
         void writeWetlandFraction (size_t, size_t, double);
+        void writeWaterFraction (size_t, const boost::multi_array<float, 2>&);
+        void writeUrbanFraction (size_t, const boost::multi_array<float, 2>&);
+        void writeGlacierFraction (size_t, const boost::multi_array<float, 2>&);
+        void writeWetlandFraction (size_t, const boost::multi_array<float, 2>&);
+        void writeWaterFraction (size_t, size_t, const boost::multi_array<float, 2>&);
+        void writeUrbanFraction (size_t, size_t, const boost::multi_array<float, 2>&);
+        void writeGlacierFraction (size_t, size_t, const boost::multi_array<float, 2>&);
+        void writeWetlandFraction (size_t, size_t, const boost::multi_array<float, 2>&);
+
+        /**
+         * @brief Write all fields of a band
+         */
+        void writeBand (const OutputBand&);
 
         template<typename T, size_t D>
         void write (
@@ -83,6 +219,35 @@ namespace wrf
                 boost::array<long, D+1>& offset,
                 boost::array<long, D+1>& count);
 
+        /**
+         * @brief Read a hyperslab into memory of the caller
+         *
+         * The data are read with a single call into the library. An array
+         * in C order without gaps is filled in place. Other arrays, e.g. a
+         * view of every second row, are filled from a buffer in C order,
+         * because nc_get_varm would read them value by value.
+         *
+         * @param varName The variable
+         * @param start   The first index along every dimension of the
+         *                variable. The array covers the last dimensions,
+         *                the leading ones, e.g. Time or a level, are read
+         *                with a count of 1.
+         * @param data    A multi_array, multi_array_ref or view, its shape
+         *                is the count along the last dimensions
+         *
+         * @throws WrongDimensionSizeException if the hyperslab is not
+         *         within the variable
+         */
+        template<typename Array>
+        void read (std::string varName, const std::vector<size_t>& start, Array& data);
+
+        /**
+         * @brief Write a hyperslab from memory of the caller, see read
+         */
+        template<typename Array>
+        void write (std::string varName, const std::vector<size_t>& start,
+                const Array& data);
+
     };
 
     template<typename T, size_t D>
@@ -161,6 +326,67 @@ namespace wrf
         return data;
     }
 
+    template<typename Array>
+    void File::read (std::string varName, const std::vector<size_t>& start, Array& data)
+    {
+        std::vector<size_t> count;
+        NcVar* variable = getHyperslab (varName, start, Array::dimensionality,
+                data.shape (), count);
+
+        if (!isContiguous (Array::dimensionality, data.shape (), data.strides ()))
+        {
+            boost::multi_array<typename Array::element, Array::dimensionality> buffer (
+                    std::vector<size_t> (data.shape (), data.shape () + Array::dimensionality));
+            read (varName, start, buffer);
+            data = buffer;
+            return;
+        }
+
+#ifdef _OPENMP
+        lock ();
+#endif
+
+        int status = getVara (id (), variable->id (), &start[0], &count[0], data.origin ());
+
+#ifdef _OPENMP
+        unlock ();
+#endif
+
+        if (status != NC_NOERR)
+            throw HyperslabException ();
+    }
+
+    template<typename Array>
+    void File::write (std::string varName, const std::vector<size_t>& start,
+            const Array& data)
+    {
+        std::vector<size_t> count;
+        NcVar* variable = getHyperslab (varName, start, Array::dimensionality,
+                data.shape (), count);
+
+        if (!isContiguous (Array::dimensionality, data.shape (), data.strides ()))
+        {
+            boost::multi_array<typename Array::element, Array::dimensionality> buffer (
+                    std::vector<size_t> (data.shape (), data.shape () + Array::dimensionality));
+            buffer = data;
+            write (varName, start, buffer);
+            return;
+        }
+
+#ifdef _OPENMP
+        lock ();
+#endif
+
+        int status = putVara (id (), variable->id (), &start[0], &count[0], data.origin ());
+
+#ifdef _OPENMP
+        unlock ();
+#endif
+
+        if (status != NC_NOERR)
+            throw HyperslabException ();
+    }
+
     template<typename T, size_t D>
     boost::multi_array<T, D> File::read (std::string varName)
     {
@@ -0,0 +1,143 @@
+#define BOOST_TEST_MODULE Wrf
+#include <boost/test/unit_test.hpp>
+#include <boost/multi_array.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "wrf.h"
+
+typedef boost::multi_array<float, 2> Array2D;
+typedef boost::multi_array_types::index_range range;
+
+static const size_t iSize = 6;
+static const size_t jSize = 4;
+static const size_t levelCount = 3;
+
+/**
+ * @brief A small WRF grid with a field and a field of several levels
+ */
+static void createFile (std::string fileName)
+{
+    NcFile file (fileName.c_str (), NcFile::Replace);
+    BOOST_REQUIRE (file.is_valid ());
+
+    NcDim* time = file.add_dim ("Time");
+    NcDim* level = file.add_dim ("level", levelCount);
+    NcDim* southNorth = file.add_dim ("south_north", jSize);
+    NcDim* westEast = file.add_dim ("west_east", iSize);
+
+    file.add_att ("TRUELAT1", 30.0f);
+    file.add_att ("TRUELAT2", 60.0f);
+    file.add_att ("CEN_LAT", 50.0f);
+    file.add_att ("CEN_LON", 10.0f);
+    file.add_att ("DX", 1000.0f);
+    file.add_att ("DY", 1000.0f);
+
+    file.add_var ("field", ncFloat, time, southNorth, westEast);
+    file.add_var ("levels", ncFloat, time, level, southNorth, westEast);
+}
+
+static float value (size_t i, size_t j)
+{
+    return 10.0f*j + i;
+}
+
+BOOST_AUTO_TEST_CASE( isContiguous_test )
+{
+    Array2D field (boost::extents[jSize][iSize]);
+    BOOST_CHECK (wrf::isContiguous (2, field.shape (), field.strides ()));
+
+    Array2D::array_view<2>::type columns = field[boost::indices[range ()][range (0, iSize, 2)]];
+    BOOST_CHECK (!wrf::isContiguous (2, columns.shape (), columns.strides ()));
+
+    Array2D::array_view<2>::type row = field[boost::indices[range (1, 2)][range ()]];
+    BOOST_CHECK (wrf::isContiguous (2, row.shape (), row.strides ()));
+
+    Array2D transposed (boost::extents[jSize][iSize], boost::fortran_storage_order ());
+    BOOST_CHECK (!wrf::isContiguous (2, transposed.shape (), transposed.strides ()));
+}
+
+BOOST_AUTO_TEST_CASE( hyperslab_test )
+{
+    const std::string fileName = "wrf_test.nc";
+    createFile (fileName);
+    wrf::File file (fileName, NcFile::Write);
+    std::vector<size_t> start (3, 0);
+
+    // an array in C order goes in and out as it is //
+    //-----------------------------------------------//
+    Array2D field (boost::extents[jSize][iSize]);
+    for (size_t j = 0; j < jSize; ++j)
+        for (size_t i = 0; i < iSize; ++i)
+            field[j][i] = value (i, j);
+    file.write ("field", start, field);
+
+    Array2D result (boost::extents[jSize][iSize]);
+    file.read ("field", start, result);
+    BOOST_CHECK (result == field);
+
+    // a view of every second column of a wider array is filled //
+    //-----------------------------------------------------------//
+    Array2D wide (boost::extents[jSize][2*iSize]);
+    std::fill (wide.data (), wide.data () + wide.num_elements (), -1.0f);
+    Array2D::array_view<2>::type columns = wide[boost::indices[range ()][range (0, 2*iSize, 2)]];
+    file.read ("field", start, columns);
+    for (size_t j = 0; j < jSize; ++j)
+        for (size_t i = 0; i < iSize; ++i)
+        {
+            BOOST_CHECK_EQUAL (wide[j][2*i], value (i, j));
+            BOOST_CHECK_EQUAL (wide[j][2*i + 1], -1.0f);
+        }
+
+    // every second row and a transposed array are written by index //
+    //----------------------------------------------------------------//
+    Array2D tall (boost::extents[2*jSize][iSize]);
+    for (size_t j = 0; j < 2*jSize; ++j)
+        for (size_t i = 0; i < iSize; ++i)
+            tall[j][i] = value (i, j) + 100.0f;
+    Array2D::array_view<2>::type rows = tall[boost::indices[range (1, 2*jSize, 2)][range ()]];
+    file.write ("field", start, rows);
+    file.read ("field", start, result);
+    BOOST_CHECK (result == rows);
+
+    Array2D transposed (boost::extents[jSize][iSize], boost::fortran_storage_order ());
+    transposed = field;
+    file.write ("field", start, transposed);
+    file.read ("field", start, result);
+    BOOST_CHECK (result == field);
+
+    // a window of one level leaves the rest of the variable alone //
+    //--------------------------------------------------------------//
+    boost::multi_array<float, 3> levels (boost::extents[levelCount][jSize][iSize]);
+    std::fill (levels.data (), levels.data () + levels.num_elements (), 0.0f);
+    std::vector<size_t> levelStart (4, 0);
+    file.write ("levels", levelStart, levels);
+
+    Array2D window (boost::extents[2][3]);
+    for (size_t j = 0; j < 2; ++j)
+        for (size_t i = 0; i < 3; ++i)
+            window[j][i] = value (i, j) + 1.0f;
+    levelStart[1] = 1;
+    levelStart[2] = 1;
+    levelStart[3] = 2;
+    file.write ("levels", levelStart, window);
+
+    levelStart.assign (4, 0);
+    file.read ("levels", levelStart, levels);
+    for (size_t level = 0; level < levelCount; ++level)
+        for (size_t j = 0; j < jSize; ++j)
+            for (size_t i = 0; i < iSize; ++i)
+            {
+                const bool inside = level == 1 and j >= 1 and j < 3 and i >= 2 and i < 5;
+                BOOST_CHECK_EQUAL (levels[level][j][i],
+                        inside ? value (i - 2, j - 1) + 1.0f : 0.0f);
+            }
+
+    // the hyperslab must be within the variable //
+    //--------------------------------------------//
+    start[1] = 1;
+    BOOST_CHECK_THROW (file.write ("field", start, field), wrf::WrongDimensionSizeException);
+    BOOST_CHECK_THROW (file.read ("field", std::vector<size_t> (2, 0), result),
+            wrf::WrongDimensionSizeException);
+    BOOST_CHECK_THROW (file.read ("missing", start, result), wrf::VariableNotExistException);
+}